@@ -0,0 +1,33 @@
+#include <new>
+#include <cstdlib>
+#include "AllocCounter.hpp"
+
+static unsigned long allocationNum = 0;
+static unsigned long allocatedBytes = 0;
+
+void *operator new(size_t size) throw(std::bad_alloc) {
+    void *ptr;
+
+    ++allocationNum;
+    allocatedBytes += size;
+    if ((ptr = malloc(size ? size : 1)) == NULL) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) throw() {
+    free(ptr);
+}
+
+/**
+ * @brief Get the number of operator new calls so far.
+ */
+unsigned long AllocCounter::getCount(void) {
+    return allocationNum;
+}
+
+/**
+ * @brief Get the number of bytes asked from operator new so far.
+ */
+unsigned long AllocCounter::getBytes(void) {
+    return allocatedBytes;
+}
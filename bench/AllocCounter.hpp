@@ -0,0 +1,18 @@
+#pragma once
+
+#ifndef ALLOCCOUNTER_HPP
+# define ALLOCCOUNTER_HPP
+
+using namespace std;
+
+/**
+ * @brief Heap use of the whole program, counted by the global operator new
+ *  of AllocCounter.cpp. Linked into the benchmarks that report allocations
+ *  per operation; take the difference of two reads around a measured section.
+ */
+struct AllocCounter {
+    static unsigned long getCount(void);
+    static unsigned long getBytes(void);
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <sys/resource.h>
+
+#include "User.hpp"
+#include "Channel.hpp"
+#include "SlabPool.hpp"
+#include "Clock.hpp"
+#include "AllocCounter.hpp"
+
+using namespace std;
+
+/**
+ * @brief Allocation cost of connect/disconnect and JOIN/PART churn.
+ *  Keeps a fixed number of user slots; each step empties a random slot
+ *  (PART every channel, delete the user) or fills it (new user, JOIN a few
+ *  random channels). A channel is created on its first JOIN and deleted
+ *  when its last member leaves, like the server does.
+ *  Reports ns and heap allocations per step, peak RSS and the pool stats.
+ *  Run once as is and once with IRCSERV_NO_POOL=1 to compare with the heap.
+ *  usage : ./bench/churn_bench [steps] [slots] [channels]
+ */
+
+# define JOINS_PER_USER 3
+
+/**
+ * @brief Small deterministic generator, so that both runs do the same steps.
+ */
+static unsigned long nextRandom(unsigned long& state) {
+    state = state * 6364136223846793005UL + 1442695040888963407UL;
+    return state >> 33;
+}
+
+/**
+ * @brief Channels of the bench. Every live channel holds the anchor user
+ *  under key -1 as its first member, so the anchor stays channel operator
+ *  and leaving members never trigger a MODE broadcast (there is no reactor).
+ */
+struct ChannelSlots {
+    vector<Channel *> channels;
+    User *anchor;
+
+    Channel *join(size_t index, int key, User *user) {
+        if (channels[index] == NULL) {
+            char name[16];
+
+            snprintf(name, sizeof(name), "#ch%lu", static_cast<unsigned long>(index));
+            channels[index] = new Channel(name);
+            channels[index]->addUser(-1, anchor);
+        }
+        if (channels[index]->findUser(key) == NULL) {
+            channels[index]->addUser(key, user);
+            user->addToMyChannelList(channels[index]);
+        }
+        return channels[index];
+    }
+
+    void part(Channel *channel, int key, User *user) {
+        user->deleteFromMyChannelList(channel);
+        if (channel->deleteUser(key) > 1) return ;
+
+        channels[strtoul(channel->getName().c_str() + 3, NULL, 10)] = NULL;
+        channel->deleteUser(-1);
+        delete channel;
+    }
+};
+
+int main(int argc, char **argv) {
+    const size_t steps = (argc > 1) ? strtoul(argv[1], NULL, 10) : 2000000;
+    const size_t slotNum = (argc > 2) ? strtoul(argv[2], NULL, 10) : 10000;
+    const size_t channelNum = (argc > 3) ? strtoul(argv[3], NULL, 10) : 1000;
+    vector<User *> users(slotNum, static_cast<User *>(NULL));
+    ChannelSlots slots;
+    unsigned long state = 42;
+    size_t joins = 0;
+
+    slots.channels.assign(channelNum, NULL);
+    slots.anchor = new User(-1, "bench.host", NULL);
+    slots.anchor->setNickname("anchor");
+
+    const unsigned long allocationsBefore = AllocCounter::getCount();
+    const double start = Clock::nowNs();
+
+    for (size_t step = 0; step < steps; ++step) {
+        const size_t slot = nextRandom(state) % slotNum;
+        const int key = static_cast<int>(slot);
+
+        if (users[slot] != NULL) {
+            User *user = users[slot];
+
+            while (!user->getMyAllChannel().empty()) slots.part(user->getMyAllChannel().back(), key, user);
+            delete user;
+            users[slot] = NULL;
+            continue;
+        }
+        char nickname[16];
+
+        snprintf(nickname, sizeof(nickname), "u%lu", static_cast<unsigned long>(slot));
+        users[slot] = new User(-1, "bench.host", NULL);
+        users[slot]->setNickname(nickname);
+        for (int i = 0; i < JOINS_PER_USER; ++i, ++joins)
+            slots.join(nextRandom(state) % channelNum, key, users[slot]);
+    }
+
+    const double elapsed = Clock::nowNs() - start;
+    const unsigned long allocations = AllocCounter::getCount() - allocationsBefore;
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    cout << "mode          : " << (getenv("IRCSERV_NO_POOL") ? "heap (IRCSERV_NO_POOL)" : "slab pools") << endl
+         << "steps         : " << steps << " (" << joins << " joins)" << endl
+         << fixed << setprecision(1)
+         << "ns/step       : " << elapsed / steps << endl
+         << "allocs/step   : " << static_cast<double>(allocations) / steps << endl
+         << "max RSS (KiB) : " << usage.ru_maxrss << endl << endl;
+
+    const vector<SlabPool::Stats> allStats = SlabPool::getAllStats();
+
+    cout << setw(16) << "pool" << setw(8) << "block" << setw(8) << "chunks"
+         << setw(10) << "blocks" << setw(10) << "in use" << setw(10) << "peak" << endl;
+    for (size_t i = 0; i < allStats.size(); ++i) {
+        cout << setw(16) << allStats[i].name << setw(8) << allStats[i].blockSize << setw(8) << allStats[i].chunkNum
+             << setw(10) << allStats[i].blockNum << setw(10) << allStats[i].inUse << setw(10) << allStats[i].peakInUse << endl;
+    }
+
+    for (size_t slot = 0; slot < slotNum; ++slot) {
+        if (users[slot] == NULL) continue;
+        while (!users[slot]->getMyAllChannel().empty())
+            slots.part(users[slot]->getMyAllChannel().back(), static_cast<int>(slot), users[slot]);
+        delete users[slot];
+    }
+    delete slots.anchor;
+    return 0;
+}
@@ -0,0 +1,231 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "Poller.hpp"
+#include "CommonValue.hpp"
+#include "Clock.hpp"
+
+using namespace std;
+
+/**
+ * @brief Per-event cost of the server while the number of connected clients grows.
+ *  Registers idle clients in steps (100, 1k, 10k, 100k), and at each step a
+ *  fixed set of active clients runs PING/PONG round trips in a closed loop.
+ *  If an event costs the same regardless of the number of clients, round
+ *  trips per second stay flat from step to step.
+ *  Start the server with max_users above max_clients first.
+ *  usage : ./bench/conn_scale <port> <password> [max_clients] [active] [seconds]
+ */
+
+# define CLIENTS_PER_SOURCE_ADDR 20000
+
+struct Client {
+    int fd;
+    bool isRegistered;
+    double sentAt;
+};
+
+/**
+ * @brief Send a whole string on a blocking or non-blocking socket.
+ */
+static bool sendAll(int fd, const string& data) {
+    size_t sent = 0;
+
+    while (sent < data.size()) {
+        const ssize_t bytes = send(fd, data.data() + sent, data.size() - sent, 0);
+
+        if (bytes > 0) sent += bytes;
+        else if (bytes == ERR_RETURN && (errno == EINTR || errno == EAGAIN)) continue;
+        else return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Connect one client and send its registration.
+ *  On Linux, every CLIENTS_PER_SOURCE_ADDR clients use the next 127.0.0.x
+ *  source address, so that ephemeral ports do not run out.
+ *
+ * @return int : Connected socket. ERR_RETURN on failure.
+ */
+static int connectClient(const struct sockaddr_in& serverAddr, const string& password, size_t index) {
+    const int fd = socket(PF_INET, SOCK_STREAM, 0);
+    const int noDelay = 1;
+
+    if (fd == ERR_RETURN) return ERR_RETURN;
+#ifdef __linux__
+    struct sockaddr_in sourceAddr;
+
+    memset(&sourceAddr, 0, sizeof(sourceAddr));
+    sourceAddr.sin_family = AF_INET;
+    sourceAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 1 + index / CLIENTS_PER_SOURCE_ADDR);
+    if (serverAddr.sin_addr.s_addr == htonl(INADDR_LOOPBACK))
+        bind(fd, reinterpret_cast<const struct sockaddr *>(&sourceAddr), sizeof(sourceAddr));
+#endif
+    if (connect(fd, reinterpret_cast<const struct sockaddr *>(&serverAddr), sizeof(serverAddr)) == ERR_RETURN) {
+        close(fd);
+        return ERR_RETURN;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    char nickname[16];
+    snprintf(nickname, sizeof(nickname), "c%lu", static_cast<unsigned long>(index));
+    if (!sendAll(fd, "PASS " + password + "\r\nNICK " + nickname + "\r\nUSER " + nickname + " 0 * :bench\r\n")) {
+        close(fd);
+        return ERR_RETURN;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return fd;
+}
+
+/**
+ * @brief Read everything available. Count line feeds (one per reply line).
+ *
+ * @return long : Number of line feeds read. ERR_RETURN if the server closed the socket.
+ */
+static long drainSocket(int fd) {
+    char buf[16384];
+    long lines = 0;
+    ssize_t bytes;
+
+    while ((bytes = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        for (ssize_t i = 0; i < bytes; ++i) lines += (buf[i] == LF);
+    }
+    if (bytes == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) return ERR_RETURN;
+    return lines;
+}
+
+/**
+ * @brief Wait until every client got its welcome reply.
+ */
+static bool waitRegistered(Poller& poller, vector<Client>& clients, size_t from) {
+    PollEvent events[256];
+    size_t pending = clients.size() - from;
+    const double deadline = Clock::nowNs() + 30e9;
+
+    while (pending > 0 && Clock::nowNs() < deadline) {
+        const int numOfEvents = poller.wait(events, 256, 100);
+
+        for (int i = 0; i < numOfEvents; ++i) {
+            Client& client = clients[reinterpret_cast<size_t>(events[i].udata)];
+
+            if (drainSocket(client.fd) == ERR_RETURN) return false;
+            if (!client.isRegistered) {
+                client.isRegistered = true;
+                --pending;
+            }
+        }
+    }
+    return pending == 0;
+}
+
+/**
+ * @brief Run PING/PONG round trips on the first activeNum clients for some time.
+ *
+ * @return double : Round trips per second. Average latency is stored in latencyUs.
+ */
+static double measureRoundTrips(Poller& poller, vector<Client>& clients, size_t activeNum, double seconds, double& latencyUs) {
+    PollEvent events[256];
+    long roundTrips = 0;
+    double latencySum = 0;
+    const double start = Clock::nowNs();
+    const double end = start + seconds * 1e9;
+
+    for (size_t i = 0; i < activeNum; ++i) {
+        clients[i].sentAt = Clock::nowNs();
+        sendAll(clients[i].fd, "PING :bench\r\n");
+    }
+    while (Clock::nowNs() < end) {
+        const int numOfEvents = poller.wait(events, 256, 100);
+
+        for (int i = 0; i < numOfEvents; ++i) {
+            const size_t index = reinterpret_cast<size_t>(events[i].udata);
+            const long lines = drainSocket(clients[index].fd);
+
+            if (lines <= 0 || index >= activeNum) continue;
+            const double now = Clock::nowNs();
+
+            roundTrips += lines;
+            latencySum += (now - clients[index].sentAt) * lines;
+            clients[index].sentAt = now;
+            sendAll(clients[index].fd, "PING :bench\r\n");
+        }
+    }
+    latencyUs = roundTrips ? latencySum / roundTrips / 1e3 : 0;
+    // Let the last round trips finish, so the next step starts clean.
+    usleep(100000);
+    for (size_t i = 0; i < activeNum; ++i) drainSocket(clients[i].fd);
+    return roundTrips / ((Clock::nowNs() - start) / 1e9);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        cerr << "usage : " << argv[0] << " <port> <password> [max_clients] [active] [seconds]" << endl;
+        return 1;
+    }
+    const int port = atoi(argv[1]);
+    const string password = argv[2];
+    const size_t maxClients = (argc > 3) ? strtoul(argv[3], NULL, 10) : 100000;
+    const size_t activeNum = (argc > 4) ? strtoul(argv[4], NULL, 10) : 100;
+    const double seconds = (argc > 5) ? atof(argv[5]) : 2.0;
+    struct rlimit limit;
+    struct sockaddr_in serverAddr;
+    vector<Client> clients;
+    Poller *poller = Poller::create();
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    serverAddr.sin_port = htons(port);
+
+    cout << setw(10) << "clients" << setw(16) << "round trips/s" << setw(16) << "latency (us)" << endl;
+    for (size_t step = 100; step <= maxClients; step *= 10) {
+        const size_t from = clients.size();
+
+        while (clients.size() < step) {
+            Client client;
+
+            client.fd = connectClient(serverAddr, password, clients.size());
+            client.isRegistered = false;
+            client.sentAt = 0;
+            if (client.fd == ERR_RETURN) {
+                cerr << "connect failed at " << clients.size() << " clients: " << strerror(errno) << endl;
+                return 1;
+            }
+            poller->addFd(client.fd, reinterpret_cast<void *>(clients.size()), false);
+            clients.push_back(client);
+        }
+        if (!waitRegistered(*poller, clients, from)) {
+            cerr << "server closed or did not welcome some of " << step << " clients (check max_users)" << endl;
+            return 1;
+        }
+
+        double latencyUs;
+        const double rate = measureRoundTrips(*poller, clients, min(activeNum, clients.size()), seconds, latencyUs);
+
+        cout << setw(10) << clients.size() << fixed << setprecision(0) << setw(16) << rate
+             << setprecision(1) << setw(16) << latencyUs << endl;
+        if (step < maxClients && step * 10 > maxClients) step = maxClients / 10;
+    }
+    for (size_t i = 0; i < clients.size(); ++i) close(clients[i].fd);
+    delete poller;
+    return 0;
+}
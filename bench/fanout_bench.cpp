@@ -0,0 +1,341 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <csignal>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "Server.hpp"
+#include "ServerConfig.hpp"
+#include "Poller.hpp"
+#include "CommonValue.hpp"
+#include "Clock.hpp"
+
+using namespace std;
+
+/**
+ * @brief Channel fanout while the number of reactor threads grows.
+ *  For threads=1..max_threads, starts an in-process server on a free loopback
+ *  port, registers clients that all join one channel, and has them send
+ *  PRIVMSGs to it in turn at a fixed total rate (open loop: a message that
+ *  would block is dropped and counted). Each message reaches clients - 1
+ *  members, spread over the reactors by SO_REUSEPORT, so most deliveries
+ *  cross threads through the inbox. Every message carries its send time, so
+ *  receivers measure end-to-end latency.
+ *  If fanout scales, deliveries per second follow the rate and latency stays
+ *  flat or drops as threads are added, up to the number of free cores
+ *  (the clients run on one more thread).
+ *  usage : ./bench/fanout_bench [max_threads] [clients] [rate] [seconds]
+ */
+
+static const char *BENCH_PASSWORD = "bench";
+static const char *BENCH_CHANNEL = "#fanout";
+
+struct Client {
+    int fd;
+    string nickname;
+    string input;
+    bool isReady; // Registered and joined
+};
+
+struct Counters {
+    unsigned long sent;
+    unsigned long dropped;
+    unsigned long delivered;
+    vector<double> latenciesUs;
+
+    Counters(void): sent(0), dropped(0), delivered(0) { }
+};
+
+/**
+ * @brief Ask the kernel for a free port.
+ *
+ * @return int : Port number that was free a moment ago
+ */
+static int findFreePort(void) {
+    struct sockaddr_in addr;
+    socklen_t addrLength = sizeof(addr);
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    getsockname(fd, (struct sockaddr*)&addr, &addrLength);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+static void *serverMain(void *arg) {
+    static_cast<Server *>(arg)->run();
+    return NULL;
+}
+
+/**
+ * @brief Send a whole string, waiting while the socket is full.
+ *  Used for registration and joins, which must not be lost.
+ */
+static bool sendAll(int fd, const string& data) {
+    size_t sent = 0;
+
+    while (sent < data.size()) {
+        const ssize_t bytes = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+
+        if (bytes > 0) sent += bytes;
+        else if (bytes == ERR_RETURN && (errno == EINTR || errno == EAGAIN)) continue;
+        else return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Send a message if the socket takes all of it at once.
+ *
+ * @return true : Sent / if not return
+ * @return false : Socket full, message dropped
+ */
+static bool trySend(int fd, const string& data) {
+    const ssize_t bytes = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+
+    if (bytes == static_cast<ssize_t>(data.size())) return true;
+    // A partial line would corrupt the next one: finish it.
+    if (bytes > 0) return sendAll(fd, data.substr(bytes));
+    return false;
+}
+
+/**
+ * @brief Connect one client and send its registration and JOIN.
+ *
+ * @return int : Connected non-blocking socket. ERR_RETURN on failure.
+ */
+static int connectClient(int port, const Client& client) {
+    struct sockaddr_in serverAddr;
+    const int fd = socket(PF_INET, SOCK_STREAM, 0);
+    const int noDelay = 1;
+
+    if (fd == ERR_RETURN) return ERR_RETURN;
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    serverAddr.sin_port = htons(port);
+    if (connect(fd, reinterpret_cast<const struct sockaddr *>(&serverAddr), sizeof(serverAddr)) == ERR_RETURN) {
+        close(fd);
+        return ERR_RETURN;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    if (!sendAll(fd, string("PASS ") + BENCH_PASSWORD + "\r\nNICK " + client.nickname + "\r\nUSER " + client.nickname
+                     + " 0 * :fanout\r\nJOIN " + BENCH_CHANNEL + "\r\n")) {
+        close(fd);
+        return ERR_RETURN;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return fd;
+}
+
+/**
+ * @brief Handle one line received by a client.
+ *  A relayed PRIVMSG counts as one delivery, and its embedded send time
+ *  gives a latency sample. RPL_ENDOFNAMES makes the client ready.
+ */
+static void handleLine(Client& client, const char *line, size_t length, Counters& counters, double now) {
+    const string text(line, length);
+    const size_t stampPos = text.find(" :t=");
+
+    if (stampPos != string::npos && text.find(" PRIVMSG ") != string::npos) {
+        ++counters.delivered;
+        counters.latenciesUs.push_back((now - strtod(text.c_str() + stampPos + 4, NULL)) / 1e3);
+        return ;
+    }
+    if (text.find(" 366 ") != string::npos) client.isReady = true;
+}
+
+/**
+ * @brief Read everything available and handle the complete lines.
+ *
+ * @return bool : false if the server closed the socket.
+ */
+static bool drainClient(Client& client, Counters& counters) {
+    char buf[16384];
+    ssize_t bytes;
+
+    while ((bytes = recv(client.fd, buf, sizeof(buf), 0)) > 0) {
+        const double now = Clock::nowNs();
+        size_t lineBegin = 0;
+
+        client.input.append(buf, bytes);
+        for (size_t i = 0; i < client.input.size(); ++i) {
+            if (client.input[i] != LF) continue;
+            handleLine(client, client.input.data() + lineBegin, i - lineBegin, counters, now);
+            lineBegin = i + 1;
+        }
+        client.input.erase(0, lineBegin);
+    }
+    return !(bytes == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR));
+}
+
+/**
+ * @brief Handle the readable clients of one poller wait.
+ *
+ * @return bool : false if the server closed a client.
+ */
+static bool pollClients(Poller& poller, vector<Client>& clients, Counters& counters, int timeoutMs) {
+    PollEvent events[256];
+    const int numOfEvents = poller.wait(events, 256, timeoutMs);
+
+    for (int i = 0; i < numOfEvents; ++i) {
+        if (!drainClient(clients[reinterpret_cast<size_t>(events[i].udata)], counters)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Connect the clients, and wait until every one joined the channel.
+ */
+static bool setUpClients(Poller& poller, vector<Client>& clients, int port) {
+    Counters counters;
+    size_t readyNum = 0;
+    const double deadline = Clock::nowNs() + 30e9;
+
+    for (size_t i = 0; i < clients.size(); ++i) {
+        if ((clients[i].fd = connectClient(port, clients[i])) == ERR_RETURN) {
+            cerr << "connect failed at " << i << " clients: " << strerror(errno) << endl;
+            return false;
+        }
+        poller.addFd(clients[i].fd, reinterpret_cast<void *>(i), false);
+        if (!pollClients(poller, clients, counters, 0)) return false;
+    }
+    while (readyNum < clients.size() && Clock::nowNs() < deadline) {
+        if (!pollClients(poller, clients, counters, 100)) return false;
+        readyNum = 0;
+        for (size_t i = 0; i < clients.size(); ++i) readyNum += clients[i].isReady;
+    }
+    return readyNum == clients.size();
+}
+
+/**
+ * @brief Send PRIVMSGs to the channel at the total rate for the duration,
+ *  from the clients in turn, and receive the deliveries.
+ */
+static void driveFanout(Poller& poller, vector<Client>& clients, double rate, double seconds, Counters& counters) {
+    const double start = Clock::nowNs();
+    const double end = start + seconds * 1e9;
+    size_t sender = 0;
+    char stamp[32];
+
+    while (Clock::nowNs() < end) {
+        const unsigned long due = static_cast<unsigned long>((Clock::nowNs() - start) / 1e9 * rate);
+
+        while (counters.sent + counters.dropped < due) {
+            snprintf(stamp, sizeof(stamp), "%ld", Clock::nowNs());
+            if (trySend(clients[sender].fd, string("PRIVMSG ") + BENCH_CHANNEL + " :t=" + stamp + "\r\n")) ++counters.sent;
+            else ++counters.dropped;
+            sender = (sender + 1) % clients.size();
+        }
+        if (!pollClients(poller, clients, counters, 1)) {
+            cerr << "server closed a client" << endl;
+            break;
+        }
+    }
+    // Let the messages in flight arrive.
+    const double drainEnd = Clock::nowNs() + 0.5e9;
+
+    while (Clock::nowNs() < drainEnd) pollClients(poller, clients, counters, 10);
+}
+
+/**
+ * @brief Get a percentile of the latency samples. Reorders the samples.
+ */
+static double percentile(vector<double>& samples, double ratio) {
+    if (samples.empty()) return 0;
+
+    const size_t index = min(samples.size() - 1, static_cast<size_t>(samples.size() * ratio));
+
+    nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+/**
+ * @brief Run the fanout against a fresh server with a number of reactors, and print its row.
+ *
+ * @return bool : false if the clients could not be set up.
+ */
+static bool runWithThreads(int threadNum, size_t clientNum, double rate, double seconds) {
+    ServerConfig config;
+    pthread_t serverThread;
+
+    config.port = findFreePort();
+    config.password = BENCH_PASSWORD;
+    config.reactorNum = threadNum;
+    config.maxUsers = clientNum + 16;
+    config.floodRate = MAX_FLOOD_LIMIT;
+    config.floodBurst = MAX_FLOOD_LIMIT;
+    config.sendQ = MAX_SENDQ_LIMIT;
+
+    // Stopped below, but never deleted: its reactors are only freed on shutdown.
+    Server *server = new Server(config);
+    vector<Client> clients(clientNum);
+    Poller *poller = Poller::create();
+    Counters counters;
+
+    pthread_create(&serverThread, NULL, serverMain, server);
+    for (size_t i = 0; i < clients.size(); ++i) {
+        char name[16];
+
+        snprintf(name, sizeof(name), "f%lu", static_cast<unsigned long>(i));
+        clients[i].nickname = name;
+        clients[i].fd = UNDEFINED_FD;
+        clients[i].isReady = false;
+    }
+
+    const bool isSetUp = setUpClients(*poller, clients, config.port);
+
+    if (isSetUp) {
+        driveFanout(*poller, clients, rate, seconds, counters);
+        cout << setw(8) << threadNum << fixed << setprecision(0)
+             << setw(12) << counters.sent / seconds << setw(12) << counters.dropped / seconds
+             << setw(14) << counters.delivered / seconds
+             << setprecision(1) << setw(10) << percentile(counters.latenciesUs, 0.5)
+             << setw(10) << percentile(counters.latenciesUs, 0.99) << setw(10) << percentile(counters.latenciesUs, 0.999) << endl;
+    } else cerr << "threads=" << threadNum << ": server closed or did not welcome some clients" << endl;
+
+    for (size_t i = 0; i < clients.size(); ++i) {
+        if (clients[i].fd != UNDEFINED_FD) close(clients[i].fd);
+    }
+    delete poller;
+    server->stopReactors();
+    pthread_join(serverThread, NULL);
+    return isSetUp;
+}
+
+int main(int argc, char **argv) {
+    const int maxThreadNum = (argc > 1) ? atoi(argv[1]) : 4;
+    const size_t clientNum = (argc > 2) ? strtoul(argv[2], NULL, 10) : 200;
+    const double rate = (argc > 3) ? atof(argv[3]) : 2000;
+    const double seconds = (argc > 4) ? atof(argv[4]) : 3;
+
+    if (maxThreadNum < 1 || maxThreadNum > MAX_REACTOR_NUM || clientNum < 2 || rate <= 0 || seconds <= 0) {
+        cerr << "usage : " << argv[0] << " [max_threads] [clients >= 2] [rate] [seconds]" << endl;
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    cout << "clients : " << clientNum << " in " << BENCH_CHANNEL << " (fanout " << clientNum - 1 << "), rate : "
+         << rate << " msg/s, " << seconds << " s per run, cores : " << sysconf(_SC_NPROCESSORS_ONLN) << endl << endl
+         << setw(8) << "threads" << setw(12) << "sent/s" << setw(12) << "dropped/s" << setw(14) << "delivered/s"
+         << setw(10) << "p50 us" << setw(10) << "p99 us" << setw(10) << "p999 us" << endl;
+    for (int threadNum = 1; threadNum <= maxThreadNum; ++threadNum) {
+        if (!runWithThreads(threadNum, clientNum, rate, seconds)) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,266 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+
+#include "Server.hpp"
+#include "User.hpp"
+#include "Channel.hpp"
+#include "Message.hpp"
+#include "FormatValidator.hpp"
+#include "SharedBuffer.hpp"
+#include "Clock.hpp"
+#include "AllocCounter.hpp"
+
+using namespace std;
+
+/**
+ * @brief Cost of the per-message hot paths, without sockets: Message parsing,
+ *  Message::split, reply building, Command::run dispatch, nickname validation
+ *  and Channel::broadcast. Inputs are the lines of a corpus of raw client
+ *  messages, one per line. The default, bench/corpus.irc, is synthetic: a
+ *  hand-written client session with the usual mix of channel and private
+ *  messages, NOTICE, JOIN/PART/NICK, unknown commands and error paths.
+ *  Recorded sessions hold private messages and PASS lines, so none is
+ *  shipped; pass one as corpus to replay real traffic.
+ *  Command::run replays the corpus, QUIT lines excepted, as registered user
+ *  "alice" in #general with channel_size members, nicknames bob and carol
+ *  among them. Replies pile up in the users' queues and are dropped
+ *  between passes, outside the measurement. Users have no reactor, and the
+ *  server's reactor only has its listening socket (on port 0): nothing is sent.
+ *  Reports ns, heap allocations and heap bytes per operation.
+ *  usage : ./bench/hot_path_bench [corpus] [ops] [channel_size]
+ */
+
+# define BENCH_FD_BASE 1000
+
+/**
+ * @brief Accumulates time and heap use of the measured sections of one benchmark.
+ */
+struct Meter {
+    double elapsed;
+    unsigned long allocations;
+    unsigned long bytes;
+    unsigned long ops;
+    double startedAt;
+    unsigned long allocationsAtStart;
+    unsigned long bytesAtStart;
+
+    Meter(void): elapsed(0), allocations(0), bytes(0), ops(0), startedAt(0), allocationsAtStart(0), bytesAtStart(0) { }
+
+    void start(void) {
+        allocationsAtStart = AllocCounter::getCount();
+        bytesAtStart = AllocCounter::getBytes();
+        startedAt = Clock::nowNs();
+    }
+
+    void stop(unsigned long opNum) {
+        elapsed += Clock::nowNs() - startedAt;
+        allocations += AllocCounter::getCount() - allocationsAtStart;
+        bytes += AllocCounter::getBytes() - bytesAtStart;
+        ops += opNum;
+    }
+};
+
+// Keeps the results of the measured calls alive, so they are not optimized out.
+static volatile size_t sink = 0;
+
+/**
+ * @brief Print the results of one benchmark as a table row.
+ */
+static void printRow(ostream& out, const string& name, const Meter& meter) {
+    const double ops = meter.ops ? meter.ops : 1;
+
+    out << setw(28) << name << setw(12) << meter.ops << fixed << setprecision(1)
+         << setw(10) << meter.elapsed / ops << setw(10) << meter.allocations / ops
+         << setw(10) << meter.bytes / ops << endl;
+}
+
+/**
+ * @brief Read the corpus lines, without line endings. Empty lines are skipped.
+ */
+static bool readCorpus(const char *path, vector<string>& lines) {
+    ifstream file(path);
+    string line;
+
+    if (!file.is_open()) return false;
+    while (getline(file, line)) {
+        if (!line.empty() && line[line.size() - 1] == CR) line.erase(line.size() - 1);
+        if (!line.empty()) lines.push_back(line);
+    }
+    return !lines.empty();
+}
+
+/**
+ * @brief Create a registered user known to the server.
+ */
+static User *addUser(Server& server, int fd, const string& nickname) {
+    User *user = new User(fd, "bench.host", NULL);
+
+    server.reserveClient();
+    server.renameClient(user, nickname);
+    user->setUsername(nickname);
+    user->setAuth();
+    return user;
+}
+
+/**
+ * @brief Drop the replies queued during a pass.
+ */
+static void clearReplies(const vector<User *>& users) {
+    for (size_t i = 0; i < users.size(); ++i) users[i]->clearReplyBuffer();
+}
+
+int main(int argc, char **argv) {
+    const char *corpusPath = (argc > 1) ? argv[1] : "bench/corpus.irc";
+    const size_t targetOps = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1000000;
+    const size_t channelSize = (argc > 3) ? strtoul(argv[3], NULL, 10) : 50;
+    vector<string> lines;
+
+    if (!readCorpus(corpusPath, lines) || channelSize < 3) {
+        cerr << "usage : " << argv[0] << " [corpus] [ops] [channel_size >= 3]" << endl;
+        return 1;
+    }
+    const size_t passNum = targetOps / lines.size() + 1;
+
+    // Inputs of split() and isValidNickname(), taken from the corpus.
+    vector<string> splitInputs;
+    vector<string> nicknames;
+
+    for (size_t i = 0; i < lines.size(); ++i) {
+        const Message msg(lines[i].data(), lines[i].size());
+
+        if (msg.paramSize() == 0) continue;
+
+        const string first = msg.getParams()[0];
+
+        splitInputs.push_back(first);
+        if (msg.getCommand() == "NICK") nicknames.push_back(first);
+        if (msg.getCommand() == "PRIVMSG" || msg.getCommand() == "NOTICE") {
+            const vector<string> targets = Message::split(first, ',');
+
+            for (size_t j = 0; j < targets.size(); ++j) {
+                if (targets[j][0] != '#') nicknames.push_back(targets[j]);
+            }
+        }
+    }
+
+    ServerConfig config;
+
+    config.port = 0;
+    config.password = "bench";
+    config.maxUsers = BENCH_FD_BASE + channelSize + 1;
+    config.maxChannels = 1000;
+
+    Server server(config);
+    vector<User *> users;
+    Channel *general = server.addChannel("#general");
+    const char *fixedNicknames[] = { "alice", "bob", "carol" };
+
+    for (size_t i = 0; i < channelSize; ++i) {
+        char nickname[16];
+
+        snprintf(nickname, sizeof(nickname), "user%lu", static_cast<unsigned long>(i));
+        users.push_back(addUser(server, BENCH_FD_BASE + i, i < 3 ? fixedNicknames[i] : nickname));
+        general->addUser(users[i]->getFd(), users[i]);
+        users[i]->addToMyChannelList(general);
+    }
+    User *alice = users[0];
+
+    cout << "corpus : " << corpusPath << " (" << lines.size() << " lines), "
+         << "channel_size : " << channelSize << endl << endl
+         << setw(28) << "benchmark" << setw(12) << "ops" << setw(10) << "ns/op"
+         << setw(10) << "allocs/op" << setw(10) << "bytes/op" << endl;
+
+    Meter parseMeter;
+
+    parseMeter.start();
+    for (size_t pass = 0; pass < passNum; ++pass) {
+        for (size_t i = 0; i < lines.size(); ++i) {
+            const Message msg(lines[i].data(), lines[i].size());
+
+            sink += msg.paramSize();
+        }
+    }
+    parseMeter.stop(passNum * lines.size());
+    printRow(cout, "Message(line) parse", parseMeter);
+
+    Meter splitMeter;
+
+    splitMeter.start();
+    for (size_t pass = 0; pass < passNum; ++pass) {
+        for (size_t i = 0; i < splitInputs.size(); ++i) sink += Message::split(splitInputs[i], ',').size();
+    }
+    splitMeter.stop(passNum * splitInputs.size());
+    printRow(cout, "Message::split", splitMeter);
+
+    Meter replyMeter;
+    unsigned long replyNum = 0;
+
+    // Lines with fewer than 2 params make no reply and are not counted.
+    for (size_t i = 0; i < lines.size(); ++i) replyNum += Message(lines[i].data(), lines[i].size()).paramSize() >= 2;
+    replyMeter.start();
+    for (size_t pass = 0; pass < passNum; ++pass) {
+        for (size_t i = 0; i < lines.size(); ++i) {
+            const Message msg(lines[i].data(), lines[i].size());
+
+            if (msg.paramSize() < 2) continue;
+            sink += (Message() << alice->getPrefix() << msg.getCommand() << msg.getParams()[0] << ":"
+                               << msg.getParams()[1]).createReplyForm().size();
+        }
+    }
+    replyMeter.stop(passNum * replyNum);
+    printRow(cout, "reply << + createReplyForm", replyMeter);
+
+    Meter validateMeter;
+
+    validateMeter.start();
+    for (size_t pass = 0; pass < passNum; ++pass) {
+        for (size_t i = 0; i < nicknames.size(); ++i) sink += FormatValidator::isValidNickname(nicknames[i]);
+    }
+    validateMeter.stop(passNum * nicknames.size());
+    printRow(cout, "isValidNickname", validateMeter);
+
+    Meter commandMeter;
+
+    for (size_t pass = 0; pass < passNum; ++pass) {
+        unsigned long runNum = 0;
+
+        commandMeter.start();
+        for (size_t i = 0; i < lines.size(); ++i) {
+            const Message msg(lines[i].data(), lines[i].size());
+
+            if (msg.getCommand() == "QUIT") continue;
+            server.executeCommand(alice, msg);
+            ++runNum;
+        }
+        commandMeter.stop(runNum);
+        clearReplies(users);
+    }
+    printRow(cout, "Command::run (parse + run)", commandMeter);
+
+    Meter broadcastMsgMeter;
+    Meter broadcastBufferMeter;
+
+    for (size_t pass = 0; pass < passNum; ++pass) {
+        broadcastMsgMeter.start();
+        for (size_t i = 0; i < lines.size(); ++i)
+            general->broadcast(Message() << alice->getPrefix() << "PRIVMSG" << "#general" << ":" << lines[i], alice->getFd());
+        broadcastMsgMeter.stop(lines.size());
+        clearReplies(users);
+
+        broadcastBufferMeter.start();
+        for (size_t i = 0; i < lines.size(); ++i) general->broadcast(SharedBuffer(lines[i]), alice->getFd());
+        broadcastBufferMeter.stop(lines.size());
+        clearReplies(users);
+    }
+    printRow(cout, "Channel::broadcast(Message)", broadcastMsgMeter);
+    printRow(cout, "Channel::broadcast(Shared)", broadcastBufferMeter);
+    cout << endl << "broadcasts deliver to " << channelSize - 1 << " members each ("
+          << fixed << setprecision(1) << broadcastMsgMeter.elapsed / (broadcastMsgMeter.ops * (channelSize - 1))
+          << " ns per delivery)" << endl;
+    return 0;
+}
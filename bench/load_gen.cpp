@@ -0,0 +1,454 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "Poller.hpp"
+#include "CommonValue.hpp"
+#include "Clock.hpp"
+
+using namespace std;
+
+/**
+ * @brief End-to-end load generator. Opens loopback clients, registers them,
+ *  joins a channel topology and drives traffic at a fixed total rate
+ *  (open loop: a message that would block is dropped and counted, so a
+ *  slow server shows up as drops and latency instead of a slower generator).
+ *  Every message carries its send time, so receivers measure end-to-end latency.
+ *  Scenarios:
+ *   huge  : every client in one channel, PRIVMSG to it (fanout clients - 1)
+ *   small : channels of channel_size clients, PRIVMSG and NOTICE to them
+ *   dm    : PRIVMSG and NOTICE between random pairs of clients
+ *   storm : clients connect, register, JOIN, PART and QUIT in a loop
+ *  Start the server with max_users above clients, and flood_rate, flood_burst
+ *  and sendq high enough not to throttle or evict the generator.
+ *  usage : ./bench/load_gen <port> <password> <huge|small|dm|storm|all>
+ *          [clients=<n>] [rate=<n>] [seconds=<n>] [channel_size=<n>]
+ */
+
+# define CLIENTS_PER_SOURCE_ADDR 20000
+# define STORM_CHANNEL_NUM 16
+
+struct Options {
+    size_t clientNum;
+    double rate; // Messages per second, all clients together
+    double seconds;
+    size_t channelSize;
+};
+
+struct Client {
+    int fd;
+    string nickname;
+    string channel;
+    string input;
+    bool isReady; // Registered and joined
+    double startedAt; // Storm: connect time of the current cycle
+};
+
+struct Counters {
+    unsigned long sent;
+    unsigned long dropped;
+    unsigned long delivered;
+    unsigned long cycles;
+    vector<double> latenciesUs;
+
+    Counters(void): sent(0), dropped(0), delivered(0), cycles(0) { }
+};
+
+/**
+ * @brief Small deterministic generator, so that runs pick the same targets.
+ */
+static unsigned long nextRandom(unsigned long& state) {
+    state = state * 6364136223846793005UL + 1442695040888963407UL;
+    return state >> 33;
+}
+
+/**
+ * @brief Send a whole string, waiting while the socket is full.
+ *  Used for registration and joins, which must not be lost.
+ */
+static bool sendAll(int fd, const string& data) {
+    size_t sent = 0;
+
+    while (sent < data.size()) {
+        const ssize_t bytes = send(fd, data.data() + sent, data.size() - sent, 0);
+
+        if (bytes > 0) sent += bytes;
+        else if (bytes == ERR_RETURN && (errno == EINTR || errno == EAGAIN)) continue;
+        else return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Send a message if the socket takes all of it at once.
+ *
+ * @return true : Sent / if not return
+ * @return false : Socket full, message dropped
+ */
+static bool trySend(int fd, const string& data) {
+    const ssize_t bytes = send(fd, data.data(), data.size(), 0);
+
+    if (bytes == static_cast<ssize_t>(data.size())) return true;
+    // A partial line would corrupt the next one: finish it.
+    if (bytes > 0) return sendAll(fd, data.substr(bytes));
+    return false;
+}
+
+/**
+ * @brief Connect one client and send its registration, followed by a JOIN if it has a channel.
+ *  On Linux, every CLIENTS_PER_SOURCE_ADDR clients use the next 127.0.0.x
+ *  source address, so that ephemeral ports do not run out.
+ *
+ * @return int : Connected non-blocking socket. ERR_RETURN on failure.
+ */
+static int connectClient(const struct sockaddr_in& serverAddr, const string& password, const Client& client, size_t index) {
+    const int fd = socket(PF_INET, SOCK_STREAM, 0);
+    const int noDelay = 1;
+
+    if (fd == ERR_RETURN) return ERR_RETURN;
+#ifdef __linux__
+    struct sockaddr_in sourceAddr;
+
+    memset(&sourceAddr, 0, sizeof(sourceAddr));
+    sourceAddr.sin_family = AF_INET;
+    sourceAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 1 + index / CLIENTS_PER_SOURCE_ADDR);
+    if (serverAddr.sin_addr.s_addr == htonl(INADDR_LOOPBACK))
+        bind(fd, reinterpret_cast<const struct sockaddr *>(&sourceAddr), sizeof(sourceAddr));
+#endif
+    if (connect(fd, reinterpret_cast<const struct sockaddr *>(&serverAddr), sizeof(serverAddr)) == ERR_RETURN) {
+        close(fd);
+        return ERR_RETURN;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    string registration = "PASS " + password + "\r\nNICK " + client.nickname + "\r\nUSER " + client.nickname + " 0 * :load\r\n";
+
+    if (!client.channel.empty()) registration += "JOIN " + client.channel + "\r\n";
+    if (!sendAll(fd, registration)) {
+        close(fd);
+        return ERR_RETURN;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return fd;
+}
+
+/**
+ * @brief Handle one line received by a client.
+ *  A relayed PRIVMSG/NOTICE counts as one delivery, and its embedded send time
+ *  gives a latency sample. RPL_ENDOFNAMES (or RPL_WELCOME without a channel) makes the client ready.
+ */
+static void handleLine(Client& client, const char *line, size_t length, Counters& counters, double now) {
+    const string text(line, length);
+    const size_t stampPos = text.find(" :t=");
+
+    if (stampPos != string::npos && (text.find(" PRIVMSG ") != string::npos || text.find(" NOTICE ") != string::npos)) {
+        ++counters.delivered;
+        counters.latenciesUs.push_back((now - strtod(text.c_str() + stampPos + 4, NULL)) / 1e3);
+        return ;
+    }
+    if (text.find(" 366 ") != string::npos || (client.channel.empty() && text.find(" 001 ") != string::npos))
+        client.isReady = true;
+}
+
+/**
+ * @brief Read everything available and handle the complete lines.
+ *
+ * @return bool : false if the server closed the socket.
+ */
+static bool drainClient(Client& client, Counters& counters) {
+    char buf[16384];
+    ssize_t bytes;
+
+    while ((bytes = recv(client.fd, buf, sizeof(buf), 0)) > 0) {
+        const double now = Clock::nowNs();
+        size_t lineBegin = 0;
+
+        client.input.append(buf, bytes);
+        for (size_t i = 0; i < client.input.size(); ++i) {
+            if (client.input[i] != LF) continue;
+            handleLine(client, client.input.data() + lineBegin, i - lineBegin, counters, now);
+            lineBegin = i + 1;
+        }
+        client.input.erase(0, lineBegin);
+    }
+    return !(bytes == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR));
+}
+
+/**
+ * @brief Handle the readable clients of one poller wait.
+ *
+ * @return bool : false if the server closed a client.
+ */
+static bool pollClients(Poller& poller, vector<Client>& clients, Counters& counters, int timeoutMs) {
+    PollEvent events[256];
+    const int numOfEvents = poller.wait(events, 256, timeoutMs);
+
+    for (int i = 0; i < numOfEvents; ++i) {
+        if (!drainClient(clients[reinterpret_cast<size_t>(events[i].udata)], counters)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Connect and register the clients, with their JOINs, and wait until every one is ready.
+ */
+static bool setUpClients(Poller& poller, vector<Client>& clients, const struct sockaddr_in& serverAddr, const string& password) {
+    Counters counters;
+    size_t readyNum = 0;
+    const double deadline = Clock::nowNs() + 60e9;
+
+    for (size_t i = 0; i < clients.size(); ++i) {
+        if ((clients[i].fd = connectClient(serverAddr, password, clients[i], i)) == ERR_RETURN) {
+            cerr << "connect failed at " << i << " clients: " << strerror(errno) << endl;
+            return false;
+        }
+        poller.addFd(clients[i].fd, reinterpret_cast<void *>(i), false);
+        // Keep the server's replies from piling up while connecting many clients.
+        if (i % 256 == 255 && !pollClients(poller, clients, counters, 0)) return false;
+    }
+    while (readyNum < clients.size() && Clock::nowNs() < deadline) {
+        if (!pollClients(poller, clients, counters, 100)) return false;
+        readyNum = 0;
+        for (size_t i = 0; i < clients.size(); ++i) readyNum += clients[i].isReady;
+    }
+    return readyNum == clients.size();
+}
+
+/**
+ * @brief Send messages at the total rate for the duration, spread over the
+ *  clients in turn, and receive the deliveries.
+ *
+ * @param fanout Clients that receive each message
+ * @param isMixed Alternate PRIVMSG and NOTICE
+ * @param isDirect Address a random other client instead of the sender's channel
+ */
+static void driveTraffic(Poller& poller, vector<Client>& clients, const Options& options, bool isMixed, bool isDirect,
+                         Counters& counters) {
+    const double start = Clock::nowNs();
+    const double end = start + options.seconds * 1e9;
+    unsigned long randomState = 42;
+    size_t sender = 0;
+    char stamp[32];
+
+    while (Clock::nowNs() < end) {
+        const unsigned long due = static_cast<unsigned long>((Clock::nowNs() - start) / 1e9 * options.rate);
+
+        while (counters.sent + counters.dropped < due) {
+            Client& client = clients[sender];
+            const bool isNotice = isMixed && ((counters.sent + counters.dropped) & 1);
+            const string& target = isDirect ? clients[(sender + 1 + nextRandom(randomState) % (clients.size() - 1)) % clients.size()].nickname
+                                            : client.channel;
+
+            snprintf(stamp, sizeof(stamp), "%ld", Clock::nowNs());
+            if (trySend(client.fd, string(isNotice ? "NOTICE " : "PRIVMSG ") + target + " :t=" + stamp + "\r\n")) ++counters.sent;
+            else ++counters.dropped;
+            sender = (sender + 1) % clients.size();
+        }
+        if (!pollClients(poller, clients, counters, 1)) {
+            cerr << "server closed a client (check flood_rate, flood_burst and sendq)" << endl;
+            break;
+        }
+    }
+    // Let the messages in flight arrive.
+    const double drainEnd = Clock::nowNs() + 0.5e9;
+
+    while (Clock::nowNs() < drainEnd) pollClients(poller, clients, counters, 10);
+}
+
+/**
+ * @brief Reconnect storm: every client loops on connect, register, JOIN, PART and QUIT.
+ *  A cycle's latency is from connect() to RPL_ENDOFNAMES.
+ */
+static void driveStorm(Poller& poller, vector<Client>& clients, const struct sockaddr_in& serverAddr,
+                       const string& password, const Options& options, Counters& counters) {
+    PollEvent events[256];
+    const double end = Clock::nowNs() + options.seconds * 1e9;
+
+    for (size_t i = 0; i < clients.size(); ++i) {
+        clients[i].startedAt = Clock::nowNs();
+        if ((clients[i].fd = connectClient(serverAddr, password, clients[i], i)) == ERR_RETURN) {
+            cerr << "connect failed: " << strerror(errno) << endl;
+            return ;
+        }
+        poller.addFd(clients[i].fd, reinterpret_cast<void *>(i), false);
+    }
+    while (Clock::nowNs() < end) {
+        const int numOfEvents = poller.wait(events, 256, 100);
+
+        for (int i = 0; i < numOfEvents; ++i) {
+            const size_t index = reinterpret_cast<size_t>(events[i].udata);
+            Client& client = clients[index];
+            const bool wasReady = client.isReady;
+
+            if (drainClient(client, counters)) {
+                if (!wasReady && client.isReady) {
+                    counters.latenciesUs.push_back((Clock::nowNs() - client.startedAt) / 1e3);
+                    sendAll(client.fd, "PART " + client.channel + "\r\nQUIT\r\n");
+                }
+                continue;
+            }
+            // Closed by the server after QUIT: start the next cycle.
+            poller.removeFd(client.fd);
+            close(client.fd);
+            if (client.isReady) ++counters.cycles;
+            client.isReady = false;
+            client.input.clear();
+            client.startedAt = Clock::nowNs();
+            if ((client.fd = connectClient(serverAddr, password, client, index)) == ERR_RETURN) {
+                cerr << "reconnect failed: " << strerror(errno) << endl;
+                return ;
+            }
+            poller.addFd(client.fd, reinterpret_cast<void *>(index), false);
+        }
+    }
+}
+
+/**
+ * @brief Get a percentile of the latency samples. Reorders the samples.
+ */
+static double percentile(vector<double>& samples, double ratio) {
+    if (samples.empty()) return 0;
+
+    const size_t index = min(samples.size() - 1, static_cast<size_t>(samples.size() * ratio));
+
+    nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+/**
+ * @brief Print the results of one scenario as a table row.
+ */
+static void printRow(const string& scenario, Counters& counters, double seconds) {
+    cout << setw(8) << scenario << fixed << setprecision(0)
+         << setw(12) << counters.sent / seconds << setw(12) << counters.dropped / seconds
+         << setw(14) << (scenario == "storm" ? counters.cycles : counters.delivered) / seconds
+         << setprecision(1) << setw(10) << percentile(counters.latenciesUs, 0.5)
+         << setw(10) << percentile(counters.latenciesUs, 0.99) << setw(10) << percentile(counters.latenciesUs, 0.999) << endl;
+}
+
+/**
+ * @brief Run one scenario with fresh clients, and close them afterwards.
+ *
+ * @return bool : false if the clients could not be set up.
+ */
+static bool runScenario(const string& scenario, const struct sockaddr_in& serverAddr, const string& password,
+                        const Options& options) {
+    vector<Client> clients(options.clientNum);
+    Poller *poller = Poller::create();
+    Counters counters;
+    bool isSetUp = true;
+
+    for (size_t i = 0; i < clients.size(); ++i) {
+        char name[32];
+
+        // The nickname limit is 9 characters: scenario letter and index.
+        snprintf(name, sizeof(name), "%c%lu", scenario[0], static_cast<unsigned long>(i));
+        clients[i].nickname = name;
+        if (scenario == "huge") clients[i].channel = "#huge";
+        else if (scenario == "small") {
+            snprintf(name, sizeof(name), "#small%lu", static_cast<unsigned long>(i / options.channelSize));
+            clients[i].channel = name;
+        } else if (scenario == "storm") {
+            snprintf(name, sizeof(name), "#storm%lu", static_cast<unsigned long>(i % STORM_CHANNEL_NUM));
+            clients[i].channel = name;
+        }
+        clients[i].fd = UNDEFINED_FD;
+        clients[i].isReady = false;
+        clients[i].startedAt = 0;
+    }
+    if (scenario == "storm") driveStorm(*poller, clients, serverAddr, password, options, counters);
+    else if ((isSetUp = setUpClients(*poller, clients, serverAddr, password)))
+        driveTraffic(*poller, clients, options, scenario != "huge", scenario == "dm", counters);
+    else cerr << scenario << ": server closed or did not welcome some clients (check max_users)" << endl;
+
+    if (isSetUp) printRow(scenario, counters, options.seconds);
+    for (size_t i = 0; i < clients.size(); ++i) {
+        if (clients[i].fd != UNDEFINED_FD) close(clients[i].fd);
+    }
+    delete poller;
+    // Let the server process the disconnections before the next scenario.
+    usleep(500000);
+    return isSetUp;
+}
+
+/**
+ * @brief Apply one "<key>=<value>" option.
+ */
+static bool parseOption(const string& option, Options& options) {
+    const size_t equalPos = option.find('=');
+
+    if (equalPos == string::npos) return false;
+
+    const string key = option.substr(0, equalPos);
+    const double value = atof(option.c_str() + equalPos + 1);
+
+    if (value <= 0) return false;
+    if (key == "clients") options.clientNum = static_cast<size_t>(value);
+    else if (key == "rate") options.rate = value;
+    else if (key == "seconds") options.seconds = value;
+    else if (key == "channel_size") options.channelSize = static_cast<size_t>(value);
+    else return false;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        cerr << "usage : " << argv[0] << " <port> <password> <huge|small|dm|storm|all>"
+             << " [clients=<n>] [rate=<n>] [seconds=<n>] [channel_size=<n>]" << endl;
+        return 1;
+    }
+    const string scenario = argv[3];
+    Options options;
+    struct rlimit limit;
+    struct sockaddr_in serverAddr;
+
+    options.clientNum = 1000;
+    options.rate = 10000;
+    options.seconds = 5;
+    options.channelSize = 10;
+    for (int i = 4; i < argc; ++i) {
+        if (!parseOption(argv[i], options)) {
+            cerr << "Invalid option: " << argv[i] << endl;
+            return 1;
+        }
+    }
+    if (options.clientNum < 2) options.clientNum = 2;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    serverAddr.sin_port = htons(atoi(argv[1]));
+
+    cout << setw(8) << "scenario" << setw(12) << "sent/s" << setw(12) << "dropped/s" << setw(14) << "delivered/s"
+         << setw(10) << "p50 us" << setw(10) << "p99 us" << setw(10) << "p999 us" << endl;
+    if (scenario == "all") {
+        const char *scenarios[] = { "huge", "small", "dm", "storm" };
+
+        for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); ++i) {
+            if (!runScenario(scenarios[i], serverAddr, argv[2], options)) return 1;
+        }
+        return 0;
+    }
+    if (scenario != "huge" && scenario != "small" && scenario != "dm" && scenario != "storm") {
+        cerr << "Unknown scenario: " << scenario << endl;
+        return 1;
+    }
+    return runScenario(scenario, serverAddr, argv[2], options) ? 0 : 1;
+}
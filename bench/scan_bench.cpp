@@ -0,0 +1,168 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cctype>
+#include <cstdlib>
+
+#include "ByteScanner.hpp"
+#include "FormatValidator.hpp"
+#include "CommonValue.hpp"
+#include "Clock.hpp"
+
+using namespace std;
+
+/**
+ * @brief Per-byte cost of the input scanning kernels.
+ *  Every case is run with the line framing / validation code this server
+ *  used before ByteScanner ("legacy") and with each kernel level the CPU supports.
+ *  usage : ./bench/scan_bench [rounds]
+ */
+
+static volatile size_t sink;
+
+/**
+ * @brief Legacy framing: two string::find() calls and the smaller position.
+ */
+static size_t legacyFindLineEnd(const string& buffer, size_t from) {
+    const size_t crPos = buffer.find(CR, from);
+    const size_t lfPos = buffer.find(LF, from);
+
+    if (crPos == string::npos && lfPos == string::npos) return string::npos;
+    if (lfPos == string::npos) return crPos;
+    if (crPos == string::npos) return lfPos;
+    return min(crPos, lfPos);
+}
+
+/**
+ * @brief Legacy nickname check: tolower() and several calls per character.
+ */
+static bool legacyIsValidNickname(const string& nickname) {
+    string::const_iterator it = nickname.begin();
+
+    if (it == nickname.end()) return false;
+    if (!FormatValidator::isLetter(*it) && !FormatValidator::isSpecial(*it)) return false;
+    for (++it; it != nickname.end(); ++it) {
+        const char c = *it;
+
+        if ((tolower(c) >= 'a' && tolower(c) <= 'z') || FormatValidator::isDigit(c)
+            || FormatValidator::isSpecial(c) || FormatValidator::isTargetChar(c, '-')) continue;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Build a stream of CRLF terminated lines, each lineLen bytes long.
+ */
+static string makeLines(size_t lineLen, size_t totalBytes) {
+    const string pattern = "PRIVMSG #channel :hello there, how is everybody doing today? ";
+    string stream;
+
+    while (stream.size() < totalBytes) {
+        for (size_t i = 0; i < lineLen; ++i) stream += pattern[i % pattern.size()];
+        stream += "\r\n";
+    }
+    return stream;
+}
+
+/**
+ * @brief Build a list of valid nicknames of the given length.
+ */
+static vector<string> makeNicknames(size_t length, size_t count) {
+    const string pattern = "Nick_[]{}-0123456789abcdefghijklmnopqrstuvwxyz";
+    vector<string> nicknames;
+
+    for (size_t n = 0; n < count; ++n) {
+        string nickname(1, 'a' + n % 26);
+
+        for (size_t i = 1; i < length; ++i) nickname += pattern[(n + i) % pattern.size()];
+        nicknames.push_back(nickname);
+    }
+    return nicknames;
+}
+
+/**
+ * @brief Print one result line
+ */
+static void report(const string& name, const string& kernel, double ns, size_t bytes) {
+    cout << left << setw(28) << name << setw(8) << kernel << right << fixed << setprecision(3)
+         << setw(10) << ns / bytes << " ns/byte" << setw(10) << (bytes / ns) << " GB/s" << endl;
+}
+
+/**
+ * @brief Frame every line of the stream, like InputBuffer::nextLine() does.
+ */
+static void benchFraming(const string& name, const string& stream, int rounds) {
+    const size_t bytes = stream.size() * rounds;
+    double start = Clock::nowNs();
+
+    for (int r = 0; r < rounds; ++r) {
+        size_t pos = 0;
+        size_t found;
+
+        while ((found = legacyFindLineEnd(stream, pos)) != string::npos) {
+            sink += found;
+            pos = found + 1;
+        }
+    }
+    report(name, "legacy", Clock::nowNs() - start, bytes);
+
+    for (int level = ByteScanner::SCALAR; level <= ByteScanner::getSupportedLevel(); ++level) {
+        ByteScanner::setLevel(static_cast<ByteScanner::Level>(level));
+        start = Clock::nowNs();
+        for (int r = 0; r < rounds; ++r) {
+            const char *cursor = stream.data();
+            const char *end = cursor + stream.size();
+
+            while ((cursor = ByteScanner::findLineEnd(cursor, end)) != end) {
+                sink += cursor - stream.data();
+                ++cursor;
+            }
+        }
+        report(name, ByteScanner::getLevelName(ByteScanner::getLevel()), Clock::nowNs() - start, bytes);
+    }
+}
+
+/**
+ * @brief Validate every nickname of the list.
+ */
+static void benchNickname(const string& name, const vector<string>& nicknames, int rounds) {
+    size_t bytes = 0;
+    double start;
+
+    for (size_t i = 0; i < nicknames.size(); ++i) bytes += nicknames[i].size();
+    bytes *= rounds;
+
+    start = Clock::nowNs();
+    for (int r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < nicknames.size(); ++i) sink += legacyIsValidNickname(nicknames[i]);
+    }
+    report(name, "legacy", Clock::nowNs() - start, bytes);
+
+    for (int level = ByteScanner::SCALAR; level <= ByteScanner::getSupportedLevel(); ++level) {
+        ByteScanner::setLevel(static_cast<ByteScanner::Level>(level));
+        start = Clock::nowNs();
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t i = 0; i < nicknames.size(); ++i) sink += FormatValidator::isValidNickname(nicknames[i]);
+        }
+        report(name, ByteScanner::getLevelName(ByteScanner::getLevel()), Clock::nowNs() - start, bytes);
+    }
+}
+
+int main(int argc, char **argv) {
+    const int rounds = (argc > 1) ? atoi(argv[1]) : 200;
+
+    if (rounds <= 0) {
+        cerr << "usage : " << argv[0] << " [rounds]" << endl;
+        return 1;
+    }
+    cout << "supported kernel : " << ByteScanner::getLevelName(ByteScanner::getSupportedLevel()) << endl;
+
+    benchFraming("framing 32B lines", makeLines(32, 1 << 20), rounds);
+    benchFraming("framing 128B lines", makeLines(128, 1 << 20), rounds);
+    benchFraming("framing 510B lines", makeLines(MAX_MESSAGE_LEN - 2, 1 << 20), rounds);
+    benchNickname("nickname 9B", makeNicknames(9, 4096), rounds * 10);
+    benchNickname("nickname 64B", makeNicknames(64, 4096), rounds * 10);
+    return 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#ifndef BYTESCANNER_HPP
+# define BYTESCANNER_HPP
+
+# include <cstddef>
+
+using namespace std;
+
+/**
+ * @brief Set of bytes, used as a 256-entry lookup table.
+ *  build() also folds the table into two 16-entry nibble tables, so that
+ *  SIMD kernels can classify 16/32 bytes per shuffle. A byte is in the set
+ *  if (lowNibble[byte & 0xF] & highNibble[byte >> 4]) is not 0. That works
+ *  when the rows of the table (one per high nibble) take at most 8
+ *  distinct non-empty shapes; otherwise isNibbleEncoded is false and
+ *  only the scalar kernel is used.
+ */
+struct ByteSet {
+    bool contains[256];
+    unsigned char lowNibble[16];
+    unsigned char highNibble[16];
+    bool isNibbleEncoded;
+
+    ByteSet(void);
+
+    ByteSet& add(unsigned char byte);
+    ByteSet& addRange(unsigned char first, unsigned char last);
+    ByteSet& addAllExcept(unsigned char byte);
+    ByteSet& build(void);
+};
+
+/**
+ * @brief Byte scanning kernels of the hot input path.
+ *  The widest kernel the CPU supports is picked once at startup:
+ *  AVX2, then SSE2/SSSE3, then a portable scalar loop.
+ */
+struct ByteScanner {
+    enum Level {
+        SCALAR,
+        SSE,
+        AVX2
+    };
+
+    static const char *findLineEnd(const char *begin, const char *end);
+    static const char *findFirstNotIn(const char *begin, const char *end, const ByteSet& set);
+
+    static Level getLevel(void);
+    static Level getSupportedLevel(void);
+    static void setLevel(Level level);
+    static const char *getLevelName(Level level);
+};
+
+#endif
@@ -0,0 +1,203 @@
+#pragma once
+
+#ifndef CASEMAPPEDMAP_HPP
+# define CASEMAPPEDMAP_HPP
+
+# include <string>
+# include <vector>
+# include <cstddef>
+
+# include "StringView.hpp"
+# include "FormatValidator.hpp"
+
+using namespace std;
+
+/**
+ * @brief Hash map from IRC names (nicknames, channel names) to T.
+ *  Names are compared with the RFC 1459 case mapping, so "Nick[a]" and
+ *  "nick{A}" are the same key. Hashing and comparing fold each byte on
+ *  the fly, so a lookup with a StringView allocates nothing.
+ *  Open addressing with linear probing; erase shifts the following
+ *  entries back, so there are no tombstones. T is returned by value,
+ *  meant for pointers: find() returns T() when the name is not there.
+ */
+template <typename T>
+class CaseMappedMap {
+    private:
+        struct Slot {
+            string name;
+            T value;
+            size_t hash;
+            bool isUsed;
+
+            Slot(void): value(), hash(0), isUsed(false) { }
+        };
+
+        vector<Slot> _slots;
+        size_t _size;
+
+        CaseMappedMap(const CaseMappedMap& src);
+        CaseMappedMap& operator=(const CaseMappedMap& src);
+
+        /**
+         * @brief Compare two names with the case mapping
+         */
+        static bool isSameName(const string& lhs, const StringView& rhs) {
+            if (lhs.length() != rhs.length()) return false;
+            for (size_t i = 0; i < rhs.length(); ++i) {
+                if (FormatValidator::foldCase(lhs[i]) != FormatValidator::foldCase(rhs.data()[i])) return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Find the slot holding the name, or the empty slot where it would go.
+         */
+        size_t probe(const StringView& name, size_t hash) const {
+            const size_t mask = _slots.size() - 1;
+            size_t index = hash & mask;
+
+            while (_slots[index].isUsed) {
+                if (_slots[index].hash == hash && isSameName(_slots[index].name, name)) break;
+                index = (index + 1) & mask;
+            }
+            return index;
+        }
+
+        /**
+         * @brief Double the table and put every entry in its new place.
+         */
+        void grow(void) {
+            vector<Slot> oldSlots(_slots.size() * 2);
+
+            _slots.swap(oldSlots);
+            for (size_t i = 0; i < oldSlots.size(); ++i) {
+                if (!oldSlots[i].isUsed) continue;
+
+                Slot& slot = _slots[probe(oldSlots[i].name, oldSlots[i].hash)];
+                slot.name.swap(oldSlots[i].name);
+                slot.value = oldSlots[i].value;
+                slot.hash = oldSlots[i].hash;
+                slot.isUsed = true;
+            }
+        }
+
+    public:
+        CaseMappedMap(void): _slots(16), _size(0) { }
+        ~CaseMappedMap() { }
+
+        /**
+         * @brief FNV-1a hash of the case folded name
+         */
+        static size_t hashOf(const StringView& name) {
+            size_t hash = static_cast<size_t>(2166136261u);
+
+            for (size_t i = 0; i < name.length(); ++i) {
+                hash ^= static_cast<unsigned char>(FormatValidator::foldCase(name.data()[i]));
+                hash *= static_cast<size_t>(16777619u);
+            }
+            return hash;
+        }
+
+        size_t size(void) const { return _size; }
+        bool empty(void) const { return _size == 0; }
+
+        /**
+         * @brief Look up a name.
+         *
+         * @param name Name to find, in any case
+         * @return T : Value of the name. T() if not found.
+         */
+        T find(const StringView& name) const {
+            const Slot& slot = _slots[probe(name, hashOf(name))];
+
+            return slot.isUsed ? slot.value : T();
+        }
+
+        /**
+         * @brief Look up a name, and copy it out in the case it was added with.
+         *
+         * @param name Name to find, in any case
+         * @param storedName Set to the name as added. Unchanged if not found.
+         * @return T : Value of the name. T() if not found.
+         */
+        T find(const StringView& name, string& storedName) const {
+            const Slot& slot = _slots[probe(name, hashOf(name))];
+
+            if (!slot.isUsed) return T();
+            storedName = slot.name;
+            return slot.value;
+        }
+
+        /**
+         * @brief Append every value to a list.
+         *
+         * @param values List to append to
+         */
+        void getValues(vector<T>& values) const {
+            for (size_t i = 0; i < _slots.size(); ++i) {
+                if (_slots[i].isUsed) values.push_back(_slots[i].value);
+            }
+        }
+
+        /**
+         * @brief Add a name. Nothing changes if the name (in any case) is already there.
+         *
+         * @param name Name to add. The map keeps its own copy.
+         * @param value Value of the name
+         * @return true : Added / if the name is already there return
+         * @return false
+         */
+        bool insert(const StringView& name, const T& value) {
+            if ((_size + 1) * 2 > _slots.size()) grow();
+
+            const size_t hash = hashOf(name);
+            Slot& slot = _slots[probe(name, hash)];
+
+            if (slot.isUsed) return false;
+            slot.name = name.str();
+            slot.value = value;
+            slot.hash = hash;
+            slot.isUsed = true;
+            ++_size;
+            return true;
+        }
+
+        /**
+         * @brief Remove a name. Entries probed past it are shifted back into the hole.
+         *
+         * @param name Name to remove, in any case
+         * @return true : Removed / if the name is not there return
+         * @return false
+         */
+        bool erase(const StringView& name) {
+            const size_t mask = _slots.size() - 1;
+            size_t hole = probe(name, hashOf(name));
+
+            if (!_slots[hole].isUsed) return false;
+            for (size_t next = (hole + 1) & mask; _slots[next].isUsed; next = (next + 1) & mask) {
+                const size_t home = _slots[next].hash & mask;
+
+                if (((next - home) & mask) < ((next - hole) & mask)) continue;
+                _slots[hole].name.swap(_slots[next].name);
+                _slots[hole].value = _slots[next].value;
+                _slots[hole].hash = _slots[next].hash;
+                hole = next;
+            }
+            _slots[hole].name.clear();
+            _slots[hole].value = T();
+            _slots[hole].isUsed = false;
+            --_size;
+            return true;
+        }
+
+        /**
+         * @brief Remove every name.
+         */
+        void clear(void) {
+            vector<Slot>(16).swap(_slots);
+            _size = 0;
+        }
+};
+
+#endif
@@ -9,36 +9,83 @@
 
 # include "Bot.hpp"
 # include "CommonValue.hpp"
+# include "SharedBuffer.hpp"
+# include "StringView.hpp"
+# include "CaseMappedMap.hpp"
+# include "SlabPool.hpp"
+# include "Mutex.hpp"
 
 using namespace std;
 
 class User;
 class Message;
 
+/**
+ * @brief Channel shared by the reactors. Its members, operators and bot are
+ *  guarded by the channel's own lock, so commands on different channels
+ *  never wait on each other.
+ *  A member keeps a copy of its nickname, so that other threads never read
+ *  the nickname of a user while its reactor renames it (username and host
+ *  do not change once registered).
+ *  Broadcasts take no lock: they read a member list published with an atomic
+ *  pointer, grouped by reactor, and rebuilt by the next broadcast after the
+ *  members change. A replaced list is freed by the Reclaimer.
+ *  A channel counts its references: one by the server's name index, one by
+ *  the channel list of each user holding it. Once no member is left it is
+ *  closed (joining fails), and it is retired when the last reference goes.
+ */
 class Channel {
+    public:
+        struct Member {
+            User *user;
+            string nickname;
+
+            Member(void): user(NULL) { }
+        };
+
+        // Membership nodes come from slab pools, JOIN/PART churn does not hit the heap.
+        typedef map<int, Member, less<int>, PoolAllocator<pair<const int, Member> > > UserMap;
+        typedef set<int, less<int>, PoolAllocator<int> > OperSet;
+
     private:
 		string _name;
-		map<int, User *> _userList;
-		set<int> _operList;
+		mutable Mutex _lock;
+		UserMap _userList;
+		CaseMappedMap<User *> _userByNickname;
+		OperSet _operList;
         Bot _bot;
+        vector<User *> *_members; // NULL until the next broadcast after a change
+        int _refNum;
+        bool _isClosed;
 
         Channel(void);
         Channel(const Channel& channel);
         Channel& operator=(const Channel& channel);
 
+        void resetMembers(void);
+        const vector<User *>& getMembers(void);
+
     public:
         Channel(const string& name);
         ~Channel();
 
+        static void *operator new(size_t size);
+        static void operator delete(void *ptr, size_t size);
+
         const string& getName(void) const;
-        const vector<string> getUserList(void) const;
+        const string getUserList(void) const;
 
-        void addUser(int clientFd, User *user);
+        bool addUser(int clientFd, User *user);
         int deleteUser(int clientFd);
-        User* findUser(const int clientFd);
-        User* findUser(const string& nickname);
+        User* findUser(const int clientFd) const;
+        User* findUser(const StringView& nickname, string *memberNickname = NULL) const;
+        void renameUser(User *user, const string& oldNickname);
         bool isUserOper(int clientFd) const;
-        void broadcast(const Message& msg, int ignoreFd = UNDEFINED_FD) const;
+        void broadcast(const Message& msg, int ignoreFd = UNDEFINED_FD);
+        void broadcast(const SharedBuffer& reply, int ignoreFd = UNDEFINED_FD);
+
+        void retain(void);
+        void release(void);
 
         void executeBot(const string& msgContent);
 };
@@ -0,0 +1,16 @@
+#pragma once
+
+#ifndef CLOCK_HPP
+# define CLOCK_HPP
+
+using namespace std;
+
+/**
+ * @brief Monotonic time, unaffected by changes of the wall clock.
+ */
+struct Clock {
+    static long nowMs(void);
+    static long nowNs(void);
+};
+
+#endif
@@ -3,8 +3,11 @@
 #ifndef COMMAND_HPP
 # define COMMAND_HPP
 
-# include <map>
 # include <string>
+# include <cstddef>
+
+# include "StringView.hpp"
+# include "CommonValue.hpp"
 
 using namespace std;
 
@@ -12,10 +15,27 @@ class Server;
 class User;
 class Message;
 
+/**
+ * @brief Executes the IRC commands received from users.
+ *  Commands are matched case-insensitively through a perfect hash table
+ *  (see lookup()), so an unknown command costs one compare.
+ *  Every command run is counted by table slot in the Stats of the calling thread.
+ */
 class Command {
 	private:
+		typedef bool (Command::*Handler)(User *, const Message&);
+
+		struct Entry {
+			const char *name; // upper case
+			size_t length;
+			Handler handler;
+			bool isNeedAuth;
+		};
+
+		static const size_t TABLE_SIZE = COMMAND_TABLE_SIZE;
+		static const Entry _table[TABLE_SIZE];
+
 		Server& _server;
-		map<string, bool (Command::*)(User *, const Message&)> _commands;
 
 		Command(void);
 		Command(const Command& src);
@@ -28,17 +48,22 @@ class Command {
 		bool cmdNick(User *user, const Message& msg);
 		bool cmdUser(User *user, const Message& msg);
 		bool cmdPing(User *user, const Message& msg);
+		bool cmdPong(User *user, const Message& msg);
 		bool cmdQuit(User *user, const Message& msg);
 		bool cmdKick(User *user, const Message& msg);
 		bool cmdNotice(User *user, const Message& msg);
+		bool cmdStats(User *user, const Message& msg);
 
-		bool isCommandNeedAuth(const string& cmd);
+		static const Entry *lookup(const StringView& cmd);
 
 	public:
 		Command(Server& server);
 		~Command();
 
 		bool run(User *user, const Message& msg);
+
+		static const char *getName(size_t slot);
+		static size_t getSlot(const StringView& cmd);
 };
 
 #endif
\ No newline at end of file
@@ -7,10 +7,83 @@
 # define MAX_NICKNAME_LEN 9
 # define MAX_CHANNELNAME_LEN 31
 
+// Default limits. Set by "max_users=<n>" / "max_channels=<n>" options.
 # define MAX_USER_NUM 30
 # define MAX_CHANNEL_NUM 30
+// Largest values the options accept
+# define MAX_USER_LIMIT 1000000
+# define MAX_CHANNEL_LIMIT 1000000
 
 # define SERVER_HOSTNAME "cacaotalk.42seoul.kr"
+# define SERVER_VERSION "ft_irc-1.0"
+
+// Event loop threads. Set by "threads=<n>" option.
+# define DEFAULT_REACTOR_NUM 1
+# define MAX_REACTOR_NUM 64
+// Locks of the nickname and channel name indexes shared by the threads
+# define INDEX_SHARD_NUM 16
+// Recipients of one reply handed over to another thread in a single inbox node
+# define REPLY_NODE_USER_NUM 30
+// Longest poller wait, in milliseconds, while a reactor has users or channels
+// waiting for the other threads before they can be freed
+# define RECLAIM_WAIT_MS 1
+
+// Ready events taken per poller wait. Starts at MIN_EVENT_BATCH and doubles
+// while batches come back full, up to "max_events=<n>".
+# define MIN_EVENT_BATCH 8
+# define DEFAULT_MAX_EVENTS 1024
+# define MAX_EVENTS_LIMIT 65536
+
+// Flood control: commands a client may run per second, and in a burst.
+// Registered clients are set by "flood_rate=<n>" / "flood_burst=<n>" options.
+// Commands over the limit wait in the input buffer for later loop iterations.
+# define DEFAULT_FLOOD_RATE 10
+# define DEFAULT_FLOOD_BURST 20
+# define UNREGISTERED_FLOOD_RATE 2
+# define UNREGISTERED_FLOOD_BURST 10
+# define MAX_FLOOD_LIMIT 1000000
+
+// Send queue: most memory the unsent replies of a client may hold (capacity of
+// its queued segments) before it is disconnected ("SendQ exceeded"). Registered clients are set by "sendq=<n>" option.
+# define DEFAULT_SENDQ 1048576
+# define UNREGISTERED_SENDQ 16384
+# define MAX_SENDQ_LIMIT 1073741824
+
+// Keepalive, in seconds. A client silent for "ping_interval=<n>" gets a PING,
+// and is disconnected if still silent "ping_timeout=<n>" later. A client not
+// registered within "register_timeout=<n>" is disconnected.
+# define DEFAULT_PING_INTERVAL 120
+# define DEFAULT_PING_TIMEOUT 60
+# define DEFAULT_REGISTER_TIMEOUT 30
+# define MAX_TIMEOUT_LIMIT 86400
+// Resolution of the timer wheel of a reactor, in milliseconds
+# define TIMER_TICK_MS 100
+
+// Seconds between two dumps of the STATS counters to the log.
+// Set by "stats_interval=<n>" option. 0 means no dump.
+# define DEFAULT_STATS_INTERVAL 0
+
+// Logger: records are formatted into a ring of LOG_RING_SIZE records per
+// thread (dropped when full), and written every LOG_FLUSH_INTERVAL_MS.
+// A "log_file=<path>" is rotated at LOG_ROTATE_SIZE bytes, keeping LOG_ROTATE_NUM old files.
+# define LOG_RECORD_SIZE 256
+# define LOG_RING_SIZE 2048
+# define LOG_FLUSH_INTERVAL_MS 10
+# define LOG_ROTATE_SIZE 10485760
+# define LOG_ROTATE_NUM 5
+
+// Slots of the command dispatch table (see Command::lookup())
+# define COMMAND_TABLE_SIZE 16
+
+// Input buffer of a client, allocated on its first read
+# define INPUT_BUFFER_SIZE 4096
+// Replies serialized in place are packed into blocks. The first block after a
+// shared reply is sized to its reply, each next one doubles, up to this size.
+# define REPLY_BLOCK_SIZE 1024
+// Longest message a client may send, CR/LF included (RFC 2812)
+# define MAX_MESSAGE_LEN 512
+// Most params a message may have (RFC 2812)
+# define MAX_MESSAGE_PARAMS 15
 
 // Function return value
 # define ERR_RETURN -1
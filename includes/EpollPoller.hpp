@@ -0,0 +1,59 @@
+#pragma once
+
+#ifndef EPOLLPOLLER_HPP
+# define EPOLLPOLLER_HPP
+
+# ifdef __linux__
+
+# include <vector>
+# include <deque>
+# include <sys/epoll.h>
+
+# include "Poller.hpp"
+# include "CommonValue.hpp"
+
+using namespace std;
+
+class EpollPoller : public Poller {
+    private:
+        /**
+         * @brief Interest of one fd. registered is the event mask the kernel
+         *  has, wanted the one to submit. 0 means not in the interest list.
+         *  The kernel holds its address as epoll user-data, so a ready event
+         *  leads to its fd and user-data without indexing by fd.
+         */
+        struct FdState {
+            int fd;
+            void *udata;
+            uint32_t registered;
+            uint32_t wanted;
+            bool isChanged;
+
+            FdState(void): fd(UNDEFINED_FD), udata(NULL), registered(0), wanted(0), isChanged(false) { }
+        };
+
+        int _epfd;
+        deque<FdState> _fdStates; // indexed by fd. Growing a deque never moves a state.
+        vector<int> _changedFds;
+        vector<struct epoll_event> _readyEvents;
+
+        EpollPoller(const EpollPoller& src);
+        EpollPoller& operator=(const EpollPoller& src);
+
+        void queueChange(int fd, void *udata, bool watchWrite);
+        void submitChanges(void);
+
+    public:
+        EpollPoller(void);
+        ~EpollPoller();
+
+        void addFd(int fd, void *udata, bool watchWrite);
+        void setWriteInterest(int fd, void *udata, bool watchWrite);
+        void removeFd(int fd);
+        int wait(PollEvent *events, int maxEvents, int timeoutMs);
+        const char *getName(void) const;
+};
+
+# endif
+
+#endif
@@ -15,6 +15,14 @@ struct FormatValidator {
 
     static bool isValidNickname(const string& nickname);
     static bool isValidChannelname(const string& channelname);
+
+    /**
+     * @brief Fold a character with the RFC 1459 case mapping: A-Z and []\^ are
+     *  the upper case of a-z and {}|~, which is the range 'A'..'^' moved by 32.
+     */
+    static char foldCase(const char c) {
+        return static_cast<char>(c + (static_cast<unsigned char>(c - 'A') <= '^' - 'A') * ('a' - 'A'));
+    }
 };
 
 #endif
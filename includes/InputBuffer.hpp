@@ -0,0 +1,50 @@
+#pragma once
+
+#ifndef INPUTBUFFER_HPP
+# define INPUTBUFFER_HPP
+
+# include <vector>
+# include <cstddef>
+
+using namespace std;
+
+/**
+ * @brief Bytes received from one client, framed into lines in place.
+ *  recv() writes straight into the buffer, and nextLine() hands out views
+ *  of complete lines without copying them. A scan cursor remembers how far
+ *  the unconsumed bytes were already searched for CR/LF, so every byte is
+ *  scanned once. Consumed bytes are reclaimed by compact() before reading.
+ *  A line longer than MAX_MESSAGE_LEN is dropped up to its terminator.
+ */
+class InputBuffer {
+    private:
+        vector<char> _data;
+        size_t _begin;
+        size_t _scan;
+        size_t _end;
+        bool _isDiscarding;
+
+        InputBuffer(const InputBuffer& src);
+        InputBuffer& operator=(const InputBuffer& src);
+
+    public:
+        enum Status {
+            NO_LINE,
+            LINE,
+            LINE_TOO_LONG
+        };
+
+        InputBuffer(void);
+        ~InputBuffer();
+
+        bool empty(void) const;
+        size_t size(void) const;
+
+        char *prepareWrite(size_t& writableBytes);
+        void commitWrite(size_t bytes);
+        Status nextLine(const char *&line, size_t& length);
+        void ungetLine(const char *line, size_t length);
+        void clear(void);
+};
+
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+
+#ifndef KQUEUEPOLLER_HPP
+# define KQUEUEPOLLER_HPP
+
+# ifndef __linux__
+
+# include <vector>
+# include <deque>
+# include <sys/types.h>
+# include <sys/event.h>
+# include <sys/time.h>
+
+# include "Poller.hpp"
+
+using namespace std;
+
+class KqueuePoller : public Poller {
+    private:
+        /**
+         * @brief Interest of one fd, as the kernel has it and as it is wanted.
+         *  The kernel holds its address as kevent user-data, so a ready event
+         *  leads to its user-data without indexing by fd.
+         */
+        struct FdState {
+            void *udata;
+            bool isRegistered;
+            bool isWriteEnabled;
+            bool wantWrite;
+            bool isChanged;
+
+            FdState(void): udata(NULL), isRegistered(false), isWriteEnabled(false), wantWrite(false), isChanged(false) { }
+        };
+
+        int _kq;
+        deque<FdState> _fdStates; // indexed by fd. Growing a deque never moves a state.
+        vector<int> _changedFds;
+        vector<struct kevent> _eventCheckList;
+        vector<struct kevent> _waitingEvents;
+
+        KqueuePoller(const KqueuePoller& src);
+        KqueuePoller& operator=(const KqueuePoller& src);
+
+        void queueChange(int fd, void *udata, bool watchWrite);
+        void updateEvents(int socket, int16_t filter, uint16_t flags, void *udata);
+        void buildChangeList(void);
+
+    public:
+        KqueuePoller(void);
+        ~KqueuePoller();
+
+        void addFd(int fd, void *udata, bool watchWrite);
+        void setWriteInterest(int fd, void *udata, bool watchWrite);
+        void removeFd(int fd);
+        int wait(PollEvent *events, int maxEvents, int timeoutMs);
+        const char *getName(void) const;
+};
+
+# endif
+
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+
+#ifndef LATENCYHISTOGRAM_HPP
+# define LATENCYHISTOGRAM_HPP
+
+# include <cstddef>
+
+using namespace std;
+
+/**
+ * @brief Log-bucketed histogram of durations in nanoseconds, HDR style:
+ *  every power of two is split into 2^SUB_BUCKET_BITS linear sub-buckets,
+ *  so a value is known within 1/8 of itself from 8ns up to about 68s
+ *  (longer durations land in the last bucket).
+ *  Written by one thread, readable from any thread, like Stats: recording
+ *  is a bucket index computation and a relaxed load and store.
+ */
+class LatencyHistogram {
+    public:
+        static const size_t SUB_BUCKET_BITS = 3;
+        static const size_t SUB_BUCKET_NUM = 1 << SUB_BUCKET_BITS;
+        static const size_t MAX_BIT = 35;
+        static const size_t BUCKET_NUM = (MAX_BIT - SUB_BUCKET_BITS + 2) * SUB_BUCKET_NUM;
+
+        /**
+         * @brief Bucket counts at one point. Snapshots add up (reactors)
+         *  and subtract (a reset baseline).
+         */
+        struct Snapshot {
+            unsigned long buckets[BUCKET_NUM];
+
+            Snapshot(void);
+
+            Snapshot& operator+=(const Snapshot& rhs);
+            Snapshot& operator-=(const Snapshot& rhs);
+
+            unsigned long getCount(void) const;
+            unsigned long getPercentile(double ratio) const;
+            unsigned long getMax(void) const;
+        };
+
+    private:
+        unsigned long _buckets[BUCKET_NUM];
+
+        LatencyHistogram(const LatencyHistogram& src);
+        LatencyHistogram& operator=(const LatencyHistogram& src);
+
+    public:
+        LatencyHistogram(void);
+        ~LatencyHistogram();
+
+        /**
+         * @brief Count one duration. Called by the owning thread only.
+         */
+        void record(unsigned long ns) {
+            unsigned long& bucket = _buckets[bucketOf(ns)];
+
+            __atomic_store_n(&bucket, __atomic_load_n(&bucket, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+        }
+
+        void addTo(Snapshot& snapshot) const;
+
+        /**
+         * @brief Get the bucket of a duration. Values under SUB_BUCKET_NUM have a bucket each.
+         */
+        static size_t bucketOf(unsigned long ns) {
+            if (ns < SUB_BUCKET_NUM) return ns;
+
+            const size_t bit = sizeof(unsigned long) * 8 - 1 - __builtin_clzl(ns);
+
+            if (bit > MAX_BIT) return BUCKET_NUM - 1;
+            return (bit - SUB_BUCKET_BITS + 1) * SUB_BUCKET_NUM + ((ns >> (bit - SUB_BUCKET_BITS)) & (SUB_BUCKET_NUM - 1));
+        }
+
+        static unsigned long getUpperBound(size_t bucket);
+};
+
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+
+#ifndef LOGGER_HPP
+# define LOGGER_HPP
+
+# include <string>
+# include <vector>
+# include <pthread.h>
+
+# include "Mutex.hpp"
+# include "CommonValue.hpp"
+
+using namespace std;
+
+/**
+ * @brief Leveled, asynchronous logger.
+ *  log() formats a record into a ring buffer of the calling thread and
+ *  returns: no lock, no system call, no wait. A record that does not fit
+ *  (the ring is full) is dropped and counted. A background thread drains
+ *  the rings every LOG_FLUSH_INTERVAL_MS and writes each batch with one
+ *  write(), to the standard output or to a log file rotated at
+ *  LOG_ROTATE_SIZE bytes (<file>.1 ... <file>.LOG_ROTATE_NUM).
+ *  Records are "<date> <time> <LEVEL> <event> <key>=<value>...".
+ *  Before start() and after stop(), records stay in the rings (and are
+ *  dropped once full), so code running without a server logs for free.
+ */
+class Logger {
+    public:
+        enum Level {
+            DEBUG,
+            INFO,
+            WARN,
+            ERROR
+        };
+
+    private:
+        struct Record {
+            long timeMs; // Wall clock
+            Level level;
+            int length;
+            char text[LOG_RECORD_SIZE];
+        };
+
+        /**
+         * @brief Single producer, single consumer ring of one logging thread.
+         *  Indexes only grow; a slot is index % LOG_RING_SIZE.
+         */
+        struct Ring {
+            Record records[LOG_RING_SIZE];
+            unsigned long head; // Next record to write out. Written by the writer thread.
+            unsigned long tail; // Next free slot. Written by the owning thread.
+            unsigned long droppedNum; // Written by the owning thread.
+        };
+
+        static Level _level;
+        static int _fd;
+        static string _path;
+        static size_t _fileSize;
+        static int _isRunning;
+        static pthread_t _writer;
+        static Mutex _ringsLock;
+        static vector<Ring *> _rings;
+        static unsigned long _reportedDroppedNum;
+        static __thread Ring *_ring;
+
+        Logger(void);
+
+        static Ring *createRing(void);
+        static void *writerMain(void *arg);
+        static bool drain(string& batch);
+        static void writeBatch(const string& batch);
+        static void rotate(void);
+        static bool openFile(void);
+
+    public:
+        static bool start(const string& path, Level level);
+        static void stop(void);
+
+        static bool isEnabled(Level level) { return level >= _level; }
+        static void log(Level level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+        static unsigned long getDroppedNum(void);
+        static bool parseLevel(const string& name, Level& level);
+};
+
+#endif
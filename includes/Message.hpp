@@ -5,33 +5,50 @@
 # include <string>
 # include <vector>
 
+# include "StringView.hpp"
+# include "CommonValue.hpp"
+
 using namespace std;
 
+/**
+ * @brief IRC message.
+ *  A received message keeps its prefix, command and params as views of the
+ *  received line, which must outlive it. A reply built with operator<< is
+ *  serialized as the params come in, into a string the message owns.
+ */
 class Message {
     private:
-        string _prefix;
-        string _command;
-        vector<string> _params;
-        
+        string _line;
+        StringView _prefix;
+        StringView _command;
+        StringView _args[MAX_MESSAGE_PARAMS];
+        size_t _argCount;
+        string _reply;
+        bool _isGlued;
+
         Message(const Message& packet);
         Message& operator=(const Message& packet);
 
-        void parse(const string& ircMsgFormStr);
+        void parse(const char *line, size_t length);
+        Message& append(const char *param, size_t length);
 
     public:
         Message(void);
         Message(const string& ircMsgFormStr);
+        Message(const char *line, size_t length);
         ~Message();
 
-        const string& getPrefix(void) const;
-        const string& getCommand(void) const;
-        const vector<string>& getParams(void) const;
+        const StringView& getPrefix(void) const;
+        const StringView& getCommand(void) const;
+        const StringView* getParams(void) const;
 
         static vector<string> split(const string& str, const char delimeter);
         
         size_t paramSize(void) const;
         const string createReplyForm(void) const;
-        Message& operator<<(const string param);
+        Message& operator<<(const string& param);
+        Message& operator<<(const char *param);
+        Message& operator<<(const StringView& param);
 };
 
 #endif
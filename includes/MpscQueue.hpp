@@ -0,0 +1,77 @@
+#pragma once
+
+#ifndef MPSCQUEUE_HPP
+# define MPSCQUEUE_HPP
+
+# include <cstddef>
+
+using namespace std;
+
+/**
+ * @brief Lock-free intrusive multi-producer/single-consumer FIFO (D. Vyukov).
+ *  Node must have a "Node *next" member and a default constructor.
+ *  push() may be called from any thread, pop() only from the consumer thread.
+ *  The queue does not own the nodes: popped nodes belong to the consumer.
+ */
+template <typename Node>
+class MpscQueue {
+    private:
+        Node *_head;
+        Node *_tail;
+        Node _stub;
+
+        MpscQueue(const MpscQueue& src);
+        MpscQueue& operator=(const MpscQueue& src);
+
+    public:
+        MpscQueue(void): _head(&_stub), _tail(&_stub) {
+            _stub.next = NULL;
+        }
+
+        ~MpscQueue() { }
+
+        /**
+         * @brief Append node. Wait-free for producers.
+         *
+         * @param node Node to append. Ownership moves to the queue until popped.
+         */
+        void push(Node *node) {
+            Node *prev;
+
+            __atomic_store_n(&node->next, static_cast<Node *>(NULL), __ATOMIC_RELAXED);
+            prev = __atomic_exchange_n(&_head, node, __ATOMIC_ACQ_REL);
+            __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+        }
+
+        /**
+         * @brief Remove the oldest node.
+         *
+         * @return Node* : Oldest node. NULL if empty, or if the only remaining
+         *  push is still in progress (the producer wakes the consumer again after it).
+         */
+        Node *pop(void) {
+            Node *tail = _tail;
+            Node *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+            if (tail == &_stub) {
+                if (next == NULL) return NULL;
+                _tail = next;
+                tail = next;
+                next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+            }
+            if (next != NULL) {
+                _tail = next;
+                return tail;
+            }
+            if (tail != __atomic_load_n(&_head, __ATOMIC_ACQUIRE)) return NULL;
+            push(&_stub);
+            next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+            if (next != NULL) {
+                _tail = next;
+                return tail;
+            }
+            return NULL;
+        }
+};
+
+#endif
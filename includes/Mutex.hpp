@@ -0,0 +1,82 @@
+#pragma once
+
+#ifndef MUTEX_HPP
+# define MUTEX_HPP
+
+# include <pthread.h>
+
+using namespace std;
+
+class Mutex {
+    private:
+        pthread_mutex_t _mutex;
+
+        Mutex(const Mutex& src);
+        Mutex& operator=(const Mutex& src);
+
+    public:
+        Mutex(void);
+        ~Mutex();
+
+        void lock(void);
+        void unlock(void);
+};
+
+/**
+ * @brief Holds a Mutex for the lifetime of the scope, also when an exception unwinds it.
+ */
+class ScopedLock {
+    private:
+        Mutex& _mutex;
+
+        ScopedLock(void);
+        ScopedLock(const ScopedLock& src);
+        ScopedLock& operator=(const ScopedLock& src);
+
+    public:
+        ScopedLock(Mutex& mutex);
+        ~ScopedLock();
+};
+
+/**
+ * @brief Busy-waiting lock for critical sections of a few instructions,
+ *  where parking the thread in pthread_mutex would cost more than the wait.
+ */
+class SpinLock {
+    private:
+        int _isLocked;
+
+        SpinLock(const SpinLock& src);
+        SpinLock& operator=(const SpinLock& src);
+
+    public:
+        SpinLock(void): _isLocked(0) { }
+        ~SpinLock() { }
+
+        void lock(void) {
+            while (__atomic_exchange_n(&_isLocked, 1, __ATOMIC_ACQUIRE)) {
+                while (__atomic_load_n(&_isLocked, __ATOMIC_RELAXED)) ;
+            }
+        }
+        void unlock(void) {
+            __atomic_store_n(&_isLocked, 0, __ATOMIC_RELEASE);
+        }
+};
+
+/**
+ * @brief Holds a SpinLock for the lifetime of the scope.
+ */
+class ScopedSpinLock {
+    private:
+        SpinLock& _lock;
+
+        ScopedSpinLock(void);
+        ScopedSpinLock(const ScopedSpinLock& src);
+        ScopedSpinLock& operator=(const ScopedSpinLock& src);
+
+    public:
+        ScopedSpinLock(SpinLock& lock): _lock(lock) { _lock.lock(); }
+        ~ScopedSpinLock() { _lock.unlock(); }
+};
+
+#endif
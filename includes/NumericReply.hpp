@@ -0,0 +1,79 @@
+#pragma once
+
+#ifndef NUMERICREPLY_HPP
+# define NUMERICREPLY_HPP
+
+# include <cstddef>
+# include <string>
+
+# include "Reply.hpp"
+# include "CommonValue.hpp"
+
+using namespace std;
+
+/**
+ * @brief Template of a numeric reply, serialized at compile time.
+ *  A reply is written as <head><nickname>[ <param>]...<text>[<trailing>]\r\n,
+ *  so only the nickname and the params are copied when it is sent
+ *  (see User::addNumericReply()).
+ */
+struct NumericReply {
+    const char *head; // ":<server> <code> "
+    size_t headLength;
+    const char *text; // " :<message>", or empty
+    size_t textLength;
+
+    static const NumericReply welcome;
+    static const NumericReply yourHost;
+    static const NumericReply created;
+    static const NumericReply namReply;
+    static const NumericReply endOfNames;
+    static const NumericReply statsCommands;
+    static const NumericReply statsDebug;
+    static const NumericReply endOfStats;
+    static const NumericReply noSuchNick;
+    static const NumericReply noSuchChannel;
+    static const NumericReply noOrigin;
+    static const NumericReply noRecipientPrivmsg;
+    static const NumericReply noRecipientNotice;
+    static const NumericReply noTextToSend;
+    static const NumericReply inputTooLong;
+    static const NumericReply unknownCommand;
+    static const NumericReply noNicknameGiven;
+    static const NumericReply erroneusNickname;
+    static const NumericReply nicknameInUse;
+    static const NumericReply unavailResource;
+    static const NumericReply userNotInChannel;
+    static const NumericReply notOnChannel;
+    static const NumericReply needMoreParams;
+    static const NumericReply alreadyRegistered;
+    static const NumericReply passwdMismatch;
+    static const NumericReply erroneusChannelname;
+    static const NumericReply chanOprivsNeeded;
+};
+
+/**
+ * @brief Numeric replies always sent together, serialized once, like the
+ *  welcome sequence. Only the recipient's nickname differs between users,
+ *  so the burst is kept as the constant bytes around each nickname: sending
+ *  it copies those pieces and the nickname into one reservation of the
+ *  output queue (see User::addReplyBurst()).
+ */
+class ReplyBurst {
+    public:
+        static const size_t MAX_REPLY_NUM = 4;
+
+    private:
+        // _pieces[i] comes before the nickname of reply i; the last one ends the burst.
+        string _pieces[MAX_REPLY_NUM + 1];
+        size_t _replyNum;
+
+    public:
+        ReplyBurst(void);
+
+        void add(const NumericReply& reply, const string& trailing = string());
+        size_t getReplyNum(void) const;
+        const string& getPiece(size_t index) const;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+
+#ifndef OUTPUTQUEUE_HPP
+# define OUTPUTQUEUE_HPP
+
+# include <deque>
+# include <climits>
+# include <sys/types.h>
+
+# include "SharedBuffer.hpp"
+
+# ifndef IOV_MAX
+#  define IOV_MAX 1024
+# endif
+
+using namespace std;
+
+/**
+ * @brief Replies waiting to be sent to one client.
+ *  A chain of shared reply segments plus the number of bytes of the first
+ *  segment already sent. Sending gathers up to IOV_MAX segments into one
+ *  writev(), and a partial write only advances the offset.
+ *  Replies serialized in place (appendSpace()) are packed into blocks
+ *  owned by this queue, instead of one allocation each. The first block
+ *  after a shared segment is sized to its reply, and each next one doubles
+ *  up to REPLY_BLOCK_SIZE, so a reply between broadcasts costs its own size
+ *  while a long run of replies still shares few blocks.
+ *  The size of a queue is the memory its segments hold (their capacity,
+ *  sent bytes of the first one included), not the bytes left to send.
+ *  Sizes of the queues are summed in the send queue gauge of the calling
+ *  thread's reactor (Stats::local()), along with the largest size a single
+ *  queue reached. A segment shared by many queues counts in each.
+ */
+class OutputQueue {
+    private:
+        deque<SharedBuffer> _segments;
+        size_t _offset;
+        size_t _size;
+        size_t _nextBlockSize;
+
+        OutputQueue(const OutputQueue& src);
+        OutputQueue& operator=(const OutputQueue& src);
+
+        void consume(size_t bytes);
+        void addSize(size_t bytes);
+        void subtractSize(size_t bytes);
+
+    public:
+        OutputQueue(void);
+        ~OutputQueue();
+
+        bool empty(void) const;
+        size_t size(void) const;
+
+        void push(const SharedBuffer& segment);
+        char *appendSpace(size_t length);
+        void clear(void);
+        ssize_t writeTo(int fd);
+};
+
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef POLLER_HPP
+# define POLLER_HPP
+
+using namespace std;
+
+/**
+ * @brief Readiness notification returned by Poller::wait().
+ *  One backend event may set both readable and writable at the same time.
+ */
+struct PollEvent {
+    int fd;
+    void *udata;
+    bool readable;
+    bool writable;
+    bool error;
+};
+
+/**
+ * @brief I/O multiplexing interface used by the server event loop.
+ *  Every backend reports readiness edge-triggered, so the caller has to
+ *  drain accept()/recv()/send() until EAGAIN on each notification.
+ *  Interest changes are queued and submitted together on the next wait(),
+ *  keeping only the last change of each fd: a fd added and removed, or
+ *  armed and disarmed, within one loop iteration never reaches the kernel.
+ *  Removing a fd is the exception: it leaves the kernel interest list
+ *  before the next wait() returns, so the caller may close it any time later.
+ */
+class Poller {
+    public:
+        /**
+         * @brief Counters of the poller. Written by the owning thread only,
+         *  readable from any thread.
+         */
+        struct Stats {
+            unsigned long waitNum;
+            unsigned long eventNum;
+            unsigned long fullWaitNum;
+            unsigned long changeNum;
+            unsigned long submittedChangeNum;
+            unsigned long changeCallNum;
+        };
+
+    private:
+        Stats _stats;
+
+        Poller(const Poller& src);
+        Poller& operator=(const Poller& src);
+
+    protected:
+        Poller(void);
+
+        void countWait(int numOfEvents, int maxEvents);
+        void countChange(void);
+        void countSubmit(unsigned long changeNum, unsigned long callNum);
+
+    public:
+        virtual ~Poller();
+
+        Stats getStats(void) const;
+
+        virtual void addFd(int fd, void *udata, bool watchWrite) = 0;
+        virtual void setWriteInterest(int fd, void *udata, bool watchWrite) = 0;
+        virtual void removeFd(int fd) = 0;
+        virtual int wait(PollEvent *events, int maxEvents, int timeoutMs) = 0;
+        virtual const char *getName(void) const = 0;
+
+        static Poller* create(void);
+};
+
+#endif
@@ -0,0 +1,165 @@
+#pragma once
+
+#ifndef REACTOR_HPP
+# define REACTOR_HPP
+
+# include <string>
+# include <vector>
+# include <deque>
+# include <pthread.h>
+
+# include "Poller.hpp"
+# include "MpscQueue.hpp"
+# include "SharedBuffer.hpp"
+# include "ServerConfig.hpp"
+# include "TimerWheel.hpp"
+# include "Stats.hpp"
+# include "Reclaimer.hpp"
+# include "CommonValue.hpp"
+
+using namespace std;
+
+class Server;
+class User;
+
+/**
+ * @brief Reply handed over to the reactor owning its recipients.
+ *  One node carries the reply for up to REPLY_NODE_USER_NUM users of that
+ *  reactor, and nodes come from a slab pool.
+ */
+struct ReplyNode {
+    ReplyNode *next;
+    SharedBuffer reply;
+    size_t userNum;
+    User *users[REPLY_NODE_USER_NUM];
+
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+};
+
+/**
+ * @brief One event loop thread.
+ *  Owns its own listening socket (SO_REUSEPORT), poller and subset of users.
+ *  Only the owning thread touches the sockets and buffers of its users.
+ *  Replies for its users produced on other threads arrive through the inbox,
+ *  in nodes of many recipients with one wake-up per broadcast.
+ *  Other threads may keep pointers to its users until their next quiescent
+ *  point (see Reclaimer), so a disconnected user is deleted, and its socket
+ *  closed, only once every other reactor went through one since, and the
+ *  inbox nodes posted until then are drained.
+ *  A client socket is registered with its User as poller user-data. The
+ *  kernel hands each event back with the poller's state of the fd, which
+ *  holds the User, so an event leads to its user without a lookup by fd.
+ *  The event batch starts small and doubles while the poller fills it, so
+ *  a busy reactor needs fewer waits per event; it halves again when mostly
+ *  empty, so that a quiet reactor flushes replies after few events.
+ *  Each command line spends a flood token of its user. A user out of tokens
+ *  is throttled: its socket is left unread and its buffered lines run on
+ *  later iterations as tokens come back, so a flooder cannot stall the
+ *  other users of the loop.
+ *  A user whose unsent replies hold more memory than the send queue limit of its class
+ *  is disconnected when its replies are flushed ("SendQ exceeded").
+ *  Each user has one keepalive timer in the reactor's timer wheel: first the
+ *  registration deadline, then the idle check that sends a PING, then the
+ *  deadline of the answer. The poller wait times out at the next timer.
+ *  Activity is counted in the reactor's own Stats, bound to its thread.
+ *  The first reactor also prints the counters of the whole server every
+ *  stats interval, if one is set.
+ */
+class Reactor {
+    private:
+        // Users disconnected in one loop iteration, waiting to be deleted
+        struct ClosedBatch {
+            Reclaimer::Stamp stamp;
+            bool isGraceOver;
+            unsigned long postedLimit; // inbox nodes to drain first, known once the grace is over
+            vector<User *> users;
+        };
+
+        Server& _server;
+        Reclaimer& _reclaimer;
+        int _id;
+        int _fd;
+        int _wakeFd[2];
+        int _wakePending;
+        int _isStopping;
+        Poller *_poller;
+        vector<PollEvent> _waitingEvents;
+        int _batchSize;
+        int _maxBatchSize;
+        int _floodRate;
+        int _floodBurst;
+        size_t _sendQ;
+        long _pingIntervalMs;
+        long _pingTimeoutMs;
+        long _registerTimeoutMs;
+        long _statsIntervalMs;
+        long _nextStatsMs;
+        long _nowMs;
+        TimerWheel _timers;
+        Stats _stats;
+        vector<TimerWheel::Timer *> _expiredTimers;
+        vector<User *> _pendingFlush;
+        vector<User *> _throttledUsers;
+        vector<User *> _users; // indexed by socket fd
+        vector<User *> _closedUsers;
+        deque<ClosedBatch> _closedBatches;
+        MpscQueue<ReplyNode> _inbox;
+        unsigned long _postedNum; // written by the posting threads
+        unsigned long _drainedNum;
+        pthread_t _thread;
+        pthread_t _handle;
+        bool _isThreadStarted;
+        string _error;
+
+        Reactor(void);
+        Reactor(const Reactor& src);
+        Reactor& operator=(const Reactor& src);
+
+        static void *threadMain(void *arg);
+
+        void acceptNewClient(void);
+        void recvDataFromClient(User *user);
+        void sendDataToClient(User *user);
+        void flushPendingReplies(void);
+        void deleteClosedUsers(void);
+        void adaptBatchSize(int numOfEvents);
+        void handleEvent(const PollEvent& event);
+        void handleMessageFromBuffer(User *user);
+        bool takeFloodToken(User *user);
+        int getThrottleWaitMs(void) const;
+        void resumeThrottledUsers(void);
+        int getWaitTimeoutMs(void) const;
+        void expireTimers(void);
+        void handleTimer(User *user);
+        void printStatsIfDue(void);
+        void closeWithQuit(User *user, const char *reason);
+
+        void drainWakeFd(void);
+        void drainInbox(void);
+
+    public:
+        Reactor(Server& server, int id, const ServerConfig& config);
+        ~Reactor();
+
+        int getId(void) const;
+        const string& getError(void) const;
+        bool isCurrentThread(void) const;
+        int getBatchSize(void) const;
+        Poller::Stats getPollerStats(void) const;
+        Stats::Snapshot getStats(void) const;
+        void addLatenciesTo(Stats::Latencies& latencies) const;
+        size_t getSendQLimit(bool isRegistered) const;
+
+        void start(void);
+        void join(void);
+        void run(void);
+        void stop(void);
+
+        void post(User *user, const SharedBuffer& reply);
+        void post(User *const *users, size_t count, const SharedBuffer& reply);
+        void requestFlush(User *user);
+        void disconnectClient(User *user);
+};
+
+#endif
@@ -0,0 +1,91 @@
+#pragma once
+
+#ifndef RECLAIMER_HPP
+# define RECLAIMER_HPP
+
+# include <vector>
+# include <deque>
+# include <cstddef>
+
+using namespace std;
+
+/**
+ * @brief Frees objects shared by the reactors once no reactor can still
+ *  point to them (quiescent-state based reclamation).
+ *  A reactor keeps pointers found in shared structures (users of other
+ *  reactors, channels, member lists) only while it handles one loop
+ *  iteration. Its state is bumped before and after each poller wait, and is
+ *  odd while it waits. An object is retired after it was unlinked from every
+ *  shared structure; it is stamped with the states of all reactors, and
+ *  freed once each other reactor was waiting at the stamp or has moved on
+ *  since (a grace period), because nothing can point to it anymore.
+ *  Readers take no lock and write nothing.
+ *  Objects retired on a thread that runs no reactor (tests, benchmarks)
+ *  are freed at once.
+ */
+class Reclaimer {
+    public:
+        typedef vector<unsigned long> Stamp;
+
+    private:
+        struct Retired {
+            void (*destroy)(void *object);
+            void *object;
+        };
+        struct Batch {
+            Stamp stamp;
+            vector<Retired> objects;
+        };
+        // One per reactor. Only the state is read by other threads; the padding
+        // keeps it off the cache line of the retire lists.
+        struct Slot {
+            unsigned long state;
+            char padding[64];
+            vector<Retired> retired;
+            deque<Batch> batches;
+
+            Slot(void): state(1) { }
+        };
+
+        vector<Slot *> _slots;
+
+        static __thread Reclaimer *_current;
+        static __thread size_t _currentId;
+
+        Reclaimer(void);
+        Reclaimer(const Reclaimer& src);
+        Reclaimer& operator=(const Reclaimer& src);
+
+        static void retire(void (*destroy)(void *), void *object);
+
+        /**
+         * @brief Free an object retired with retire<T>()
+         */
+        template <typename T>
+        static void destroy(void *object) {
+            delete static_cast<T *>(object);
+        }
+
+    public:
+        Reclaimer(size_t threadNum);
+        ~Reclaimer();
+
+        void bindToThread(size_t id);
+        void setOnline(size_t id, bool isOnline);
+        Stamp getStamp(void) const;
+        bool isGraceOver(const Stamp& stamp, size_t id) const;
+        bool hasRetired(size_t id) const;
+        void collect(size_t id);
+
+        /**
+         * @brief Free an object after the next grace period. Callable from any thread.
+         *
+         * @param object Object no shared structure points to anymore. Deleted with delete.
+         */
+        template <typename T>
+        static void retire(T *object) {
+            retire(&destroy<T>, object);
+        }
+};
+
+#endif
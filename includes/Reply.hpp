@@ -3,6 +3,16 @@
 
 // NUMERIC REPLIES
 # define RPL_WELCOME "001"
+# define RPL_WELCOME_MSG ":Welcome to the " SERVER_HOSTNAME " Network"
+# define RPL_YOURHOST "002"
+# define RPL_YOURHOST_MSG ":Your host is " SERVER_HOSTNAME ", running version " SERVER_VERSION
+# define RPL_CREATED "003"
+# define RPL_CREATED_MSG ":This server was created "
+
+# define RPL_STATSCOMMANDS "212"
+# define RPL_ENDOFSTATS "219"
+# define RPL_ENDOFSTATS_MSG ":End of STATS report"
+# define RPL_STATSDEBUG "249"
 
 # define RPL_NAMREPLY "353"
 # define RPL_ENDOFNAMES "366"
@@ -22,6 +32,8 @@
 # define ERR_NORECIPIENT_MSG ":No recipient given"
 # define ERR_NOTEXTTOSEND "412"
 # define ERR_NOTEXTTOSEND_MSG ":No text to send"
+# define ERR_INPUTTOOLONG "417"
+# define ERR_INPUTTOOLONG_MSG ":Input line was too long"
 
 # define ERR_UNKNOWNCOMMAND "421"
 # define ERR_UNKNOWNCOMMAND_MSG ":Unknown command"
@@ -6,63 +6,76 @@
 # include <string>
 # include <map>
 # include <exception>
-# include <sys/types.h>
-# include <sys/event.h>
-# include <sys/time.h>
-# include <sys/socket.h>
-# include <arpa/inet.h>
-# include <unistd.h>
-# include <fcntl.h>
-# include <sys/errno.h>
+# include <stdexcept>
+# include <cstring>
+# include <cstdlib>
+# include <cerrno>
 # include <vector>
 
 # include "Command.hpp"
+# include "Mutex.hpp"
+# include "ServerConfig.hpp"
+# include "StringView.hpp"
+# include "ShardedIndex.hpp"
+# include "Reclaimer.hpp"
+# include "Stats.hpp"
+# include "NumericReply.hpp"
 
 using namespace std;
 
 class User;
 class Channel;
+class Reactor;
+class Message;
 class Server {
     private:
-        int _fd;
-        int _kq;
         int _port;
         string _password;
-        map<int, User *> _allUser;
-        map<string, Channel *> _allChannel;
-        vector<struct kevent> _eventCheckList;
-        struct kevent _waitingEvents[8];
+        int _maxUsers;
+        int _maxChannels;
+        int _userNum;
+        int _channelNum;
+        ShardedIndex<User *> _userByNickname;
+        ShardedIndex<Channel *> _channelByName;
+        Reclaimer _reclaimer;
+        vector<Reactor *> _reactors;
         Command _command;
+        mutable Mutex _latencyLock;
+        Stats::Latencies _latencyBaseline;
+        ReplyBurst _welcomeBurst; // replies after RPL_WELCOME, serialized at start-up
 
         Server(void);
         Server(const Server& server);
         Server& operator=(const Server& server);
 
-        void initKqueue(void);
-        void updateEvents(int socket, int16_t filter, uint16_t flags, uint32_t fflags, intptr_t data, void *udata);
-
-        void acceptNewClient(void);
-        void recvDataFromClient(const struct kevent& event);
-        void sendDataToClient(const struct kevent& event);
-        void handleEvent(const struct kevent& event);
-
-        void handleMessageFromBuffer(User* user);
-        size_t checkCmdBuffer(const User *user) const;
-
     public:
-        Server(int port, string password);
+        Server(const ServerConfig& config);
         ~Server();
 
-        const map<string, Channel *>& getAllChannel(void) const;
+        Reclaimer& getReclaimer(void);
+        const ReplyBurst& getWelcomeBurst(void) const;
 
-        User* findClientByNickname(const string& nickname) const;
-        Channel* findChannelByName(const string& name) const;
+        User* findClientByNickname(const StringView& nickname) const;
+        User* findClientByNickname(const StringView& nickname, string& storedNickname) const;
+        Channel* findChannelByName(const StringView& name) const;
 
         bool checkPassword(const string& password) const;
         Channel* addChannel(const string& name);
-        void deleteChannel(const string& name);
-        void disconnectClient(int clientFd);
+        void deleteChannel(Channel *channel);
+
+        bool reserveClient(void);
+        void removeClient(User *user);
+        bool renameClient(User *user, const string& nickname);
+        bool executeCommand(User *user, const Message& msg);
+        void disconnectClient(User *user);
+
+        Stats::Snapshot collectStats(void) const;
+        void printStats(void) const;
+        void collectLatencies(Stats::Latencies& latencies) const;
+        void resetLatencies(void);
+
         void run(void);
+        void stopReactors(void);
         void shutDown(const string& msg);
 };
 
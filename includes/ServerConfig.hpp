@@ -0,0 +1,39 @@
+#pragma once
+
+#ifndef SERVERCONFIG_HPP
+# define SERVERCONFIG_HPP
+
+# include <string>
+
+# include "Logger.hpp"
+
+using namespace std;
+
+/**
+ * @brief Runtime settings of the server.
+ *  Defaults come from CommonValue.hpp, and can be overridden by
+ *  "<key>=<value>" options after the port and password arguments.
+ */
+struct ServerConfig {
+    int port;
+    string password;
+    int reactorNum;
+    int maxUsers;
+    int maxChannels;
+    int maxEvents;
+    int floodRate;
+    int floodBurst;
+    int sendQ;
+    int pingInterval;
+    int pingTimeout;
+    int registerTimeout;
+    int statsInterval;
+    string logFile;
+    Logger::Level logLevel;
+
+    ServerConfig(void);
+
+    bool parseOption(const string& option);
+};
+
+#endif
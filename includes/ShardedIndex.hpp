@@ -0,0 +1,131 @@
+#pragma once
+
+#ifndef SHARDEDINDEX_HPP
+# define SHARDEDINDEX_HPP
+
+# include <string>
+# include <vector>
+# include <cstddef>
+
+# include "CaseMappedMap.hpp"
+# include "Mutex.hpp"
+# include "StringView.hpp"
+# include "CommonValue.hpp"
+
+using namespace std;
+
+/**
+ * @brief Index from IRC names to T shared by the reactors, split into
+ *  INDEX_SHARD_NUM CaseMappedMaps with a lock each. A name always lands in
+ *  the same shard, so lookups of different names rarely wait on each other.
+ *  Meant for pointers, like CaseMappedMap: T() stands for "not there".
+ *  The values are not owned; what they point to must outlive the lookups
+ *  (see Reclaimer).
+ */
+template <typename T>
+class ShardedIndex {
+    private:
+        struct Shard {
+            Mutex lock;
+            CaseMappedMap<T> map;
+        };
+
+        mutable Shard _shards[INDEX_SHARD_NUM];
+
+        ShardedIndex(const ShardedIndex& src);
+        ShardedIndex& operator=(const ShardedIndex& src);
+
+        /**
+         * @brief Shard of a name. The map inside a shard indexes by the low bits
+         *  of the same hash, so the shard is picked from higher ones.
+         */
+        Shard& shardOf(const StringView& name) const {
+            return _shards[(CaseMappedMap<T>::hashOf(name) >> 20) % INDEX_SHARD_NUM];
+        }
+
+    public:
+        ShardedIndex(void) { }
+        ~ShardedIndex() { }
+
+        /**
+         * @brief Look up a name.
+         *
+         * @param name Name to find, in any case
+         * @return T : Value of the name. T() if not found.
+         */
+        T find(const StringView& name) const {
+            Shard& shard = shardOf(name);
+            ScopedLock lock(shard.lock);
+
+            return shard.map.find(name);
+        }
+
+        /**
+         * @brief Look up a name, and copy it out in the case it was added with.
+         *
+         * @param name Name to find, in any case
+         * @param storedName Set to the name as added. Unchanged if not found.
+         * @return T : Value of the name. T() if not found.
+         */
+        T find(const StringView& name, string& storedName) const {
+            Shard& shard = shardOf(name);
+            ScopedLock lock(shard.lock);
+
+            return shard.map.find(name, storedName);
+        }
+
+        /**
+         * @brief Take a name for a value, in one step.
+         *  If the name already belongs to the same value, it takes the new case.
+         *
+         * @param name Name to add
+         * @param value Value of the name
+         * @return T : Value the name had before. T() if it was free, so it is taken now.
+         *  Another value means the name was left as it was.
+         */
+        T insert(const StringView& name, const T& value) {
+            Shard& shard = shardOf(name);
+            ScopedLock lock(shard.lock);
+            const T owner = shard.map.find(name);
+
+            if (owner == T()) {
+                shard.map.insert(name, value);
+            } else if (owner == value) {
+                shard.map.erase(name);
+                shard.map.insert(name, value);
+            }
+            return owner;
+        }
+
+        /**
+         * @brief Remove a name if it still belongs to the value.
+         *  A name taken again by another value since is left alone.
+         *
+         * @param name Name to remove, in any case
+         * @param value Value the name must have
+         * @return true : Removed / if the name is not there, or has another value return
+         * @return false
+         */
+        bool erase(const StringView& name, const T& value) {
+            Shard& shard = shardOf(name);
+            ScopedLock lock(shard.lock);
+
+            if (shard.map.find(name) != value) return false;
+            return shard.map.erase(name);
+        }
+
+        /**
+         * @brief Append every value to a list.
+         *
+         * @param values List to append to
+         */
+        void getValues(vector<T>& values) const {
+            for (size_t i = 0; i < INDEX_SHARD_NUM; ++i) {
+                ScopedLock lock(_shards[i].lock);
+
+                _shards[i].map.getValues(values);
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+
+#ifndef SHAREDBUFFER_HPP
+# define SHAREDBUFFER_HPP
+
+# include <string>
+
+using namespace std;
+
+/**
+ * @brief Byte string shared by reference counting.
+ *  Copying only bumps an atomic counter, so one serialized reply can sit
+ *  in the reply buffers of many users, also across reactor threads.
+ *  Bytes never change once shared; only the sole owner may append, and only
+ *  into capacity reserved up front, so the bytes written so far never move.
+ */
+class SharedBuffer {
+    private:
+        struct Block {
+            int refCount;
+            string data;
+
+            Block(const string& src);
+            Block(size_t capacity);
+        };
+
+        Block *_block;
+
+        void release(void);
+
+    public:
+        SharedBuffer(void);
+        explicit SharedBuffer(const string& data);
+        explicit SharedBuffer(size_t capacity);
+        SharedBuffer(const SharedBuffer& src);
+        SharedBuffer& operator=(const SharedBuffer& src);
+        ~SharedBuffer();
+
+        const string& str(void) const;
+        const char *data(void) const;
+        size_t size(void) const;
+        size_t capacity(void) const;
+        bool empty(void) const;
+
+        char *appendSpace(size_t length);
+};
+
+#endif
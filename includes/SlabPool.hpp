@@ -0,0 +1,129 @@
+#pragma once
+
+#ifndef SLABPOOL_HPP
+# define SLABPOOL_HPP
+
+# include <vector>
+# include <cstddef>
+# include <new>
+
+# include "Mutex.hpp"
+
+using namespace std;
+
+/**
+ * @brief Allocator of fixed-size blocks, carved out of contiguous chunks.
+ *  Freed blocks go to a free list and are handed out again before a new
+ *  chunk is taken, so churn of short-lived objects reuses the same memory
+ *  instead of scattering over the heap. Chunks are kept until the pool is
+ *  destroyed. Thread-safe; the critical sections are a few pointer moves,
+ *  so they are guarded by a spin lock.
+ *  Setting IRCSERV_NO_POOL in the environment makes every pool forward to
+ *  operator new/delete, so that memory checkers see each object.
+ */
+class SlabPool {
+    public:
+        struct Stats {
+            const char *name;
+            size_t blockSize;
+            size_t chunkNum;
+            size_t blockNum;
+            size_t inUse;
+            size_t peakInUse;
+        };
+
+    private:
+        struct FreeBlock {
+            FreeBlock *next;
+        };
+        struct Chunk {
+            Chunk *next;
+        };
+
+        const char *_name;
+        size_t _blockSize;
+        size_t _blocksPerChunk;
+        bool _isBypassed;
+        SpinLock _lock;
+        FreeBlock *_freeList;
+        Chunk *_chunks;
+        size_t _chunkNum;
+        size_t _inUse;
+        size_t _peakInUse;
+        SlabPool *_nextPool;
+
+        static SlabPool *_allPools;
+
+        SlabPool(void);
+        SlabPool(const SlabPool& src);
+        SlabPool& operator=(const SlabPool& src);
+
+        void addChunk(void);
+
+    public:
+        SlabPool(const char *name, size_t blockSize, size_t blocksPerChunk);
+        ~SlabPool();
+
+        void *allocate(void);
+        void deallocate(void *block);
+        Stats getStats(void);
+
+        static vector<Stats> getAllStats(void);
+};
+
+/**
+ * @brief STL allocator that takes single nodes from a SlabPool of the node size.
+ *  Meant for node based containers (map, set, list), whose rebound allocator
+ *  only ever allocates one node at a time. Larger requests go to operator new.
+ */
+template <typename T>
+class PoolAllocator {
+    public:
+        typedef T value_type;
+        typedef T *pointer;
+        typedef const T *const_pointer;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+
+        template <typename U>
+        struct rebind {
+            typedef PoolAllocator<U> other;
+        };
+
+        PoolAllocator(void) { }
+        PoolAllocator(const PoolAllocator&) { }
+        template <typename U>
+        PoolAllocator(const PoolAllocator<U>&) { }
+        ~PoolAllocator() { }
+
+        pointer address(reference value) const { return &value; }
+        const_pointer address(const_reference value) const { return &value; }
+        size_type max_size(void) const { return static_cast<size_type>(-1) / sizeof(T); }
+
+        pointer allocate(size_type n, const void * = NULL) {
+            if (n == 1) return static_cast<pointer>(pool().allocate());
+            return static_cast<pointer>(::operator new(n * sizeof(T)));
+        }
+        void deallocate(pointer ptr, size_type n) {
+            if (n == 1) pool().deallocate(ptr);
+            else ::operator delete(ptr);
+        }
+        void construct(pointer ptr, const T& value) { new (ptr) T(value); }
+        void destroy(pointer ptr) { ptr->~T(); }
+
+        bool operator==(const PoolAllocator&) const { return true; }
+        bool operator!=(const PoolAllocator&) const { return false; }
+
+        /**
+         * @brief Pool shared by every container with nodes of type T
+         */
+        static SlabPool& pool(void) {
+            static SlabPool nodePool("container node", sizeof(T), 512);
+
+            return nodePool;
+        }
+};
+
+#endif
@@ -0,0 +1,108 @@
+#pragma once
+
+#ifndef STATS_HPP
+# define STATS_HPP
+
+# include <cstddef>
+
+# include "CommonValue.hpp"
+# include "LatencyHistogram.hpp"
+
+using namespace std;
+
+/**
+ * @brief Activity counters of one reactor: commands run, bytes received and
+ *  sent, channel broadcasts and their deliveries, accepted and rejected
+ *  connections. Written by the owning thread only, readable from any
+ *  thread, like Poller::Stats: an update is a relaxed load and store, with
+ *  no locked instruction and no cache line shared with other reactors.
+ *  Code that does not know its reactor (commands, channels) counts through
+ *  local(), the counters bound to the calling thread.
+ *  Latency histograms are kept the same way: per command handler, per
+ *  event dispatch, and per loop iteration (from the poller wait returning
+ *  to the end of the batch: the loop lag).
+ *  The send queue gauges (memory held by the queues of the reactor's clients,
+ *  and the largest one queue reached) are kept the same way too, and only
+ *  summed over the reactors when read.
+ */
+class Stats {
+    public:
+        enum Counter {
+            BYTES_IN,
+            BYTES_OUT,
+            BROADCASTS,
+            DELIVERIES,
+            ACCEPTED,
+            REJECTED,
+            COUNTER_NUM
+        };
+
+        /**
+         * @brief Values of the counters at one point. Commands are indexed by
+         *  dispatch table slot; COMMAND_TABLE_SIZE counts the unknown commands.
+         */
+        struct Snapshot {
+            unsigned long counters[COUNTER_NUM];
+            unsigned long commands[COMMAND_TABLE_SIZE + 1];
+            unsigned long sendQBytes;
+            unsigned long sendQPeakBytes;
+
+            Snapshot(void);
+
+            Snapshot& operator+=(const Snapshot& rhs);
+        };
+
+        /**
+         * @brief Latency histograms at one point. Commands are indexed like Snapshot.
+         */
+        struct Latencies {
+            LatencyHistogram::Snapshot commands[COMMAND_TABLE_SIZE];
+            LatencyHistogram::Snapshot event;
+            LatencyHistogram::Snapshot loopLag;
+
+            Latencies& operator+=(const Latencies& rhs);
+            Latencies& operator-=(const Latencies& rhs);
+        };
+
+    private:
+        unsigned long _counters[COUNTER_NUM];
+        unsigned long _commands[COMMAND_TABLE_SIZE + 1];
+        unsigned long _sendQBytes;
+        unsigned long _sendQPeakBytes;
+        LatencyHistogram _commandLatency[COMMAND_TABLE_SIZE];
+        LatencyHistogram _eventLatency;
+        LatencyHistogram _loopLag;
+
+        static __thread Stats *_local;
+        static Stats _unbound;
+
+        Stats(const Stats& src);
+        Stats& operator=(const Stats& src);
+
+        static void addTo(unsigned long& counter, unsigned long value) {
+            __atomic_store_n(&counter, __atomic_load_n(&counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+        }
+
+    public:
+        Stats(void);
+        ~Stats();
+
+        void add(Counter counter, unsigned long value) { addTo(_counters[counter], value); }
+        void countCommand(size_t slot) { addTo(_commands[slot], 1); }
+        void addSendQ(unsigned long bytes, unsigned long queueSize) {
+            addTo(_sendQBytes, bytes);
+            if (queueSize > _sendQPeakBytes) __atomic_store_n(&_sendQPeakBytes, queueSize, __ATOMIC_RELAXED);
+        }
+        void subtractSendQ(unsigned long bytes) { addTo(_sendQBytes, -bytes); }
+        void recordCommand(size_t slot, unsigned long ns) { _commandLatency[slot].record(ns); }
+        void recordEvent(unsigned long ns) { _eventLatency.record(ns); }
+        void recordLoopLag(unsigned long ns) { _loopLag.record(ns); }
+        Snapshot getSnapshot(void) const;
+        void addLatenciesTo(Latencies& latencies) const;
+
+        static Stats& local(void) { return _local != NULL ? *_local : _unbound; }
+        static void bindToThread(Stats *stats);
+        static const char *getName(Counter counter);
+};
+
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+
+#ifndef STRINGVIEW_HPP
+# define STRINGVIEW_HPP
+
+# include <string>
+# include <cstring>
+
+using namespace std;
+
+/**
+ * @brief Non-owning reference to a range of characters.
+ *  Used to look at parts of a received line without copying them.
+ *  The referenced bytes must outlive the view.
+ *  Converts to string implicitly, so it can be passed where a string is expected.
+ */
+class StringView {
+    private:
+        const char *_data;
+        size_t _length;
+
+    public:
+        StringView(void): _data(""), _length(0) { }
+        StringView(const char *data, size_t length): _data(data), _length(length) { }
+        StringView(const string& str): _data(str.data()), _length(str.length()) { }
+
+        const char *data(void) const { return _data; }
+        size_t length(void) const { return _length; }
+        size_t size(void) const { return _length; }
+        bool empty(void) const { return _length == 0; }
+
+        /**
+         * @brief Get character at index. Like const string, index length() gives '\0'.
+         */
+        char operator[](size_t index) const { return index < _length ? _data[index] : '\0'; }
+
+        string str(void) const { return string(_data, _length); }
+        operator string(void) const { return str(); }
+
+        bool operator==(const StringView& rhs) const {
+            return _length == rhs._length && memcmp(_data, rhs._data, _length) == 0;
+        }
+        bool operator!=(const StringView& rhs) const { return !(*this == rhs); }
+        bool operator==(const string& rhs) const { return *this == StringView(rhs); }
+        bool operator!=(const string& rhs) const { return !(*this == StringView(rhs)); }
+        bool operator==(const char *rhs) const { return *this == StringView(rhs, strlen(rhs)); }
+        bool operator!=(const char *rhs) const { return !(*this == rhs); }
+};
+
+#endif
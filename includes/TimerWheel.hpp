@@ -0,0 +1,64 @@
+#pragma once
+
+#ifndef TIMERWHEEL_HPP
+# define TIMERWHEEL_HPP
+
+# include <vector>
+# include <cstddef>
+
+using namespace std;
+
+/**
+ * @brief Hierarchical timer wheel of one reactor.
+ *  Time is counted in ticks of TIMER_TICK_MS. Level 0 has one slot per tick
+ *  for the next TIMER_WHEEL_SLOTS ticks; each level above covers
+ *  TIMER_WHEEL_SLOTS times the span of the one below. A timer sits in the
+ *  slot of the lowest level that reaches its expiry, and moves down a
+ *  level each time the level below wraps around. Timers are intrusive
+ *  list nodes, so arming and cancelling are O(1) and allocate nothing.
+ *  A timer expires up to one tick late, never early.
+ */
+class TimerWheel {
+    public:
+        struct Timer {
+            Timer *prev;
+            Timer *next;
+            long expireTick;
+            void *data; // Owner of the timer, for the expiry handler
+
+            Timer(void);
+
+            bool isArmed(void) const;
+        };
+
+    private:
+        static const int LEVEL_NUM = 4;
+        static const int SLOT_BITS = 6;
+        static const int SLOT_NUM = 1 << SLOT_BITS;
+
+        Timer _slots[LEVEL_NUM][SLOT_NUM]; // Heads of circular lists
+        long _startMs;
+        long _currentTick;
+        size_t _size;
+
+        TimerWheel(void);
+        TimerWheel(const TimerWheel& src);
+        TimerWheel& operator=(const TimerWheel& src);
+
+        void link(Timer *timer);
+        static void unlink(Timer *timer);
+        void cascade(int level);
+
+    public:
+        TimerWheel(long nowMs);
+        ~TimerWheel();
+
+        size_t size(void) const;
+
+        void arm(Timer *timer, long expireMs);
+        void cancel(Timer *timer);
+        void expire(long nowMs, vector<Timer *>& expired);
+        int getTimeoutMs(long nowMs) const;
+};
+
+#endif
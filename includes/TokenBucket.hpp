@@ -0,0 +1,28 @@
+#pragma once
+
+#ifndef TOKENBUCKET_HPP
+# define TOKENBUCKET_HPP
+
+using namespace std;
+
+/**
+ * @brief Rate limiter: one token per command, refilled at rate tokens per
+ *  second up to burst tokens. Rate and burst are passed on every refill,
+ *  so the limits can follow the class of the client (e.g. once registered).
+ *  Tokens are counted in thousandths, so a refill every millisecond still
+ *  adds up at low rates.
+ */
+class TokenBucket {
+    private:
+        long _milliTokens;
+        long _lastRefillMs;
+
+    public:
+        TokenBucket(int burst, long nowMs);
+
+        bool refill(long nowMs, int rate, int burst);
+        void take(void);
+        long getWaitMs(int rate) const;
+};
+
+#endif
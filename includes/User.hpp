@@ -5,65 +5,109 @@
 
 # include <string>
 # include <vector>
+# include <sys/types.h>
 
 # include "CommonValue.hpp"
+# include "SharedBuffer.hpp"
+# include "OutputQueue.hpp"
+# include "InputBuffer.hpp"
+# include "SlabPool.hpp"
+# include "StringView.hpp"
+# include "NumericReply.hpp"
+# include "TokenBucket.hpp"
+# include "TimerWheel.hpp"
 
 using namespace std;
 
 class Channel;
 class Message;
+class Reactor;
 class User {
 	private:
 		int _fd;
+		Reactor *_reactor;
 		string _host;
 		string _password;
 		string _nickname; // unique
 		string _username;
+		string _prefix; // ":<nickname>!<username>@<host>", rebuilt when NICK/USER changes it
 		bool _auth;
-		string _cmdBuffer;
-		string _replyBuffer;
+		InputBuffer _cmdBuffer;
+		OutputQueue _replyBuffer;
+		TokenBucket _floodBucket;
+		TimerWheel::Timer _timer;
+		long _lastActiveMs;
+		long _pingSentMs; // 0 while no PING is waiting for an answer
 		vector<Channel *> _myChannelList;
 		bool _isQuiting;
+		bool _isClosed;
+		bool _isWriteArmed;
+		bool _isThrottled;
+		bool _isSendQExceeded;
 
 		User(void);
 		User(const User& user);
 		User& operator=(const User& user);
 
+		void updatePrefix(void);
+		void checkSendQ(void);
+
 	public:
-        User(int fd, const string& host);
+        User(int fd, const string& host, Reactor *reactor);
 		~User();
+
+		static void *operator new(size_t size);
+		static void operator delete(void *ptr, size_t size);
 		
 		int getFd(void) const;
+		Reactor* getReactor(void) const;
 		const string& getHost(void) const;
 		const string& getPassword(void) const;
-		const string getNickname(void) const;
-		const string getSource(void) const;
+		const string& getNickname(void) const;
+		const string& getPrefix(void) const;
 		const string& getUsername(void) const;
 		bool getAuth(void) const;
-		const string& getCmdBuffer(void) const;
-		const string& getReplyBuffer(void) const;
+		InputBuffer& getCmdBuffer(void);
+		TokenBucket& getFloodBucket(void);
+		TimerWheel::Timer& getTimer(void);
+		long getLastActiveMs(void) const;
+		long getPingSentMs(void) const;
+		const OutputQueue& getReplyBuffer(void) const;
 		const vector<Channel *>& getMyAllChannel(void) const;
 		bool getIsQuiting(void) const;
+		bool getIsClosed(void) const;
+		bool getIsWriteArmed(void) const;
+		bool getIsThrottled(void) const;
+		bool getIsSendQExceeded(void) const;
 
 		void setPassword(const string& pwd);
 		void setNickname(const string& nickname);
 		void setUsername(const string& username);
 		void setAuth(void);
 		void setIsQuiting(void);
+		void setIsClosed(void);
+		void setIsWriteArmed(bool isWriteArmed);
+		void setIsThrottled(bool isThrottled);
+		void setLastActiveMs(long nowMs);
+		void setPingSentMs(long nowMs);
 
-		void setCmdBuffer(const string& src);
 		void clearCmdBuffer(void);
 		void setReplyBuffer(const string& src);
 		void setReplyBuffer(const Message& msg);
 		void clearReplyBuffer(void);
-		void addToCmdBuffer(const string& src);
+		ssize_t sendReplyBuffer(void);
 		void addToReplyBuffer(const string& src);
 		void addToReplyBuffer(const Message& msg);
+		void addToReplyBuffer(const SharedBuffer& reply);
+		void addToReplyBuffer(const StringView *pieces, size_t count);
+		void addNumericReply(const NumericReply& reply, const StringView& param1 = StringView(),
+							 const StringView& param2 = StringView(), const StringView& trailing = StringView());
+		void addReplyBurst(const ReplyBurst& burst);
 
 		void addToMyChannelList(Channel* channel);
 		void deleteFromMyChannelList(Channel* channel);
 		void clearMyChannelList(void);
-		void broadcastToMyChannels(const Message& msg, const int ignoreFd = UNDEFINED_FD) const;
+		bool broadcastToMyChannels(const Message& msg, const int ignoreFd = UNDEFINED_FD);
 
 };
 
@@ -0,0 +1,297 @@
+#include <cstring>
+#include "ByteScanner.hpp"
+#include "CommonValue.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+# define BYTESCANNER_X86
+# include <immintrin.h>
+#endif
+
+/**
+ * @brief Construct a new ByteSet:: Empty set
+ */
+ByteSet::ByteSet(void): isNibbleEncoded(false) {
+    memset(contains, 0, sizeof(contains));
+    memset(lowNibble, 0, sizeof(lowNibble));
+    memset(highNibble, 0, sizeof(highNibble));
+}
+
+/**
+ * @brief Add a byte to the set. Call build() after the last change.
+ *
+ * @param byte Byte to add
+ * @return ByteSet& : *this
+ */
+ByteSet& ByteSet::add(unsigned char byte) {
+    contains[byte] = true;
+    return *this;
+}
+
+/**
+ * @brief Add bytes from first to last (inclusive) to the set. Call build() after the last change.
+ *
+ * @param first First byte of the range
+ * @param last Last byte of the range
+ * @return ByteSet& : *this
+ */
+ByteSet& ByteSet::addRange(unsigned char first, unsigned char last) {
+    for (unsigned int byte = first; byte <= last; ++byte) contains[byte] = true;
+    return *this;
+}
+
+/**
+ * @brief Add every byte except one to the set. Call build() after the last change.
+ *
+ * @param byte Byte to leave out
+ * @return ByteSet& : *this
+ */
+ByteSet& ByteSet::addAllExcept(unsigned char byte) {
+    for (unsigned int i = 0; i < 256; ++i) contains[i] = (i != byte);
+    return *this;
+}
+
+/**
+ * @brief Fold the 256-entry table into the nibble tables used by the SIMD kernels.
+ *  Every distinct non-empty row (16 bytes sharing a high nibble) gets one bit.
+ *  highNibble holds the bit of its row, lowNibble the bits of all rows containing it.
+ *
+ * @return ByteSet& : *this
+ */
+ByteSet& ByteSet::build(void) {
+    unsigned int rows[16];
+    unsigned int rowOfBit[8];
+    int bitCount = 0;
+
+    memset(lowNibble, 0, sizeof(lowNibble));
+    memset(highNibble, 0, sizeof(highNibble));
+    isNibbleEncoded = true;
+    for (int high = 0; high < 16; ++high) {
+        rows[high] = 0;
+        for (int low = 0; low < 16; ++low) {
+            if (contains[(high << 4) | low]) rows[high] |= (1u << low);
+        }
+        if (rows[high] == 0) continue;
+
+        int bit = 0;
+        while (bit < bitCount && rowOfBit[bit] != rows[high]) ++bit;
+        if (bit == bitCount) {
+            if (bitCount == 8) {
+                isNibbleEncoded = false;
+                return *this;
+            }
+            rowOfBit[bitCount++] = rows[high];
+        }
+        highNibble[high] = static_cast<unsigned char>(1u << bit);
+    }
+    for (int bit = 0; bit < bitCount; ++bit) {
+        for (int low = 0; low < 16; ++low) {
+            if (rowOfBit[bit] & (1u << low)) lowNibble[low] |= static_cast<unsigned char>(1u << bit);
+        }
+    }
+    return *this;
+}
+
+/**
+ * @brief Find the first CR or LF character. Portable version.
+ *
+ * @param begin First byte to check
+ * @param end One past the last byte to check
+ * @return const char* : Position of CR/LF character. If it does not exist, return end.
+ */
+static const char *findLineEndScalar(const char *begin, const char *end) {
+    for (; begin != end; ++begin) {
+        if (*begin == CR || *begin == LF) return begin;
+    }
+    return end;
+}
+
+/**
+ * @brief Find the first byte that is not in the set. Portable version.
+ *
+ * @param begin First byte to check
+ * @param end One past the last byte to check
+ * @param set Allowed bytes
+ * @return const char* : Position of the first byte not in the set. If it does not exist, return end.
+ */
+static const char *findFirstNotInScalar(const char *begin, const char *end, const ByteSet& set) {
+    for (; begin != end; ++begin) {
+        if (!set.contains[static_cast<unsigned char>(*begin)]) return begin;
+    }
+    return end;
+}
+
+#ifdef BYTESCANNER_X86
+
+/**
+ * @brief Find the first CR or LF character, 16 bytes per step.
+ */
+__attribute__((target("sse2")))
+static const char *findLineEndSse(const char *begin, const char *end) {
+    const __m128i cr = _mm_set1_epi8(CR);
+    const __m128i lf = _mm_set1_epi8(LF);
+
+    for (; end - begin >= 16; begin += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, cr), _mm_cmpeq_epi8(chunk, lf)));
+
+        if (mask) return begin + __builtin_ctz(mask);
+    }
+    return findLineEndScalar(begin, end);
+}
+
+/**
+ * @brief Find the first CR or LF character, 32 bytes per step.
+ *  The upper halves of the ymm registers are cleared before the SSE tail,
+ *  mixing dirty AVX state with SSE code stalls the pipeline.
+ */
+__attribute__((target("avx2")))
+static const char *findLineEndAvx2(const char *begin, const char *end) {
+    if (end - begin >= 32) {
+        const __m256i cr = _mm256_set1_epi8(CR);
+        const __m256i lf = _mm256_set1_epi8(LF);
+
+        for (; end - begin >= 32; begin += 32) {
+            const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+            const unsigned int mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr),
+                                                                           _mm256_cmpeq_epi8(chunk, lf)));
+
+            if (mask) return begin + __builtin_ctz(mask);
+        }
+        _mm256_zeroupper();
+    }
+    return findLineEndSse(begin, end);
+}
+
+/**
+ * @brief Find the first byte that is not in the set, 16 bytes per step.
+ *  Both nibbles of each byte index a table with pshufb; a byte is in the set
+ *  if the two looked-up bitmasks share a bit.
+ */
+__attribute__((target("ssse3")))
+static const char *findFirstNotInSse(const char *begin, const char *end, const ByteSet& set) {
+    const __m128i lowTable = _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.lowNibble));
+    const __m128i highTable = _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.highNibble));
+    const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; end - begin >= 16; begin += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        const __m128i low = _mm_shuffle_epi8(lowTable, _mm_and_si128(chunk, nibbleMask));
+        const __m128i high = _mm_shuffle_epi8(highTable, _mm_and_si128(_mm_srli_epi16(chunk, 4), nibbleMask));
+        const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(low, high), zero));
+
+        if (mask) return begin + __builtin_ctz(mask);
+    }
+    return findFirstNotInScalar(begin, end, set);
+}
+
+/**
+ * @brief Find the first byte that is not in the set, 32 bytes per step.
+ *  Same as the SSE version with the nibble tables repeated in both lanes.
+ *  Clears the upper halves of the ymm registers before the SSE tail.
+ */
+__attribute__((target("avx2")))
+static const char *findFirstNotInAvx2(const char *begin, const char *end, const ByteSet& set) {
+    if (end - begin >= 32) {
+        const __m256i lowTable = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(set.lowNibble)));
+        const __m256i highTable = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(set.highNibble)));
+        const __m256i nibbleMask = _mm256_set1_epi8(0x0F);
+        const __m256i zero = _mm256_setzero_si256();
+
+        for (; end - begin >= 32; begin += 32) {
+            const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+            const __m256i low = _mm256_shuffle_epi8(lowTable, _mm256_and_si256(chunk, nibbleMask));
+            const __m256i high = _mm256_shuffle_epi8(highTable, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibbleMask));
+            const unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(low, high), zero));
+
+            if (mask) return begin + __builtin_ctz(mask);
+        }
+        _mm256_zeroupper();
+    }
+    return findFirstNotInSse(begin, end, set);
+}
+
+#endif
+
+static ByteScanner::Level currentLevel = ByteScanner::getSupportedLevel();
+
+/**
+ * @brief Find the first CR or LF character.
+ *
+ * @param begin First byte to check
+ * @param end One past the last byte to check
+ * @return const char* : Position of CR/LF character. If it does not exist, return end.
+ */
+const char *ByteScanner::findLineEnd(const char *begin, const char *end) {
+#ifdef BYTESCANNER_X86
+    if (currentLevel == AVX2) return findLineEndAvx2(begin, end);
+    if (currentLevel == SSE) return findLineEndSse(begin, end);
+#endif
+    return findLineEndScalar(begin, end);
+}
+
+/**
+ * @brief Find the first byte that is not in the set.
+ *
+ * @param begin First byte to check
+ * @param end One past the last byte to check
+ * @param set Allowed bytes. Must be built.
+ * @return const char* : Position of the first byte not in the set. If it does not exist, return end.
+ */
+const char *ByteScanner::findFirstNotIn(const char *begin, const char *end, const ByteSet& set) {
+#ifdef BYTESCANNER_X86
+    if (set.isNibbleEncoded) {
+        if (currentLevel == AVX2) return findFirstNotInAvx2(begin, end, set);
+        if (currentLevel == SSE) return findFirstNotInSse(begin, end, set);
+    }
+#endif
+    return findFirstNotInScalar(begin, end, set);
+}
+
+/**
+ * @brief Get the level of kernels in use.
+ *
+ * @return Level : SCALAR, SSE or AVX2
+ */
+ByteScanner::Level ByteScanner::getLevel(void) {
+    return currentLevel;
+}
+
+/**
+ * @brief Get the widest level of kernels the CPU supports.
+ *  SSE needs SSSE3 for the byte set kernel.
+ *
+ * @return Level : SCALAR, SSE or AVX2
+ */
+ByteScanner::Level ByteScanner::getSupportedLevel(void) {
+#ifdef BYTESCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return AVX2;
+    if (__builtin_cpu_supports("ssse3")) return SSE;
+#endif
+    return SCALAR;
+}
+
+/**
+ * @brief Use kernels of a lower level. Meant for benchmarks; a level the CPU
+ *  does not support falls back to the supported one.
+ *
+ * @param level SCALAR, SSE or AVX2
+ */
+void ByteScanner::setLevel(Level level) {
+    const Level supported = getSupportedLevel();
+
+    currentLevel = (level > supported) ? supported : level;
+}
+
+/**
+ * @brief Get printable name of a level
+ *
+ * @param level SCALAR, SSE or AVX2
+ * @return const char* : "scalar", "sse" or "avx2"
+ */
+const char *ByteScanner::getLevelName(Level level) {
+    if (level == AVX2) return "avx2";
+    if (level == SSE) return "sse";
+    return "scalar";
+}
@@ -1,18 +1,50 @@
 #include "User.hpp"
 #include "Channel.hpp"
 #include "Message.hpp"
+#include "Reactor.hpp"
+#include "Reclaimer.hpp"
+#include "Stats.hpp"
+#include <algorithm>
+
+static SlabPool channelPool("Channel", sizeof(Channel), 64);
 
 /**
- * @brief Construct a new Channel:: Channel object
+ * @brief Construct a new Channel:: Channel object, referenced by the name index of the server
  * 
  * @param name name of channel
  */
-Channel::Channel(const string& name): _name(name) {}
+Channel::Channel(const string& name): _name(name), _members(NULL), _refNum(1), _isClosed(false) {}
 
 /**
  * @brief Destroy the Channel:: Channel object
+ *  Nothing can read the member list of a retired channel anymore.
  */
-Channel::~Channel() { }
+Channel::~Channel() {
+    delete _members;
+}
+
+/**
+ * @brief Allocate a channel from the channel slab pool.
+ * 
+ * @param size Size of the object. A derived class bigger than Channel goes to the heap.
+ * @return void* : Memory for the channel
+ * @throw bad_alloc if there is no memory.
+ */
+void *Channel::operator new(size_t size) {
+    if (size != sizeof(Channel)) return ::operator new(size);
+    return channelPool.allocate();
+}
+
+/**
+ * @brief Give the memory of a channel back to the channel slab pool.
+ * 
+ * @param ptr Memory got from Channel::operator new
+ * @param size Size of the object
+ */
+void Channel::operator delete(void *ptr, size_t size) {
+    if (size != sizeof(Channel)) ::operator delete(ptr);
+    else channelPool.deallocate(ptr);
+}
 
 /**
  * @brief Getter
@@ -26,62 +58,88 @@ const string& Channel::getName(void) const {
 /**
  * @brief Get users list of channel
  * 
- * @return const vector<string> : Users nickname list to vector. Channel operator has '\@' by prefix
+ * @return const string : Nicknames of users separated by spaces, ready for RPL_NAMREPLY. Channel operator has '\@' by prefix
  */
-const vector<string> Channel::getUserList(void) const {
-    vector<string> userList;
-
-    for (map<int, User *>::const_iterator it = _userList.begin(); it != _userList.end(); ++it) {
-        string nickname = "";
+const string Channel::getUserList(void) const {
+    ScopedLock lock(_lock);
+    string userList;
 
-        if (isUserOper(it->second->getFd())) nickname += '@';
-        nickname += it->second->getNickname();
-        userList.push_back(nickname);
+    userList.reserve(_userList.size() * (MAX_NICKNAME_LEN + 2));
+    for (UserMap::const_iterator it = _userList.begin(); it != _userList.end(); ++it) {
+        if (!userList.empty()) userList += ' ';
+        if (_operList.find(it->first) != _operList.end()) userList += '@';
+        userList += it->second.nickname;
     }
     return userList;
 }
 
-
 /**
  * @brief Add user to channel. If target user is the first of this channel, set to channel operator.
+ *  Called on the thread of the user, which is the only one adding it.
  * 
  * @param clientFd Socket fd of user
  * @param user User class pointer of user
+ * @return true : Joined / if the channel is closed (its last member left) return
+ * @return false 
  * @throw container.insert method can throw exception
  */
-void Channel::addUser(int clientFd, User *user) {
+bool Channel::addUser(int clientFd, User *user) {
+    ScopedLock lock(_lock);
+
+    if (_isClosed) return false;
     if (_userList.empty()) _operList.insert(clientFd);
-    _userList.insert(make_pair(clientFd, user));
+
+    Member& member = _userList[clientFd];
+
+    member.user = user;
+    member.nickname = user->getNickname();
+    _userByNickname.insert(member.nickname, user);
+    resetMembers();
+    return true;
 }
 
 /**
  * @brief Delete user from channel. If target user was channel operator, set another user to channel operator.
+ *  The channel is closed when its last member leaves.
  * 
  * @param clientFd Socket fd of user
  * @return int : Number of remain users after delete user. This is for delete channel if nobody in this channel.
  * @throw container.insert method can throw exception
  */
 int Channel::deleteUser(int clientFd) {
-    map<int, User *>::iterator it;
-    string clientSource;
+    SharedBuffer modeReply;
+    int remainNum;
 
-    it = _userList.find(clientFd);
-    if (it == _userList.end()) return _userList.size();
-    
-    clientSource = it->second->getSource();
-    _userList.erase(clientFd);
-    _operList.erase(clientFd);
+    {
+        ScopedLock lock(_lock);
+        UserMap::iterator it = _userList.find(clientFd);
 
-    if (_userList.empty()) return 0;
+        if (it == _userList.end()) return _userList.size();
 
-    if (_operList.empty()) {
-       pair<int, User *> nextOper;
+        const User *leavingUser = it->second.user;
+        string leavingNickname;
 
-       nextOper = *_userList.begin();
-       _operList.insert(nextOper.first);
-       broadcast(Message() << ":" << clientSource << "MODE" << getName() << "+o" << nextOper.second->getNickname());
+        if (_userByNickname.find(it->second.nickname) == leavingUser) _userByNickname.erase(it->second.nickname);
+        leavingNickname.swap(it->second.nickname);
+        _userList.erase(it);
+        _operList.erase(clientFd);
+        resetMembers();
+
+        if (_userList.empty()) {
+            _isClosed = true;
+            return 0;
+        }
+
+        if (_operList.empty()) {
+            const UserMap::const_iterator nextOper = _userList.begin();
+
+            _operList.insert(nextOper->first);
+            modeReply = SharedBuffer((Message() << ":" + leavingNickname + "!" + leavingUser->getUsername() + "@" + leavingUser->getHost() << "MODE" << getName() << "+o" << nextOper->second.nickname).createReplyForm());
+        }
+        remainNum = _userList.size();
     }
-    return _userList.size();
+    if (!modeReply.empty()) broadcast(modeReply);
+    return remainNum;
 }
 
 /**
@@ -91,30 +149,45 @@ int Channel::deleteUser(int clientFd) {
  * @return User* : User class pointer
  * @exception NULL : Target user not exist in this channel
  */
-User* Channel::findUser(const int clientFd) {
-    map<int, User *>::iterator it;
+User* Channel::findUser(const int clientFd) const {
+    ScopedLock lock(_lock);
+    UserMap::const_iterator it = _userList.find(clientFd);
 
-    it = _userList.find(clientFd);
     if (it == _userList.end()) return NULL;
-    return it->second;
+    return it->second.user;
 }
 
 /**
- * @brief Find user in channel by nickname
+ * @brief Find user in channel by nickname. Nicknames are case insensitive (RFC 1459 case mapping).
  * 
  * @param nickname nickname of user
+ * @param memberNickname If not NULL, set to the nickname of the member as the channel knows it
  * @return User* : User class pointer
  * @exception NULL : Target user not exist in this channel
  */
-User* Channel::findUser(const string& nickname) {
-    map<int, User *>::iterator it;
+User* Channel::findUser(const StringView& nickname, string *memberNickname) const {
+    ScopedLock lock(_lock);
 
-    for(it = _userList.begin(); it != _userList.end(); ++it) {
-        User *user = it->second;
+    if (memberNickname == NULL) return _userByNickname.find(nickname);
+    return _userByNickname.find(nickname, *memberNickname);
+}
 
-        if (user->getNickname() == nickname) return user;
-    }
-    return NULL;
+/**
+ * @brief Move a member to its new nickname in the nickname index.
+ *  Called by the server on the thread of the user, for every channel of a user
+ *  that changed nickname. A channel the user was kicked from is left as is.
+ * 
+ * @param user Member that already has its new nickname
+ * @param oldNickname Nickname the member had before
+ */
+void Channel::renameUser(User *user, const string& oldNickname) {
+    ScopedLock lock(_lock);
+    UserMap::iterator it = _userList.find(user->getFd());
+
+    if (it == _userList.end() || it->second.user != user) return ;
+    if (_userByNickname.find(oldNickname) == user) _userByNickname.erase(oldNickname);
+    it->second.nickname = user->getNickname();
+    _userByNickname.insert(it->second.nickname, user);
 }
 
 /**
@@ -125,49 +198,165 @@ User* Channel::findUser(const string& nickname) {
  * @return false : User is not channel operator OR not exist in this channel
  */
 bool Channel::isUserOper(int clientFd) const {
-    set<int>::iterator it;
+    ScopedLock lock(_lock);
 
     return (_operList.find(clientFd) != _operList.end());
 }
 
 /**
- * @brief Send message to all users in this channel
+ * @brief Drop the published member list after the members changed.
+ *  Must be called with the channel lock held.
+ */
+void Channel::resetMembers(void) {
+    vector<User *> *members = _members;
+
+    if (members == NULL) return ;
+    __atomic_store_n(&_members, static_cast<vector<User *> *>(NULL), __ATOMIC_RELEASE);
+    Reclaimer::retire(members);
+}
+
+/**
+ * @brief Order of the published member list: members of the same reactor next to each other
+ */
+static bool isBeforeInReactorOrder(const User *lhs, const User *rhs) {
+    return lhs->getReactor() < rhs->getReactor();
+}
+
+/**
+ * @brief Get the members to broadcast to, without taking the channel lock
+ *  unless the list has to be rebuilt after a change.
+ *  The list stays valid until the end of the loop iteration of the caller.
+ * 
+ * @return const vector<User *>& : Members, grouped by reactor
+ */
+const vector<User *>& Channel::getMembers(void) {
+    vector<User *> *members = __atomic_load_n(&_members, __ATOMIC_ACQUIRE);
+
+    if (members != NULL) return *members;
+
+    ScopedLock lock(_lock);
+
+    if (_members == NULL) {
+        members = new vector<User *>();
+        members->reserve(_userList.size());
+        for (UserMap::const_iterator it = _userList.begin(); it != _userList.end(); ++it)
+            members->push_back(it->second.user);
+        stable_sort(members->begin(), members->end(), isBeforeInReactorOrder);
+        __atomic_store_n(&_members, members, __ATOMIC_RELEASE);
+    }
+    return *_members;
+}
+
+/**
+ * @brief Send message to all users in this channel.
+ *  The message is serialized once and shared by the reply buffers of all recipients.
  * 
  * @param msg Message
  * @param ignoreFd Socket fd that not wnat to be sent. -1(default argument) means send to all user.
  */
-void Channel::broadcast(const Message& msg, int ignoreFd) const {
-    map<int, User *>::const_iterator it;
+void Channel::broadcast(const Message& msg, int ignoreFd) {
+    broadcast(SharedBuffer(msg.createReplyForm()), ignoreFd);
+}
+
+/**
+ * @brief Send an already serialized reply to all users in this channel.
+ *  Members of the calling thread get it in their reply buffers right away.
+ *  Members of each other reactor get it in a few inbox nodes, posted
+ *  with one wake-up (see Reactor::post()).
+ *  Counted as one broadcast, and one delivery per recipient.
+ * 
+ * @param reply Serialized reply
+ * @param ignoreFd Socket fd that not wnat to be sent. -1(default argument) means send to all user.
+ */
+void Channel::broadcast(const SharedBuffer& reply, int ignoreFd) {
+    const vector<User *>& members = getMembers();
+    unsigned long deliveryNum = 0;
+    size_t begin = 0;
 
-    for(it = _userList.begin(); it != _userList.end(); ++it) {
-        if (it->first == ignoreFd) continue;
+    while (begin < members.size()) {
+        Reactor *reactor = members[begin]->getReactor();
+        size_t end = begin + 1;
 
-        it->second->addToReplyBuffer(msg.createReplyForm());
+        while (end < members.size() && members[end]->getReactor() == reactor) ++end;
+        if (reactor == NULL || reactor->isCurrentThread()) {
+            for (size_t i = begin; i < end; ++i) {
+                if (members[i]->getFd() == ignoreFd) continue;
+                members[i]->addToReplyBuffer(reply);
+                ++deliveryNum;
+            }
+        } else {
+            size_t runBegin = begin;
+
+            for (size_t i = begin; i <= end; ++i) {
+                if (i < end && members[i]->getFd() != ignoreFd) continue;
+                if (i > runBegin) reactor->post(&members[runBegin], i - runBegin, reply);
+                deliveryNum += i - runBegin;
+                runBegin = i + 1;
+            }
+        }
+        begin = end;
+    }
+
+    Stats& stats = Stats::local();
+
+    stats.add(Stats::BROADCASTS, 1);
+    stats.add(Stats::DELIVERIES, deliveryNum);
+}
+
+/**
+ * @brief Count one more user list holding the channel.
+ *  Called with a channel the caller just joined, so it is not retired yet.
+ */
+void Channel::retain(void) {
+    ScopedLock lock(_lock);
+
+    ++_refNum;
+}
+
+/**
+ * @brief Drop a reference. The last one retires the channel: it is freed
+ *  once no thread can be using it (see Reclaimer).
+ */
+void Channel::release(void) {
+    bool isUnused;
+
+    {
+        ScopedLock lock(_lock);
+
+        isUnused = --_refNum == 0;
     }
+    if (isUnused) Reclaimer::retire(this);
 }
 
 /**
  * @brief Bot command middleware. Runs regardless of upper/lower case.
+ *  The bot runs under the channel lock; its answer is broadcast after.
  * 
  * @param msgContent Message that sent by PRIVMSG command that content start with '!'
  */
 void Channel::executeBot(const string& msgContent) {
 	vector<string> params = Message::split(msgContent, ' ');
 	string command = params[0];
+	string answer;
+	bool hasAnswer = true;
 	
 	for (string::size_type i=0; i<command.length(); i++) command[i] = toupper(command[i]);
-	if (command == "!HELP") {
-		broadcast(Message() << ":" << SERVER_HOSTNAME << "PRIVMSG" << getName() << ":" 
-                            << "Bot commands: .addmenu .deletemenu .showmenu .pickmenu");
-	} else if (command == "!ADDMENU") {
-		_bot.addMenu(params);
-	} else if (command == "!DELETEMENU") {
-		_bot.deleteMenu(params);
-	} else if (command == "!SHOWMENU") {
-		broadcast(Message() << ":" << SERVER_HOSTNAME << "PRIVMSG" << getName() << ":" 
-                            << _bot.showMenu());
-	} else if (command == "!PICKMENU") {
-		broadcast(Message() << ":" << SERVER_HOSTNAME << "PRIVMSG" << getName() << ":" 
-                            << _bot.pickMenu());
+	{
+		ScopedLock lock(_lock);
+
+		if (command == "!HELP") {
+			answer = "Bot commands: .addmenu .deletemenu .showmenu .pickmenu";
+		} else if (command == "!ADDMENU") {
+			_bot.addMenu(params);
+			hasAnswer = false;
+		} else if (command == "!DELETEMENU") {
+			_bot.deleteMenu(params);
+			hasAnswer = false;
+		} else if (command == "!SHOWMENU") {
+			answer = _bot.showMenu();
+		} else if (command == "!PICKMENU") {
+			answer = _bot.pickMenu();
+		} else hasAnswer = false;
 	}
+	if (hasAnswer) broadcast(Message() << ":" << SERVER_HOSTNAME << "PRIVMSG" << getName() << ":" << answer);
 }
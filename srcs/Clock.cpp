@@ -0,0 +1,26 @@
+#include <ctime>
+#include "Clock.hpp"
+
+/**
+ * @brief Get the current monotonic time.
+ *
+ * @return long : Milliseconds since an unspecified starting point
+ */
+long Clock::nowMs(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<long>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Get the current monotonic time, for measuring short durations.
+ *
+ * @return long : Nanoseconds since an unspecified starting point
+ */
+long Clock::nowNs(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<long>(now.tv_sec) * 1000000000L + now.tv_nsec;
+}
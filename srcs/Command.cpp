@@ -1,3 +1,4 @@
+#include <cstdio>
 #include "Command.hpp"
 
 #include "Server.hpp"
@@ -6,32 +7,95 @@
 #include "Message.hpp"
 
 #include "FormatValidator.hpp"
-#include "Reply.hpp"
+#include "NumericReply.hpp"
+#include "Stats.hpp"
+#include "Clock.hpp"
+#include "Logger.hpp"
 #include "CommonValue.hpp"
 
+/**
+ * @brief Build an entry of the dispatch table
+ */
+#define COMMAND_ENTRY(name, handler, isNeedAuth) { name, sizeof(name) - 1, handler, isNeedAuth }
+#define EMPTY_ENTRY { NULL, 0, NULL, false }
+
+/**
+ * @brief Dispatch table, indexed by hashOf(command).
+ *  The hash is perfect for the commands below. Adding a command means
+ *  checking it lands on an empty slot, or changing hashOf() so that all do;
+ *  tests/command_test checks every command is found at its slot.
+ */
+const Command::Entry Command::_table[Command::TABLE_SIZE] = {
+	EMPTY_ENTRY,											// 0
+	COMMAND_ENTRY("KICK", &Command::cmdKick, true),			// 1
+	COMMAND_ENTRY("NOTICE", &Command::cmdNotice, true),		// 2
+	COMMAND_ENTRY("QUIT", &Command::cmdQuit, false),		// 3
+	EMPTY_ENTRY,											// 4
+	EMPTY_ENTRY,											// 5
+	COMMAND_ENTRY("PING", &Command::cmdPing, false),		// 6
+	COMMAND_ENTRY("NICK", &Command::cmdNick, false),		// 7
+	COMMAND_ENTRY("PRIVMSG", &Command::cmdPrivmsg, true),	// 8
+	EMPTY_ENTRY,											// 9
+	COMMAND_ENTRY("PART", &Command::cmdPart, true),			// 10
+	COMMAND_ENTRY("PASS", &Command::cmdPass, false),		// 11
+	COMMAND_ENTRY("STATS", &Command::cmdStats, true),		// 12
+	COMMAND_ENTRY("JOIN", &Command::cmdJoin, true),			// 13
+	COMMAND_ENTRY("PONG", &Command::cmdPong, false),		// 14
+	COMMAND_ENTRY("USER", &Command::cmdUser, false)			// 15
+};
+
+/**
+ * @brief Upper case of an ASCII letter. Other bytes are returned as is.
+ */
+static inline unsigned char toUpper(char c) {
+	return (c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c;
+}
+
+/**
+ * @brief Slot of a command in the dispatch table, ignoring case.
+ *  Every command is at least 4 characters long, so the hash mixes the
+ *  first 3 characters with the length.
+ *
+ * @param name Command, at least 3 characters long
+ * @param length Length of the command
+ * @return size_t : Slot index, below TABLE_SIZE
+ */
+static inline size_t hashOf(const char *name, size_t length) {
+	return (2 * toUpper(name[0]) + 4 * toUpper(name[1]) + toUpper(name[2]) + length) % COMMAND_TABLE_SIZE;
+}
+
 /**
  * @brief Construct a new Command:: Command object
  * 
  * @param server Save server class reference for execute commands
  */
-Command::Command(Server& server): _server(server) {
-	_commands.insert(make_pair("PRIVMSG", &Command::cmdPrivmsg));
-	_commands.insert(make_pair("JOIN", &Command::cmdJoin));
-	_commands.insert(make_pair("PART", &Command::cmdPart));
-	_commands.insert(make_pair("PASS", &Command::cmdPass));
-	_commands.insert(make_pair("NICK", &Command::cmdNick));
-	_commands.insert(make_pair("USER", &Command::cmdUser));
-	_commands.insert(make_pair("PING", &Command::cmdPing));
-	_commands.insert(make_pair("QUIT", &Command::cmdQuit));
-	_commands.insert(make_pair("KICK", &Command::cmdKick));
-	_commands.insert(make_pair("NOTICE", &Command::cmdNotice));
-}
+Command::Command(Server& server): _server(server) { }
 
 /**
  * @brief Destroy the Command:: Command object
  */
-Command::~Command() {
-	_commands.clear();
+Command::~Command() { }
+
+/**
+ * @brief Find the entry of a command, ignoring case.
+ *  The one candidate slot, hashOf(command), is compared in full.
+ * 
+ * @param cmd Command of a received message
+ * @return const Command::Entry* : Matching entry. NULL if the command is unknown.
+ */
+const Command::Entry *Command::lookup(const StringView& cmd) {
+	const char *name = cmd.data();
+	const size_t length = cmd.length();
+
+	if (length < 4) return NULL;
+
+	const Entry& entry = _table[hashOf(name, length)];
+
+	if (entry.length != length) return NULL;
+	for (size_t i = 0; i < length; ++i) {
+		if (toUpper(name[i]) != static_cast<unsigned char>(entry.name[i])) return NULL;
+	}
+	return &entry;
 }
 
 /**
@@ -44,18 +108,25 @@ Command::~Command() {
  * @return false : Notify the server that buffer checks are no longer needed
  */
 bool Command::run(User *user, const Message& msg) {
-	const string& prefix = msg.getPrefix();
-	const string& cmd = msg.getCommand();
+	const StringView& prefix = msg.getPrefix();
 
 	if (!prefix.empty() && prefix != user->getNickname()) return true;
-	if (!user->getAuth() && isCommandNeedAuth(cmd)) return true;
 
-	try {
-		return (this->*_commands.at(cmd))(user, msg);
-	} catch (out_of_range &e) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_UNKNOWNCOMMAND << user->getNickname() << cmd << ERR_UNKNOWNCOMMAND_MSG);
+	const Entry *entry = lookup(msg.getCommand());
+
+	Stats::local().countCommand(entry != NULL ? entry - _table : TABLE_SIZE);
+	if (entry == NULL) {
+		// Unknown commands are only answered once registered, like any command needing auth.
+		if (user->getAuth()) user->addNumericReply(NumericReply::unknownCommand, msg.getCommand());
+		return true;
 	}
-	return true;
+	if (entry->isNeedAuth && !user->getAuth()) return true;
+
+	const long startNs = Clock::nowNs();
+	const bool result = (this->*entry->handler)(user, msg);
+
+	Stats::local().recordCommand(entry - _table, Clock::nowNs() - startNs);
+	return result;
 }
 
 /**
@@ -63,7 +134,7 @@ bool Command::run(User *user, const Message& msg) {
  */
 bool Command::cmdPrivmsg(User *user, const Message& msg) {
     if (msg.paramSize() < 2) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NORECIPIENT << user->getNickname() << ERR_NORECIPIENT_MSG << "(PRIVMSG)");
+		user->addNumericReply(NumericReply::noRecipientPrivmsg);
 		return true;
 	}
 
@@ -74,20 +145,21 @@ bool Command::cmdPrivmsg(User *user, const Message& msg) {
             Channel *targetChannel = _server.findChannelByName(targetName);
 
             if (targetChannel == NULL) {
-				user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NOSUCHNICK << user->getNickname() << targetName << ERR_NOSUCHNICK_MSG);
+				user->addNumericReply(NumericReply::noSuchNick, targetName);
 				continue;
 			}
-            targetChannel->broadcast(Message() << ":" << user->getSource() << msg.getCommand() << targetChannel->getName() << ":" << msg.getParams()[1], user->getFd());
+            targetChannel->broadcast(Message() << user->getPrefix() << "PRIVMSG" << targetChannel->getName() << ":" << msg.getParams()[1], user->getFd());
 			if (msg.getParams()[1][0] == '!') targetChannel->executeBot(msg.getParams()[1]);
         } else {
             User *targetUser;
+            string targetNickname;
 
-            targetUser = _server.findClientByNickname(targetName);
+            targetUser = _server.findClientByNickname(targetName, targetNickname);
             if (targetUser == NULL) {
-				user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NOSUCHNICK << user->getNickname() << targetName << ERR_NOSUCHNICK_MSG);
+				user->addNumericReply(NumericReply::noSuchNick, targetName);
 				continue;
 			}
-            targetUser->addToReplyBuffer(Message() << ":" << user->getSource() << msg.getCommand() << targetUser->getNickname() << ":" << msg.getParams()[1]);
+            targetUser->addToReplyBuffer(Message() << user->getPrefix() << "PRIVMSG" << targetNickname << ":" << msg.getParams()[1]);
         }
     }
 	return true;
@@ -100,27 +172,25 @@ bool Command::cmdPrivmsg(User *user, const Message& msg) {
  */
 bool Command::cmdJoin(User *user, const Message& msg) {
     if (msg.paramSize() == 0) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NEEDMOREPARAMS << user->getNickname() << msg.getCommand() << ERR_NEEDMOREPARAMS_MSG);
+		user->addNumericReply(NumericReply::needMoreParams, msg.getCommand());
 		return true;
 	}
     
     const vector<string> targetList = Message::split(msg.getParams()[0], ',');
 	// A parameter of 0 leaves all participating channels.
     if (targetList.size() == 1 && targetList[0] == "0") {
-        vector<string> removeWaitingChannels;
 		const vector<Channel *>& chs = user->getMyAllChannel();
         for (vector<Channel *>::const_iterator it = chs.begin(); it != chs.end(); ++it) {
 			Channel *targetChannel = *it;
 			
+			// Kicked from it meanwhile
+			if (targetChannel->findUser(user->getFd()) != user) continue;
             const int remainUserOfChannel = targetChannel->deleteUser(user->getFd());
-			user->addToReplyBuffer(Message() << ":" << user->getSource() << "PART" << targetChannel->getName());
-			targetChannel->broadcast(Message() << ":" << user->getSource() << "PART" << targetChannel->getName());
-            if (remainUserOfChannel == 0) removeWaitingChannels.push_back(targetChannel->getName());
+			user->addToReplyBuffer(Message() << user->getPrefix() << "PART" << targetChannel->getName());
+			targetChannel->broadcast(Message() << user->getPrefix() << "PART" << targetChannel->getName());
+            if (remainUserOfChannel == 0) _server.deleteChannel(targetChannel);
         }
 		user->clearMyChannelList();
-        for (vector<string>::iterator it = removeWaitingChannels.begin(); it != removeWaitingChannels.end(); ++it) {
-            _server.deleteChannel(*it);
-        }
         return true;
     }
 
@@ -128,42 +198,35 @@ bool Command::cmdJoin(User *user, const Message& msg) {
     for (vector<string>::const_iterator it = targetList.begin(); it != targetList.end(); ++it) {
         string targetChannelName = *it;
         if (targetChannelName[0] != '#') {
-			user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NOSUCHCHANNEL << user->getNickname() << targetChannelName << ERR_NOSUCHCHANNEL_MSG);
+			user->addNumericReply(NumericReply::noSuchChannel, targetChannelName);
 			continue;
 		}
 		if (targetChannelName.length() > 31) targetChannelName.erase(MAX_CHANNELNAME_LEN);
 		if (!FormatValidator::isValidChannelname(targetChannelName)) {
-			user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_ERRONEUSCHANNELNAME << user->getNickname() << targetChannelName << ERR_ERRONEUSCHANNELNAME_MSG);
+			user->addNumericReply(NumericReply::erroneusChannelname, targetChannelName);
 			continue;
 		}
 
         Channel *targetChannel;
 
         targetChannel = _server.findChannelByName(targetChannelName);
-		// Channel with that name does not exist
-        if (targetChannel == NULL) {
+		// User is already participating in that channel
+        if (targetChannel != NULL && targetChannel->findUser(user->getFd()) != NULL) continue;
+		
+		// Join the user on that channel. Create it if the name is free, or if
+		// its last member left meanwhile (a closed channel takes no member).
+        while (targetChannel == NULL || !targetChannel->addUser(user->getFd(), user)) {
+			if (targetChannel != NULL) _server.deleteChannel(targetChannel);
             targetChannel = _server.addChannel(targetChannelName);
 			if (targetChannel == NULL) {
-				user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_UNAVAILRESOURCE << targetChannelName << ERR_UNAVAILRESOURCE_MSG);
+				user->addNumericReply(NumericReply::unavailResource, targetChannelName);
 				return true;
 			}
-		// User is already participating in that channel
-        } else if (targetChannel->findUser(user->getFd()) != NULL) continue;
-		
-		// Join the user on that channel
-        targetChannel->addUser(user->getFd(), user);
-		user->addToMyChannelList(targetChannel);
-		Message replyMsg[3];
-		replyMsg[0] << ":" << user->getSource() << msg.getCommand() << ":" << targetChannelName;
-		replyMsg[1] << ":" << SERVER_HOSTNAME << RPL_NAMREPLY << user->getNickname() << "=" << targetChannelName << ":";
-		vector<string> targetChannelUserList = targetChannel->getUserList();
-		for (vector<string>::iterator it = targetChannelUserList.begin(); it != targetChannelUserList.end(); ++it) {
-			replyMsg[1] << *it;
 		}
-		replyMsg[2] << ":" << SERVER_HOSTNAME << RPL_ENDOFNAMES << user->getNickname() << targetChannelName << RPL_ENDOFNAMES_MSG;
-		targetChannel->broadcast(replyMsg[0]);
-		user->addToReplyBuffer(replyMsg[1]);		
-		user->addToReplyBuffer(replyMsg[2]);
+		user->addToMyChannelList(targetChannel);
+		targetChannel->broadcast(Message() << user->getPrefix() << "JOIN" << ":" << targetChannel->getName());
+		user->addNumericReply(NumericReply::namReply, StringView("=", 1), targetChannel->getName(), targetChannel->getUserList());
+		user->addNumericReply(NumericReply::endOfNames, targetChannel->getName());
     }
 	return true;
 }
@@ -173,7 +236,7 @@ bool Command::cmdJoin(User *user, const Message& msg) {
  */
 bool Command::cmdPart(User *user, const Message& msg) {
 	if (msg.paramSize() < 1) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NEEDMOREPARAMS << user->getNickname() << msg.getCommand() << ERR_NEEDMOREPARAMS_MSG);
+		user->addNumericReply(NumericReply::needMoreParams, msg.getCommand());
 		return true;
 	}
 
@@ -191,18 +254,20 @@ bool Command::cmdPart(User *user, const Message& msg) {
         targetChannel = _server.findChannelByName(targetChannelName);
 
         if (targetChannel == NULL) {
-			user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NOSUCHCHANNEL << user->getNickname() << targetChannelName << ERR_NOSUCHCHANNEL_MSG);
+			user->addNumericReply(NumericReply::noSuchChannel, targetChannelName);
 			continue;
 		}
 		if (targetChannel->findUser(user->getFd()) == NULL) {
-			user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NOTONCHANNEL << user->getNickname() << targetChannelName << ERR_NOTONCHANNEL_MSG);
+			user->addNumericReply(NumericReply::notOnChannel, targetChannelName);
+			// Kicked from it: drop it from the list too
+			user->deleteFromMyChannelList(targetChannel);
 			continue;
 		}
         const int remainUserOfChannel = targetChannel->deleteUser(user->getFd());
+		user->addToReplyBuffer(Message() << user->getPrefix() << "PART" << targetChannel->getName() << partNotiMessage);
+		targetChannel->broadcast(Message() << user->getPrefix() << "PART" << targetChannel->getName() << partNotiMessage);
+        if (remainUserOfChannel == 0) _server.deleteChannel(targetChannel);
 		user->deleteFromMyChannelList(targetChannel);
-		user->addToReplyBuffer(Message() << ":" << user->getSource() << "PART" << targetChannelName << partNotiMessage);
-		targetChannel->broadcast(Message() << ":" << user->getSource() << "PART" << targetChannelName << partNotiMessage);
-        if (remainUserOfChannel == 0) _server.deleteChannel(targetChannelName);
     }
 	return true;
 }
@@ -212,11 +277,11 @@ bool Command::cmdPart(User *user, const Message& msg) {
  */
 bool Command::cmdPass(User *user, const Message& msg) {
 	if (msg.paramSize() < 1) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NEEDMOREPARAMS << user->getNickname() << msg.getCommand() << ERR_NEEDMOREPARAMS_MSG);
+		user->addNumericReply(NumericReply::needMoreParams, msg.getCommand());
 		return true;
 	}
 	if (user->getAuth()) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_ALREADYREGISTERED << user->getNickname() << ERR_ALREADYREGISTERED_MSG);
+		user->addNumericReply(NumericReply::alreadyRegistered);
 		return true;
 	}
 	user->setPassword(msg.getParams()[0]);
@@ -228,41 +293,41 @@ bool Command::cmdPass(User *user, const Message& msg) {
  */
 bool Command::cmdNick(User *user, const Message& msg) {
 	if (msg.paramSize() < 1) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NEEDMOREPARAMS << user->getNickname() << msg.getCommand() << ERR_NEEDMOREPARAMS_MSG);
+		user->addNumericReply(NumericReply::needMoreParams, msg.getCommand());
 		return true;
 	}
 	string requestNickname = msg.getParams()[0];
 	const string originNickname = user->getNickname();
 
 	if (requestNickname.length() == 0) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NONICKNAMEGIVEN << originNickname << ERR_NONICKNAMEGIVEN_MSG);
+		user->addNumericReply(NumericReply::noNicknameGiven);
 		return true;
 	}
 
-	if (_server.findClientByNickname(requestNickname) != NULL) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NICKNAMEINUSE << originNickname << requestNickname << ERR_NICKNAMEINUSE_MSG);
-		return true;
-	}
-	
 	if (requestNickname.length() > MAX_NICKNAME_LEN) requestNickname = requestNickname.erase(MAX_NICKNAME_LEN);
 	if (!FormatValidator::isValidNickname(requestNickname)) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_ERRONEUSNICKNAME << requestNickname << ERR_ERRONEUSNICKNAME_MSG);
+		user->addNumericReply(NumericReply::erroneusNickname, requestNickname);
+		return true;
+	}
+	if (!_server.renameClient(user, requestNickname)) {
+		user->addNumericReply(NumericReply::nicknameInUse, requestNickname);
 		return true;
 	}
-	user->setNickname(requestNickname);
 	if (!user->getAuth() && !user->getUsername().empty()) {
 		if (_server.checkPassword(user->getPassword())) {
 			user->setAuth();
-			user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << RPL_WELCOME << user->getNickname() << ":Welcome to the" << SERVER_HOSTNAME <<  "Network" << requestNickname);
+			user->addNumericReply(NumericReply::welcome, StringView(), StringView(), StringView(user->getPrefix().data() + 1, user->getPrefix().length() - 1));
+			user->addReplyBurst(_server.getWelcomeBurst());
 			return true;
 		} else {
-			user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_PASSWDMISMATCH << user->getNickname() << ERR_PASSWDMISMATCH_MSG);
-			_server.disconnectClient(user->getFd());
+			user->addNumericReply(NumericReply::passwdMismatch);
+			_server.disconnectClient(user);
 			return false;
 		}
 	}
-	if (user->getMyAllChannel().empty()) user->addToReplyBuffer(Message() << ":" << originNickname << msg.getCommand() << requestNickname);
-	else user->broadcastToMyChannels(Message() << ":" << originNickname << msg.getCommand() << requestNickname);
+	// With no channel left, the user still gets its own NICK.
+	if (!user->broadcastToMyChannels(Message() << ":" << originNickname << "NICK" << requestNickname))
+		user->addToReplyBuffer(Message() << ":" << originNickname << "NICK" << requestNickname);
 	return true;
 }
 
@@ -271,19 +336,19 @@ bool Command::cmdNick(User *user, const Message& msg) {
  */
 bool Command::cmdUser(User *user, const Message& msg) {
 	if (msg.paramSize() < 4) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NEEDMOREPARAMS << user->getNickname() << msg.getCommand() << ERR_NEEDMOREPARAMS_MSG);
+		user->addNumericReply(NumericReply::needMoreParams, msg.getCommand());
 		return true;
 	}
 	
 	if (user->getAuth()) { // 이미 auth되어 있는 user
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_ALREADYREGISTERED << user->getNickname() << ERR_ALREADYREGISTERED_MSG);
+		user->addNumericReply(NumericReply::alreadyRegistered);
 		return true;
 	}
 	
 	const string requestUserNickname = msg.getParams()[0]; //username
 	
 	if (requestUserNickname.length() == 0) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NEEDMOREPARAMS << user->getNickname() << msg.getCommand() << ERR_NEEDMOREPARAMS_MSG);
+		user->addNumericReply(NumericReply::needMoreParams, msg.getCommand());
 		return true;
 	}
 	
@@ -291,12 +356,13 @@ bool Command::cmdUser(User *user, const Message& msg) {
 	if (user->getNickname() != "*") {
 		if (_server.checkPassword(user->getPassword())) {
 			user->setAuth();
-			user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << RPL_WELCOME << user->getNickname() << ":Welcome to the" << SERVER_HOSTNAME <<  "Network" << requestUserNickname);
+			user->addNumericReply(NumericReply::welcome, StringView(), StringView(), StringView(user->getPrefix().data() + 1, user->getPrefix().length() - 1));
+			user->addReplyBurst(_server.getWelcomeBurst());
 			return true;
 		}
 		else {
-			user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_PASSWDMISMATCH << user->getNickname() << ERR_PASSWDMISMATCH_MSG);
-			_server.disconnectClient(user->getFd());
+			user->addNumericReply(NumericReply::passwdMismatch);
+			_server.disconnectClient(user);
 			return false;
 		}
 	}
@@ -308,12 +374,12 @@ bool Command::cmdUser(User *user, const Message& msg) {
  */
 bool Command::cmdPing(User *user, const Message& msg) {
 	if (msg.paramSize() < 1) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NEEDMOREPARAMS << user->getNickname() << msg.getCommand() << ERR_NEEDMOREPARAMS_MSG);
+		user->addNumericReply(NumericReply::needMoreParams, msg.getCommand());
 		return true;
 	}
 
 	if (msg.getParams()[0].empty()) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NOORIGIN << user->getNickname() << ERR_NOORIGIN_MSG);
+		user->addNumericReply(NumericReply::noOrigin);
 		return true;
 	}
 
@@ -321,6 +387,16 @@ bool Command::cmdPing(User *user, const Message& msg) {
 	return true;
 }
 
+/**
+ * @brief PONG(IRC command) : Answer to a keepalive PING of the server.
+ * 	Receiving it already marked the user alive, so there is nothing left to do.
+ */
+bool Command::cmdPong(User *user, const Message& msg) {
+	(void)user;
+	(void)msg;
+	return true;
+}
+
 /**
  * @brief QUIT(IRC command) :  User leaves the server.
  */
@@ -331,7 +407,7 @@ bool Command::cmdQuit(User *user, const Message& msg) {
 
 	user->clearCmdBuffer();
 	user->setReplyBuffer("\r\nERROR :Closing Link: " + user->getHost() + " " + reason + "\r\n");
-	user->broadcastToMyChannels(Message() << ":" << user->getSource() << msg.getCommand() << reason, user->getFd());
+	user->broadcastToMyChannels(Message() << user->getPrefix() << "QUIT" << reason, user->getFd());
 	user->setIsQuiting();
 	return false;
 }
@@ -340,25 +416,27 @@ bool Command::cmdQuit(User *user, const Message& msg) {
  * @brief KICK(IRC command) :  Channel operator kick user from channel.
  */
 bool Command::cmdKick(User *user, const Message& msg) {
-	if (msg.paramSize() < 2)
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NEEDMOREPARAMS << user->getNickname() << msg.getCommand() << ERR_NEEDMOREPARAMS_MSG);
+	if (msg.paramSize() < 2) {
+		user->addNumericReply(NumericReply::needMoreParams, msg.getCommand());
+		return true;
+	}
 	
 	// 해당 channel이 존재하는 지 check
 	Channel *targetChannel = _server.findChannelByName(msg.getParams()[0]);
 	if (targetChannel == NULL) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NOSUCHCHANNEL << user->getNickname() << msg.getParams()[0] << ERR_NOSUCHCHANNEL_MSG);
+		user->addNumericReply(NumericReply::noSuchChannel, msg.getParams()[0]);
 		return true;
 	}
 	
 	// User가 channel에 있는 지 check
-	if (targetChannel->findUser(user->getFd()) == NULL) {\
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NOTONCHANNEL << user->getNickname() << msg.getParams()[0] << ERR_NOTONCHANNEL_MSG);
+	if (targetChannel->findUser(user->getFd()) == NULL) {
+		user->addNumericReply(NumericReply::notOnChannel, msg.getParams()[0]);
 		return true;
 	}
 
 	// User가 해당 channel의 operator인지
 	if (targetChannel->isUserOper(user->getFd()) == false) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_CHANOPRIVSNEEDED << user->getNickname() << msg.getParams()[0] << ERR_CHANOPRIVSNEEDED_MSG);
+		user->addNumericReply(NumericReply::chanOprivsNeeded, msg.getParams()[0]);
 		return true;
 	}
 
@@ -372,18 +450,19 @@ bool Command::cmdKick(User *user, const Message& msg) {
 
 	for (vector<string>::const_iterator it = targetUsers.begin(); it != targetUsers.end(); ++it) {
 		// target User가 channel에 존재하는지
-		User *targetUser = targetChannel->findUser(*it);
+		string targetNickname;
+		User *targetUser = targetChannel->findUser(*it, &targetNickname);
 
 		if (targetUser == NULL) {
-			user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_USERNOTINCHANNEL << user->getNickname() << *it << msg.getParams()[0] << ERR_USERNOTINCHANNEL_MSG);
+			user->addNumericReply(NumericReply::userNotInChannel, *it, msg.getParams()[0]);
 			continue;
 		}
 
 		// 존재하면 Kick (그 channel에 deleteUser)
-		targetChannel->broadcast(Message() << ":" << user->getSource() << msg.getCommand() << msg.getParams()[0] << *it << reason);
+		// The channel list of the target belongs to its reactor: it drops the channel itself later.
+		targetChannel->broadcast(Message() << user->getPrefix() << "KICK" << targetChannel->getName() << targetNickname << reason);
 		const int remainUsers = targetChannel->deleteUser(targetUser->getFd());
-		if (remainUsers == 0) _server.deleteChannel(targetChannel->getName());
-		targetUser->deleteFromMyChannelList(targetChannel);
+		if (remainUsers == 0) _server.deleteChannel(targetChannel);
 	}
 	return true;
 }
@@ -393,11 +472,11 @@ bool Command::cmdKick(User *user, const Message& msg) {
  */
 bool Command::cmdNotice(User *user, const Message& msg) {
 	if (msg.paramSize() == 0) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NORECIPIENT << user->getNickname() << ERR_NORECIPIENT_MSG << "(NOTICE)");
+		user->addNumericReply(NumericReply::noRecipientNotice);
 		return true;
 	}
 	if (msg.paramSize() == 1) {
-		user->addToReplyBuffer(Message() << ":" << SERVER_HOSTNAME << ERR_NOTEXTTOSEND << user->getNickname() << msg.getCommand() << ERR_NOTEXTTOSEND_MSG);
+		user->addNumericReply(NumericReply::noTextToSend);
 		return true;
 	}
 
@@ -409,20 +488,110 @@ bool Command::cmdNotice(User *user, const Message& msg) {
 
             targetChannel = _server.findChannelByName(targetName);
             if (targetChannel == NULL) continue;
-            targetChannel->broadcast(Message() << ":" << user->getSource() << msg.getCommand() << targetName << ":" << msg.getParams()[1]);
+            targetChannel->broadcast(Message() << user->getPrefix() << "NOTICE" << targetChannel->getName() << ":" << msg.getParams()[1]);
         } else {
             User *targetUser;
+            string targetNickname;
 
-            targetUser = _server.findClientByNickname(targetName);
+            targetUser = _server.findClientByNickname(targetName, targetNickname);
             if (targetUser == NULL) continue;
-            targetUser->addToReplyBuffer(Message() << ":" << user->getSource() << msg.getCommand() << targetName << ":" << msg.getParams()[1]);
+            targetUser->addToReplyBuffer(Message() << user->getPrefix() << "NOTICE" << targetNickname << ":" << msg.getParams()[1]);
         }
     }
 	return true;
 }
 
-bool Command::isCommandNeedAuth(const string& cmd) {
-	if (cmd == "PASS" || cmd == "NICK" || cmd == "USER" || cmd == "PING" || cmd == "QUIT") return false;
+/**
+ * @brief Add a "<counter> <value>" line to a STATS t report.
+ */
+static void addStatsLine(User *user, const char *name, unsigned long value) {
+	char line[64];
+	const int length = snprintf(line, sizeof(line), "%s %lu", name, value);
+
+	user->addNumericReply(NumericReply::statsDebug, StringView(), StringView(), StringView(line, length));
+}
 
+/**
+ * @brief Add a "<name> count=<n> p50=<ns> p99=<ns> p999=<ns> max=<ns>" line to a STATS l report.
+ */
+static void addLatencyLine(User *user, const char *name, const LatencyHistogram::Snapshot& histogram) {
+	char line[160];
+	const int length = snprintf(line, sizeof(line), "%s count=%lu p50=%lu p99=%lu p999=%lu max=%lu", name,
+								histogram.getCount(), histogram.getPercentile(0.5), histogram.getPercentile(0.99),
+								histogram.getPercentile(0.999), histogram.getMax());
+
+	user->addNumericReply(NumericReply::statsDebug, StringView(), StringView(), StringView(line, length));
+}
+
+/**
+ * @brief STATS(IRC command) : Report the counters of the server, summed over the reactors.
+ * 	m : RPL_STATSCOMMANDS, how many times each command was run
+ * 	t : RPL_STATSDEBUG, bytes in/out, broadcasts and their deliveries, accepted/rejected
+ * 		connections, unknown commands, unsent reply bytes (in total now, and the
+ * 		largest one client queue so far, from the gauges of each reactor), and
+ * 		log records dropped by the logger
+ * 	l : RPL_STATSDEBUG, latency percentiles in nanoseconds of each command handler that ran,
+ * 		of event dispatch, and of the loop lag (a whole loop iteration after the wait)
+ * 	r : Reset the latency histograms
+ * 	Every query, known or not, ends with RPL_ENDOFSTATS.
+ */
+bool Command::cmdStats(User *user, const Message& msg) {
+	const StringView query = msg.paramSize() >= 1 ? msg.getParams()[0] : StringView("*", 1);
+	const char letter = query.length() == 1 ? toUpper(query[0]) : '\0';
+
+	if (letter == 'M' || letter == 'T') {
+		const Stats::Snapshot stats = _server.collectStats();
+		char count[32];
+
+		if (letter == 'M') {
+			for (size_t i = 0; i < TABLE_SIZE; ++i) {
+				if (_table[i].name == NULL) continue;
+				user->addNumericReply(NumericReply::statsCommands, StringView(_table[i].name, _table[i].length),
+									  StringView(count, snprintf(count, sizeof(count), "%lu", stats.commands[i])));
+			}
+		} else {
+			for (size_t i = 0; i < Stats::COUNTER_NUM; ++i)
+				addStatsLine(user, Stats::getName(static_cast<Stats::Counter>(i)), stats.counters[i]);
+			addStatsLine(user, "unknown_commands", stats.commands[TABLE_SIZE]);
+			addStatsLine(user, "sendq_bytes", stats.sendQBytes);
+			addStatsLine(user, "sendq_peak_bytes", stats.sendQPeakBytes);
+			addStatsLine(user, "log_dropped", Logger::getDroppedNum());
+		}
+	} else if (letter == 'L') {
+		Stats::Latencies latencies;
+
+		_server.collectLatencies(latencies);
+		for (size_t i = 0; i < TABLE_SIZE; ++i) {
+			if (latencies.commands[i].getCount() != 0) addLatencyLine(user, _table[i].name, latencies.commands[i]);
+		}
+		addLatencyLine(user, "event", latencies.event);
+		addLatencyLine(user, "loop_lag", latencies.loopLag);
+	} else if (letter == 'R') {
+		_server.resetLatencies();
+	}
+	user->addNumericReply(NumericReply::endOfStats, query);
 	return true;
 }
+
+/**
+ * @brief Get the command of a dispatch table slot, to name the counters of Stats::Snapshot.
+ *
+ * @param slot Slot index. TABLE_SIZE stands for the unknown commands.
+ * @return const char* : Command name. NULL for an empty slot.
+ */
+const char *Command::getName(size_t slot) {
+	if (slot >= TABLE_SIZE) return "unknown";
+	return _table[slot].name;
+}
+
+/**
+ * @brief Get the dispatch table slot a command is run from, ignoring case.
+ *
+ * @param cmd Command of a received message
+ * @return size_t : Slot index. TABLE_SIZE if the command is unknown.
+ */
+size_t Command::getSlot(const StringView& cmd) {
+	const Entry *entry = lookup(cmd);
+
+	return entry != NULL ? entry - _table : TABLE_SIZE;
+}
@@ -0,0 +1,161 @@
+#ifdef __linux__
+
+#include <stdexcept>
+#include <unistd.h>
+#include "EpollPoller.hpp"
+#include "CommonValue.hpp"
+
+/**
+ * @brief Construct a new EpollPoller:: Create epoll instance.
+ * @throw Throw runtime_error if epoll creation fails.
+ */
+EpollPoller::EpollPoller(void): _epfd(UNDEFINED_FD) {
+    if ((_epfd = epoll_create1(EPOLL_CLOEXEC)) == ERR_RETURN)
+        throw(runtime_error("epoll_create1() error"));
+}
+
+/**
+ * @brief Destroy the EpollPoller:: Close epoll fd
+ */
+EpollPoller::~EpollPoller() {
+    if (_epfd != UNDEFINED_FD) close(_epfd);
+}
+
+/**
+ * @brief Queue the interest of a fd. Only the last queued interest of
+ *  each fd is submitted by submitChanges().
+ *
+ * @param fd Socket fd
+ * @param udata User-data returned with every event of that fd.
+ * @param watchWrite Also report write readiness if true.
+ */
+void EpollPoller::queueChange(int fd, void *udata, bool watchWrite) {
+    if (_fdStates.size() <= static_cast<size_t>(fd)) _fdStates.resize(fd + 1);
+
+    FdState& state = _fdStates[fd];
+
+    state.fd = fd;
+    state.udata = udata;
+    state.wanted = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    if (watchWrite) state.wanted |= EPOLLOUT;
+    if (!state.isChanged) {
+        state.isChanged = true;
+        _changedFds.push_back(fd);
+    }
+    countChange();
+}
+
+/**
+ * @brief Hand queued interests that differ from the kernel's to epoll_ctl.
+ * @throw Throw runtime_error if epoll_ctl fails.
+ */
+void EpollPoller::submitChanges(void) {
+    struct epoll_event event;
+    unsigned long submitted = 0;
+
+    for (size_t i = 0; i < _changedFds.size(); ++i) {
+        const int fd = _changedFds[i];
+        FdState& state = _fdStates[fd];
+
+        state.isChanged = false;
+        if (state.wanted == state.registered) continue;
+
+        event.events = state.wanted;
+        event.data.ptr = &state;
+        if (epoll_ctl(_epfd, state.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event) == ERR_RETURN) {
+            _changedFds.erase(_changedFds.begin(), _changedFds.begin() + i + 1);
+            throw(runtime_error("epoll_ctl() error"));
+        }
+        state.registered = state.wanted;
+        ++submitted;
+    }
+    _changedFds.clear();
+    countSubmit(submitted, submitted);
+}
+
+/**
+ * @brief Register fd to epoll as edge-triggered. Submitted on next wait().
+ *
+ * @param fd Socket fd
+ * @param udata User-data returned with every event of that fd.
+ * @param watchWrite Also report write readiness if true.
+ */
+void EpollPoller::addFd(int fd, void *udata, bool watchWrite) {
+    queueChange(fd, udata, watchWrite);
+}
+
+/**
+ * @brief Turn write readiness reports of a registered fd on or off. Submitted on next wait().
+ *  Turning it on for a socket that is already writable reports it on the next wait().
+ *
+ * @param fd Socket fd
+ * @param udata User-data returned with every event of that fd.
+ * @param watchWrite Report write readiness if true.
+ */
+void EpollPoller::setWriteInterest(int fd, void *udata, bool watchWrite) {
+    queueChange(fd, udata, watchWrite);
+}
+
+/**
+ * @brief Unregister fd from epoll right away with EPOLL_CTL_DEL, so the fd
+ *  reports nothing on the next wait() even if it is closed much later.
+ *  A fd whose interest was only queued is just dropped from the queue.
+ *  Events of the fd still in the current batch come with NULL user-data.
+ *
+ * @param fd Socket fd
+ */
+void EpollPoller::removeFd(int fd) {
+    if (static_cast<size_t>(fd) >= _fdStates.size()) return ;
+
+    FdState& state = _fdStates[fd];
+
+    if (state.registered) {
+        epoll_ctl(_epfd, EPOLL_CTL_DEL, fd, NULL);
+        countSubmit(1, 1);
+    }
+    state.udata = NULL;
+    state.registered = 0;
+    state.wanted = 0;
+    countChange();
+}
+
+/**
+ * @brief Submit queued changes and wait for readiness of registered fds.
+ *  Each ready event carries the state of its fd, where fd and user-data are read.
+ *
+ * @param events Array to fill with ready events
+ * @param maxEvents Capacity of events
+ * @param timeoutMs Timeout in milliseconds. -1 blocks until an event happens.
+ * @return int : Number of filled events. ERR_RETURN on failure with errno set.
+ * @throw Throw runtime_error if a queued change fails.
+ */
+int EpollPoller::wait(PollEvent *events, int maxEvents, int timeoutMs) {
+    int numOfEvents;
+
+    if (!_changedFds.empty()) submitChanges();
+    if (_readyEvents.size() < static_cast<size_t>(maxEvents)) _readyEvents.resize(maxEvents);
+    numOfEvents = epoll_wait(_epfd, &_readyEvents[0], maxEvents, timeoutMs);
+    countWait(numOfEvents, maxEvents);
+    for (int i = 0; i < numOfEvents; ++i) {
+        const struct epoll_event& ready = _readyEvents[i];
+        const FdState& state = *static_cast<const FdState *>(ready.data.ptr);
+
+        events[i].fd = state.fd;
+        events[i].udata = state.udata;
+        events[i].readable = ready.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP);
+        events[i].writable = ready.events & EPOLLOUT;
+        events[i].error = ready.events & EPOLLERR;
+    }
+    return numOfEvents;
+}
+
+/**
+ * @brief Get backend name
+ *
+ * @return const char* : "epoll"
+ */
+const char *EpollPoller::getName(void) const {
+    return "epoll";
+}
+
+#endif
@@ -1,4 +1,37 @@
 #include "FormatValidator.hpp"
+#include "ByteScanner.hpp"
+
+/**
+ * @brief Build the byte set of characters that can start a nickname. (letter / special)
+ */
+static ByteSet makeNicknameFirstSet(void) {
+    ByteSet set;
+
+    return set.addRange('A', 'Z').addRange('a', 'z').addRange('[', '`').addRange('{', '}').build();
+}
+
+/**
+ * @brief Build the byte set of characters allowed after the first one of a nickname.
+ *  (letter / digit / special / '-')
+ */
+static ByteSet makeNicknameSet(void) {
+    ByteSet set = makeNicknameFirstSet();
+
+    return set.addRange('0', '9').add('-').build();
+}
+
+/**
+ * @brief Build the byte set of characters allowed in a channel name. (anything but BEL)
+ */
+static ByteSet makeChannelnameSet(void) {
+    ByteSet set;
+
+    return set.addAllExcept(7).build();
+}
+
+static const ByteSet nicknameFirstSet = makeNicknameFirstSet();
+static const ByteSet nicknameSet = makeNicknameSet();
+static const ByteSet channelnameSet = makeChannelnameSet();
 
 /**
  * @brief Compare whether char <A> and char <B> are the same.
@@ -20,7 +53,7 @@ bool FormatValidator::isTargetChar(const char dst, const char src) {
  * @return false 
  */
 bool FormatValidator::isLetter(const char dst) {
-    return (tolower(dst) >= 'a' && tolower(dst) <= 'z');
+    return ((dst >= 'a' && dst <= 'z') || (dst >= 'A' && dst <= 'Z'));
 }
 
 /**
@@ -53,17 +86,11 @@ bool FormatValidator::isSpecial(const char dst) {
  * @return false 
  */
 bool FormatValidator::isValidNickname(const string& nickname) {
-    string::const_iterator it = nickname.begin();
-
-    if (!isLetter(*it) && !isSpecial(*it)) return false;
+    if (nickname.empty()) return false;
+    if (!nicknameFirstSet.contains[static_cast<unsigned char>(nickname[0])]) return false;
 
-    ++it;
-    for (; it != nickname.end(); ++it) {
-        if (isLetter(*it) || isDigit(*it) || isSpecial(*it) || isTargetChar(*it, '-')) continue;
-
-        return false;
-    }
-    return true;
+    const char *end = nickname.data() + nickname.length();
+    return ByteScanner::findFirstNotIn(nickname.data() + 1, end, nicknameSet) == end;
 }
 
 /**
@@ -74,12 +101,7 @@ bool FormatValidator::isValidNickname(const string& nickname) {
  * @return false 
  */
 bool FormatValidator::isValidChannelname(const string& channelname) {
-    string::const_iterator it = channelname.begin();
-
-    for (; it != channelname.end(); ++it) {
-        if (!isTargetChar(*it, 7)) continue;
+    const char *end = channelname.data() + channelname.length();
 
-        return false;
-    }
-    return true;
+    return ByteScanner::findFirstNotIn(channelname.data(), end, channelnameSet) == end;
 }
@@ -0,0 +1,131 @@
+#include <cstring>
+#include "InputBuffer.hpp"
+#include "ByteScanner.hpp"
+#include "CommonValue.hpp"
+
+/**
+ * @brief Construct a new InputBuffer:: Empty buffer. Storage is allocated on the first read.
+ */
+InputBuffer::InputBuffer(void): _begin(0), _scan(0), _end(0), _isDiscarding(false) { }
+
+/**
+ * @brief Destroy the InputBuffer:: InputBuffer object
+ */
+InputBuffer::~InputBuffer() { }
+
+/**
+ * @brief Check that there are no unconsumed bytes.
+ * 
+ * @return true : Nothing buffered / if not return
+ * @return false 
+ */
+bool InputBuffer::empty(void) const {
+    return _begin == _end;
+}
+
+/**
+ * @brief Get number of unconsumed bytes.
+ * 
+ * @return size_t : Buffered bytes
+ */
+size_t InputBuffer::size(void) const {
+    return _end - _begin;
+}
+
+/**
+ * @brief Get the free space where recv() can write.
+ *  Moves unconsumed bytes to the front first. They are at most an
+ *  incomplete line, so the move is short and happens once per read.
+ * 
+ * @param writableBytes Set to the number of bytes that can be written
+ * @return char* : Where to write. Views from nextLine() are invalidated.
+ */
+char *InputBuffer::prepareWrite(size_t& writableBytes) {
+    if (_data.empty()) _data.resize(INPUT_BUFFER_SIZE);
+    if (_begin > 0) {
+        memmove(&_data[0], &_data[_begin], _end - _begin);
+        _scan -= _begin;
+        _end -= _begin;
+        _begin = 0;
+    }
+    writableBytes = _data.size() - _end;
+    return &_data[_end];
+}
+
+/**
+ * @brief Make bytes written after prepareWrite() part of the buffer.
+ * 
+ * @param bytes Number of bytes written
+ */
+void InputBuffer::commitWrite(size_t bytes) {
+    _end += bytes;
+}
+
+/**
+ * @brief Cut the next complete line (terminated by CR or LF) out of the buffer.
+ *  Empty lines are skipped.
+ * 
+ * @param line Set to the first byte of the line. Valid until the next prepareWrite() or clear().
+ * @param length Set to the length of the line without the terminator
+ * @return Status : LINE if a line was cut, NO_LINE if more bytes are needed,
+ *  LINE_TOO_LONG if a line over MAX_MESSAGE_LEN was dropped.
+ */
+InputBuffer::Status InputBuffer::nextLine(const char *&line, size_t& length) {
+    const size_t maxLineLen = MAX_MESSAGE_LEN - 2;
+
+    while (1) {
+        while (_begin < _end && (_data[_begin] == CR || _data[_begin] == LF)) {
+            ++_begin;
+            _isDiscarding = false;
+        }
+        if (_scan < _begin) _scan = _begin;
+        if (_begin == _end) return NO_LINE;
+
+        const char *data = &_data[0];
+        const size_t lineEnd = ByteScanner::findLineEnd(data + _scan, data + _end) - data;
+
+        if (_isDiscarding) {
+            _begin = _scan = lineEnd;
+            if (lineEnd == _end) return NO_LINE;
+            _isDiscarding = false;
+            continue;
+        }
+        if (lineEnd == _end) {
+            _scan = _end;
+            if (_end - _begin <= maxLineLen) return NO_LINE;
+            _begin = _scan = _end;
+            _isDiscarding = true;
+            return LINE_TOO_LONG;
+        }
+        if (lineEnd - _begin > maxLineLen) {
+            _begin = _scan = lineEnd;
+            return LINE_TOO_LONG;
+        }
+        line = data + _begin;
+        length = lineEnd - _begin;
+        _begin = _scan = lineEnd + 1;
+        return LINE;
+    }
+}
+
+/**
+ * @brief Put back the line last cut by nextLine(), to be cut again by the next call.
+ *  Its terminator is not scanned again.
+ * 
+ * @param line Line returned by the last nextLine()
+ * @param length Its length
+ */
+void InputBuffer::ungetLine(const char *line, size_t length) {
+    _begin = line - &_data[0];
+    _scan = _begin + length;
+}
+
+/**
+ * @brief Drop all unconsumed bytes.
+ */
+void InputBuffer::clear(void) {
+    _begin = 0;
+    _scan = 0;
+    _end = 0;
+    _isDiscarding = false;
+}
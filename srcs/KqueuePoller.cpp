@@ -0,0 +1,187 @@
+#ifndef __linux__
+
+#include <stdexcept>
+#include <unistd.h>
+#include "KqueuePoller.hpp"
+#include "CommonValue.hpp"
+
+/**
+ * @brief Construct a new KqueuePoller:: Create kqueue.
+ * @throw Throw runtime_error if kqueue creation fails.
+ */
+KqueuePoller::KqueuePoller(void): _kq(UNDEFINED_FD) {
+    if ((_kq = kqueue()) == ERR_RETURN)
+        throw(runtime_error("kqueue() error"));
+}
+
+/**
+ * @brief Destroy the KqueuePoller:: Close kqueue fd
+ */
+KqueuePoller::~KqueuePoller() {
+    if (_kq != UNDEFINED_FD) close(_kq);
+}
+
+/**
+ * @brief Queue the interest of a fd. Only the last queued interest of
+ *  each fd is turned into kevent changes by buildChangeList().
+ *
+ * @param fd Socket fd
+ * @param udata User-data returned with every event of that fd.
+ * @param watchWrite Also report write readiness if true.
+ */
+void KqueuePoller::queueChange(int fd, void *udata, bool watchWrite) {
+    if (_fdStates.size() <= static_cast<size_t>(fd)) _fdStates.resize(fd + 1);
+
+    FdState& state = _fdStates[fd];
+
+    state.udata = udata;
+    state.wantWrite = watchWrite;
+    if (!state.isChanged) {
+        state.isChanged = true;
+        _changedFds.push_back(fd);
+    }
+    countChange();
+}
+
+/**
+ * @brief Append a change of the kqueue interest list. Submitted on next wait().
+ *
+ * @param socket Socket fd
+ * @param filter Event filter. EVFILT_READ, EVFILT_WRITE
+ * @param flags Handle event. EV_ADD, EV_ENABLE, EV_CLEAR
+ * @param udata User-data that can be used at the event return. The state of the fd.
+ */
+void KqueuePoller::updateEvents(int socket, int16_t filter, uint16_t flags, void *udata) {
+    struct kevent event;
+
+    EV_SET(&event, socket, filter, flags, 0, 0, udata);
+    _eventCheckList.push_back(event);
+}
+
+/**
+ * @brief Turn queued interests that differ from the kernel's into kevent changes.
+ *  A new fd gets both filters; the write filter is added disabled unless
+ *  wanted, so that later write interest changes only have to toggle it.
+ */
+void KqueuePoller::buildChangeList(void) {
+    const size_t pendingNum = _eventCheckList.size();
+
+    for (size_t i = 0; i < _changedFds.size(); ++i) {
+        const int fd = _changedFds[i];
+        FdState& state = _fdStates[fd];
+
+        if (!state.isChanged) continue;
+        state.isChanged = false;
+        if (!state.isRegistered) {
+            updateEvents(fd, EVFILT_READ, EV_ADD | EV_ENABLE | EV_CLEAR, &state);
+            updateEvents(fd, EVFILT_WRITE, EV_ADD | (state.wantWrite ? EV_ENABLE : EV_DISABLE) | EV_CLEAR, &state);
+        } else if (state.isWriteEnabled != state.wantWrite) {
+            updateEvents(fd, EVFILT_WRITE, (state.wantWrite ? EV_ENABLE : EV_DISABLE) | EV_CLEAR, &state);
+        }
+        state.isRegistered = true;
+        state.isWriteEnabled = state.wantWrite;
+    }
+    _changedFds.clear();
+    countSubmit(_eventCheckList.size() - pendingNum, 0);
+}
+
+/**
+ * @brief Register fd to kqueue. EV_CLEAR makes both filters edge-triggered.
+ *  Submitted on next wait().
+ *
+ * @param fd Socket fd
+ * @param udata User-data returned with every event of that fd.
+ * @param watchWrite Also report write readiness if true.
+ */
+void KqueuePoller::addFd(int fd, void *udata, bool watchWrite) {
+    queueChange(fd, udata, watchWrite);
+}
+
+/**
+ * @brief Turn write readiness reports of a registered fd on or off. Submitted on next wait().
+ *
+ * @param fd Socket fd
+ * @param udata User-data returned with every event of that fd.
+ * @param watchWrite Report write readiness if true.
+ */
+void KqueuePoller::setWriteInterest(int fd, void *udata, bool watchWrite) {
+    queueChange(fd, udata, watchWrite);
+}
+
+/**
+ * @brief Unregister fd from kqueue. Deleting both filters is queued ahead of
+ *  the changes of the next wait(), so the fd reports nothing from then on even
+ *  if it is closed much later. Changes of the fd not submitted yet are dropped.
+ *  Events of the fd still in the current batch come with NULL user-data.
+ *
+ * @param fd Socket fd
+ */
+void KqueuePoller::removeFd(int fd) {
+    if (static_cast<size_t>(fd) >= _fdStates.size()) return ;
+
+    FdState& state = _fdStates[fd];
+
+    if (state.isRegistered) {
+        updateEvents(fd, EVFILT_READ, EV_DELETE, &state);
+        updateEvents(fd, EVFILT_WRITE, EV_DELETE, &state);
+        countSubmit(2, 0);
+    }
+    state.udata = NULL;
+    state.isRegistered = false;
+    state.isWriteEnabled = false;
+    state.isChanged = false;
+    countChange();
+}
+
+/**
+ * @brief Submit queued changes and wait for readiness of registered fds.
+ *  The changes ride on the same kevent() call as the wait.
+ *  Each ready event carries the state of its fd, where user-data is read.
+ *
+ * @param events Array to fill with ready events
+ * @param maxEvents Capacity of events
+ * @param timeoutMs Timeout in milliseconds. -1 blocks until an event happens.
+ * @return int : Number of filled events. ERR_RETURN on failure with errno set.
+ */
+int KqueuePoller::wait(PollEvent *events, int maxEvents, int timeoutMs) {
+    struct timespec timeout;
+    struct timespec *timeoutPtr = NULL;
+    int numOfEvents;
+
+    if (timeoutMs >= 0) {
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_nsec = (timeoutMs % 1000) * 1000000;
+        timeoutPtr = &timeout;
+    }
+    if (!_changedFds.empty()) buildChangeList();
+    if (_waitingEvents.size() < static_cast<size_t>(maxEvents)) _waitingEvents.resize(maxEvents);
+    numOfEvents = kevent(_kq, _eventCheckList.empty() ? NULL : &_eventCheckList[0], _eventCheckList.size(),
+                         &_waitingEvents[0], maxEvents, timeoutPtr);
+    countWait(numOfEvents, maxEvents);
+    // On failure the changes are kept and submitted again; they are all idempotent.
+    if (numOfEvents == ERR_RETURN) return ERR_RETURN;
+
+    _eventCheckList.clear();
+    for (int i = 0; i < numOfEvents; ++i) {
+        const struct kevent& ready = _waitingEvents[i];
+        const FdState& state = *static_cast<const FdState *>(ready.udata);
+
+        events[i].fd = ready.ident;
+        events[i].udata = state.udata;
+        events[i].readable = (ready.filter == EVFILT_READ);
+        events[i].writable = (ready.filter == EVFILT_WRITE);
+        events[i].error = (ready.flags & EV_ERROR);
+    }
+    return numOfEvents;
+}
+
+/**
+ * @brief Get backend name
+ *
+ * @return const char* : "kqueue"
+ */
+const char *KqueuePoller::getName(void) const {
+    return "kqueue";
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include <cstring>
+#include "LatencyHistogram.hpp"
+
+/**
+ * @brief Construct a new LatencyHistogram::Snapshot:: Empty
+ */
+LatencyHistogram::Snapshot::Snapshot(void) {
+    memset(buckets, 0, sizeof(buckets));
+}
+
+/**
+ * @brief Add the counts of another snapshot.
+ *
+ * @param rhs Snapshot to add
+ * @return LatencyHistogram::Snapshot& : This snapshot
+ */
+LatencyHistogram::Snapshot& LatencyHistogram::Snapshot::operator+=(const Snapshot& rhs) {
+    for (size_t i = 0; i < BUCKET_NUM; ++i) buckets[i] += rhs.buckets[i];
+    return *this;
+}
+
+/**
+ * @brief Remove the counts of an earlier snapshot of the same histograms.
+ *
+ * @param rhs Earlier snapshot. Every bucket must be lower or equal.
+ * @return LatencyHistogram::Snapshot& : This snapshot
+ */
+LatencyHistogram::Snapshot& LatencyHistogram::Snapshot::operator-=(const Snapshot& rhs) {
+    for (size_t i = 0; i < BUCKET_NUM; ++i) buckets[i] -= rhs.buckets[i];
+    return *this;
+}
+
+/**
+ * @brief Get the number of recorded durations.
+ *
+ * @return unsigned long : Sum of the buckets
+ */
+unsigned long LatencyHistogram::Snapshot::getCount(void) const {
+    unsigned long count = 0;
+
+    for (size_t i = 0; i < BUCKET_NUM; ++i) count += buckets[i];
+    return count;
+}
+
+/**
+ * @brief Get the duration that a ratio of the recorded ones do not exceed.
+ *
+ * @param ratio 0.5 for the median, 0.99 for p99...
+ * @return unsigned long : Upper bound in nanoseconds of the bucket holding that rank. 0 if empty.
+ */
+unsigned long LatencyHistogram::Snapshot::getPercentile(double ratio) const {
+    const unsigned long count = getCount();
+    unsigned long rank = static_cast<unsigned long>(count * ratio);
+    unsigned long seen = 0;
+
+    if (count == 0) return 0;
+    if (rank >= count) rank = count - 1;
+    for (size_t i = 0; i < BUCKET_NUM; ++i) {
+        seen += buckets[i];
+        if (seen > rank) return getUpperBound(i);
+    }
+    return getUpperBound(BUCKET_NUM - 1);
+}
+
+/**
+ * @brief Get the longest recorded duration.
+ *
+ * @return unsigned long : Upper bound in nanoseconds of the highest non-empty bucket. 0 if empty.
+ */
+unsigned long LatencyHistogram::Snapshot::getMax(void) const {
+    for (size_t i = BUCKET_NUM; i > 0; --i) {
+        if (buckets[i - 1] != 0) return getUpperBound(i - 1);
+    }
+    return 0;
+}
+
+/**
+ * @brief Construct a new LatencyHistogram:: Empty
+ */
+LatencyHistogram::LatencyHistogram(void) {
+    memset(_buckets, 0, sizeof(_buckets));
+}
+
+/**
+ * @brief Destroy the LatencyHistogram:: LatencyHistogram object
+ */
+LatencyHistogram::~LatencyHistogram() { }
+
+/**
+ * @brief Add the current counts to a snapshot. Callable from any thread.
+ *
+ * @param snapshot Snapshot to add to
+ */
+void LatencyHistogram::addTo(Snapshot& snapshot) const {
+    for (size_t i = 0; i < BUCKET_NUM; ++i) snapshot.buckets[i] += __atomic_load_n(&_buckets[i], __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Get the largest duration a bucket holds.
+ *
+ * @param bucket Bucket index
+ * @return unsigned long : Nanoseconds
+ */
+unsigned long LatencyHistogram::getUpperBound(size_t bucket) {
+    if (bucket < SUB_BUCKET_NUM) return bucket;
+
+    const size_t shift = bucket / SUB_BUCKET_NUM - 1;
+    const unsigned long lower = (SUB_BUCKET_NUM + bucket % SUB_BUCKET_NUM) << shift;
+
+    return lower + (1UL << shift) - 1;
+}
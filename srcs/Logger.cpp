@@ -0,0 +1,276 @@
+#include <cstdio>
+#include <cstdarg>
+#include <cerrno>
+#include <ctime>
+#include <unistd.h>
+#include <fcntl.h>
+#include "Logger.hpp"
+
+Logger::Level Logger::_level = Logger::INFO;
+int Logger::_fd = STDOUT_FILENO;
+string Logger::_path;
+size_t Logger::_fileSize = 0;
+int Logger::_isRunning = 0;
+pthread_t Logger::_writer;
+Mutex Logger::_ringsLock;
+vector<Logger::Ring *> Logger::_rings;
+unsigned long Logger::_reportedDroppedNum = 0;
+__thread Logger::Ring *Logger::_ring = NULL;
+
+static const char *levelNames[] = { "DEBUG", "INFO ", "WARN ", "ERROR" };
+
+/**
+ * @brief Append one formatted line: "<date> <time> <LEVEL> <text>\n"
+ *
+ * @param batch Batch to append to
+ * @param timeMs Wall clock time of the record
+ * @param level Index in levelNames
+ * @param text Event and fields
+ * @param length Length of text
+ */
+static void appendLine(string& batch, long timeMs, int level, const char *text, size_t length) {
+    const time_t seconds = timeMs / 1000;
+    char prefix[48];
+    struct tm date;
+
+    localtime_r(&seconds, &date);
+    batch.append(prefix, strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S", &date));
+    batch.append(prefix, snprintf(prefix, sizeof(prefix), ".%03ld %s ", timeMs % 1000, levelNames[level]));
+    batch.append(text, length);
+    batch += LF;
+}
+
+/**
+ * @brief Start the writer thread.
+ *
+ * @param path Log file, appended to. Empty to write to the standard output.
+ * @param level Records under this level are ignored
+ * @return true : Writing / if not return
+ * @return false : The file could not be opened or the thread not created
+ */
+bool Logger::start(const string& path, Level level) {
+    _level = level;
+    _path = path;
+    if (!_path.empty() && !openFile()) return false;
+    __atomic_store_n(&_isRunning, 1, __ATOMIC_SEQ_CST);
+    if (pthread_create(&_writer, NULL, &Logger::writerMain, NULL) != 0) {
+        __atomic_store_n(&_isRunning, 0, __ATOMIC_SEQ_CST);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Write out the records logged so far and stop the writer thread.
+ *  Call before the process exits, or the last records are lost.
+ */
+void Logger::stop(void) {
+    if (!__atomic_exchange_n(&_isRunning, 0, __ATOMIC_SEQ_CST)) return ;
+    pthread_join(_writer, NULL);
+    if (_fd != STDOUT_FILENO) close(_fd);
+    _fd = STDOUT_FILENO;
+}
+
+/**
+ * @brief Log a record, printf style. Wait-free: the record is formatted into
+ *  the ring of the calling thread, or dropped if the ring is full.
+ *  The text is truncated to LOG_RECORD_SIZE bytes.
+ *
+ * @param level Level of the record
+ * @param format Event name followed by "key=value" fields
+ */
+void Logger::log(Level level, const char *format, ...) {
+    if (!isEnabled(level)) return ;
+
+    Ring *ring = _ring != NULL ? _ring : (_ring = createRing());
+    const unsigned long tail = ring->tail;
+
+    if (tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) >= LOG_RING_SIZE) {
+        __atomic_store_n(&ring->droppedNum, ring->droppedNum + 1, __ATOMIC_RELAXED);
+        return ;
+    }
+
+    Record& record = ring->records[tail % LOG_RING_SIZE];
+    struct timespec now;
+    va_list args;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    record.timeMs = static_cast<long>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+    record.level = level;
+    va_start(args, format);
+    record.length = vsnprintf(record.text, LOG_RECORD_SIZE, format, args);
+    va_end(args);
+    if (record.length < 0) record.length = 0;
+    if (record.length >= LOG_RECORD_SIZE) record.length = LOG_RECORD_SIZE - 1;
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Get the number of records dropped because a ring was full. Callable from any thread.
+ *
+ * @return unsigned long : Dropped records of every thread
+ */
+unsigned long Logger::getDroppedNum(void) {
+    ScopedLock lock(_ringsLock);
+    unsigned long droppedNum = 0;
+
+    for (size_t i = 0; i < _rings.size(); ++i) droppedNum += __atomic_load_n(&_rings[i]->droppedNum, __ATOMIC_RELAXED);
+    return droppedNum;
+}
+
+/**
+ * @brief Parse a level name of the log_level option.
+ *
+ * @param name "debug", "info", "warn" or "error"
+ * @param level Parsed level is stored here on success
+ * @return true : Known name / if not return
+ * @return false
+ */
+bool Logger::parseLevel(const string& name, Level& level) {
+    static const char *names[] = { "debug", "info", "warn", "error" };
+
+    for (int i = DEBUG; i <= ERROR; ++i) {
+        if (name != names[i]) continue;
+        level = static_cast<Level>(i);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Create the ring of the calling thread, on its first record.
+ *  Rings live until the process exits, so the writer never sees one freed.
+ *
+ * @return Logger::Ring* : New ring, registered for the writer
+ */
+Logger::Ring *Logger::createRing(void) {
+    Ring *ring = new Ring;
+    ScopedLock lock(_ringsLock);
+
+    ring->head = 0;
+    ring->tail = 0;
+    ring->droppedNum = 0;
+    _rings.push_back(ring);
+    return ring;
+}
+
+/**
+ * @brief Entry point of the writer thread: drain the rings in batches until stop(),
+ *  sleeping LOG_FLUSH_INTERVAL_MS whenever there was nothing to write.
+ *
+ * @param arg Unused
+ * @return void* : Always NULL
+ */
+void *Logger::writerMain(void *arg) {
+    string batch;
+
+    (void)arg;
+    while (__atomic_load_n(&_isRunning, __ATOMIC_SEQ_CST)) {
+        if (!drain(batch)) usleep(LOG_FLUSH_INTERVAL_MS * 1000);
+    }
+    drain(batch);
+    return NULL;
+}
+
+/**
+ * @brief Format the pending records of every ring into one batch, and write it.
+ *  Records of different threads are not merged by time, each ring is written in order.
+ *  A line reports the records dropped since the last batch, if any.
+ *
+ * @param batch Buffer reused between batches
+ * @return true : Something was written / if not return
+ * @return false
+ */
+bool Logger::drain(string& batch) {
+    vector<Ring *> rings;
+
+    {
+        ScopedLock lock(_ringsLock);
+
+        rings = _rings;
+    }
+    batch.clear();
+    for (size_t i = 0; i < rings.size(); ++i) {
+        Ring *ring = rings[i];
+        const unsigned long tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+        for (unsigned long index = ring->head; index != tail; ++index) {
+            const Record& record = ring->records[index % LOG_RING_SIZE];
+
+            appendLine(batch, record.timeMs, record.level, record.text, record.length);
+        }
+        __atomic_store_n(&ring->head, tail, __ATOMIC_RELEASE);
+    }
+
+    unsigned long droppedNum = 0;
+
+    for (size_t i = 0; i < rings.size(); ++i) droppedNum += __atomic_load_n(&rings[i]->droppedNum, __ATOMIC_RELAXED);
+    if (droppedNum != _reportedDroppedNum) {
+        struct timespec now;
+        char text[64];
+
+        clock_gettime(CLOCK_REALTIME, &now);
+        appendLine(batch, static_cast<long>(now.tv_sec) * 1000 + now.tv_nsec / 1000000, WARN, text,
+                   snprintf(text, sizeof(text), "log records dropped=%lu", droppedNum - _reportedDroppedNum));
+        _reportedDroppedNum = droppedNum;
+    }
+    if (batch.empty()) return false;
+    writeBatch(batch);
+    return true;
+}
+
+/**
+ * @brief Write a batch whole, then rotate the log file if it went over LOG_ROTATE_SIZE.
+ *  A failed write loses the batch; there is nowhere left to report it.
+ *
+ * @param batch Formatted records
+ */
+void Logger::writeBatch(const string& batch) {
+    size_t written = 0;
+
+    while (written < batch.size()) {
+        const ssize_t bytes = write(_fd, batch.data() + written, batch.size() - written);
+
+        if (bytes == ERR_RETURN && errno == EINTR) continue;
+        if (bytes <= 0) break;
+        written += bytes;
+    }
+    errno = 0;
+    _fileSize += written;
+    if (!_path.empty() && _fileSize >= LOG_ROTATE_SIZE) rotate();
+}
+
+/**
+ * @brief Shift <file>.1 ... to <file>.2 ..., dropping the oldest, move the log file
+ *  to <file>.1 and start a new one. If it cannot be created, logs go to the standard output.
+ */
+void Logger::rotate(void) {
+    char from[32];
+    char to[32];
+
+    close(_fd);
+    for (int i = LOG_ROTATE_NUM - 1; i >= 1; --i) {
+        snprintf(from, sizeof(from), ".%d", i);
+        snprintf(to, sizeof(to), ".%d", i + 1);
+        rename((_path + from).c_str(), (_path + to).c_str());
+    }
+    rename(_path.c_str(), (_path + ".1").c_str());
+    if (openFile()) return ;
+    _fd = STDOUT_FILENO;
+    _path.clear();
+}
+
+/**
+ * @brief Open the log file for appending.
+ *
+ * @return true : Opened / if not return
+ * @return false
+ */
+bool Logger::openFile(void) {
+    const int fd = open(_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+
+    if (fd == ERR_RETURN) return false;
+    _fd = fd;
+    _fileSize = lseek(fd, 0, SEEK_END);
+    return true;
+}
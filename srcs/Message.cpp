@@ -4,82 +4,101 @@
 /**
  * @brief Construct a new Message:: Create empty message class for make reply
  */
-Message::Message(void) {}
+Message::Message(void): _argCount(0), _isGlued(false) {}
 
 /**
  * @brief Construct a new Message:: Create message class with received message from
  *  client. Parse to the IRC message rules.
+ *  The message keeps its own copy of the string.
  * 
  * @param ircMsgFormStr : String of IRC format message that received from client
  */
-Message::Message(const string& ircMsgFormStr) {
-    parse(ircMsgFormStr);
+Message::Message(const string& ircMsgFormStr): _line(ircMsgFormStr), _argCount(0), _isGlued(false) {
+    parse(_line.data(), _line.length());
 }
 
 /**
- * @brief Destroy the Message:: Message object
+ * @brief Construct a new Message:: Create message class with a line framed in a client's cmd buffer.
+ *  Parse to the IRC message rules without copying or allocating:
+ *  prefix, command and params are views of the line, so the line must outlive the message.
+ * 
+ * @param line First byte of the line (without CR/LF)
+ * @param length Length of the line
  */
-Message::~Message() {
-    _command.clear();
-    _params.clear();
+Message::Message(const char *line, size_t length): _argCount(0), _isGlued(false) {
+    parse(line, length);
 }
 
 /**
- * @brief Parse strings received from clients to IRC message format.
+ * @brief Destroy the Message:: Message object
+ */
+Message::~Message() { }
+
+/**
+ * @brief Parse a line received from clients to IRC message format.
+ *  [':' <prefix> ' '] <command> {' ' <middle>} [' ' ':' <trailing>]
+ *  The trailing param keeps its spaces. As RFC 2812 allows, the 15th param takes
+ *  the rest of the line even without ':'.
  * 
- * @param ircMsgFormStr strings received from clients
+ * @param line First byte of the line
+ * @param length Length of the line
  */
-void Message::parse(const string& ircMsgFormStr) {
-    vector<string> splitedBySpace = split(ircMsgFormStr, ' ');
+void Message::parse(const char *line, size_t length) {
+    const char *cursor = line;
+    const char *end = line + length;
+    const char *tokenBegin;
 
-    for (vector<string>::size_type i = 0; i < splitedBySpace.size(); ++i) {
-        if (i == 0 && splitedBySpace[i][0] == ':') {
-            _prefix = splitedBySpace[i].erase(0, 1);
-            continue ;
-        }
-        if (_command.empty()) {
-            _command = splitedBySpace[i];
-            continue;
-        }
-        if (splitedBySpace[i][0] == ':') {
-            string mergedString;
-            splitedBySpace[i].erase(0, 1);
-            while (i < splitedBySpace.size()) {
-                mergedString += splitedBySpace[i];
-                if (i != splitedBySpace.size() - 1) mergedString += ' ';
-                ++i;
-            }
-            _params.push_back(mergedString);
+    while (cursor != end && *cursor == ' ') ++cursor;
+    if (cursor != end && *cursor == ':') {
+        tokenBegin = ++cursor;
+        while (cursor != end && *cursor != ' ') ++cursor;
+        _prefix = StringView(tokenBegin, cursor - tokenBegin);
+        while (cursor != end && *cursor == ' ') ++cursor;
+    }
+    tokenBegin = cursor;
+    while (cursor != end && *cursor != ' ') ++cursor;
+    _command = StringView(tokenBegin, cursor - tokenBegin);
+
+    while (_argCount < MAX_MESSAGE_PARAMS) {
+        while (cursor != end && *cursor == ' ') ++cursor;
+        if (cursor == end) return ;
+        if (*cursor == ':' || _argCount == MAX_MESSAGE_PARAMS - 1) {
+            if (*cursor == ':') ++cursor;
+            _args[_argCount++] = StringView(cursor, end - cursor);
             return ;
-        } else _params.push_back(splitedBySpace[i]);
+        }
+        tokenBegin = cursor;
+        while (cursor != end && *cursor != ' ') ++cursor;
+        _args[_argCount++] = StringView(tokenBegin, cursor - tokenBegin);
     }
 }
 
 /**
  * @brief Get prefix(deinfed in IRC RFC doc) from a parsed message.
  * 
- * @return const string& : prefix(Most of the time, it's empty or nickname)
+ * @return const StringView& : prefix(Most of the time, it's empty or nickname)
  */
-const string& Message::getPrefix(void) const {
+const StringView& Message::getPrefix(void) const {
     return _prefix;
 }
 
 /**
  * @brief Get command(defined in IRC RFC doc) from a parsed message.
  * 
- * @return const string& : command(ex. PRIVMSG, JOIN etc...)
+ * @return const StringView& : command(ex. PRIVMSG, JOIN etc...)
  */
-const string& Message::getCommand(void) const {
+const StringView& Message::getCommand(void) const {
     return _command;
 }
 
 /**
  * @brief Get params from a parsed message. These are related to the command.
+ *  Index it like an array, up to paramSize().
  * 
- * @return const vector<string>& : params
+ * @return const StringView* : params
  */
-const vector<string>& Message::getParams(void) const {
-    return _params;
+const StringView* Message::getParams(void) const {
+    return _args;
 }
 
 /**
@@ -107,12 +126,12 @@ vector<string> Message::split(const string& str, const char delimeter) {
 }
 
 /**
- * @brief Returns the number of parameters that the message has.
+ * @brief Returns the number of parameters that the parsed message has.
  * 
  * @return size_t : Number of parameters
  */
 size_t Message::paramSize(void) const {
-    return _params.size();
+    return _argCount;
 }
 
 /**
@@ -126,15 +145,28 @@ size_t Message::paramSize(void) const {
 const string Message::createReplyForm(void) const {
     string reply;
 
-    vector<string>::const_iterator it;
-    for (it = _params.begin(); it != _params.end(); ++it) {
-        reply += (*it);
-        if (*it != ":" && (it + 1) != _params.end()) reply += ' ';
-    }
+    reply.reserve(_reply.length() + 2);
+    reply.append(_reply);
     reply += "\r\n";
     return reply;
 }
 
+/**
+ * @brief Append a param to the reply, separated from the previous one by a space.
+ *  A single ":" is attached to the following param. Empty params are skipped.
+ * 
+ * @param param First byte of the param
+ * @param length Length of the param
+ * @return Message& 
+ */
+Message& Message::append(const char *param, size_t length) {
+    if (length == 0) return (*this);
+    if (!_reply.empty() && !_isGlued) _reply += ' ';
+    _reply.append(param, length);
+    _isGlued = (length == 1 && param[0] == ':');
+    return (*this);
+}
+
 /**
  * @brief Add to params. Use it in the order in which it appears in the reply message.
  *  If you put a single ":" to params, 
@@ -143,7 +175,26 @@ const string Message::createReplyForm(void) const {
  * @param param Reply message element(ex. source, numeric reply, msg, etc...)
  * @return Message& 
  */
-Message& Message::operator<<(const string param) {
-    if (!param.empty()) _params.push_back(param);
-    return (*this);
+Message& Message::operator<<(const string& param) {
+    return append(param.data(), param.length());
+}
+
+/**
+ * @brief Add a literal to params, without making a string of it.
+ * 
+ * @param param Reply message element
+ * @return Message& 
+ */
+Message& Message::operator<<(const char *param) {
+    return append(param, strlen(param));
+}
+
+/**
+ * @brief Add a part of a received message to params, without making a string of it.
+ * 
+ * @param param Reply message element(ex. param of the received message)
+ * @return Message& 
+ */
+Message& Message::operator<<(const StringView& param) {
+    return append(param.data(), param.length());
 }
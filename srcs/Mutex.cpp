@@ -0,0 +1,45 @@
+#include "Mutex.hpp"
+
+/**
+ * @brief Construct a new Mutex:: Mutex object
+ */
+Mutex::Mutex(void) {
+    pthread_mutex_init(&_mutex, NULL);
+}
+
+/**
+ * @brief Destroy the Mutex:: Mutex object
+ */
+Mutex::~Mutex() {
+    pthread_mutex_destroy(&_mutex);
+}
+
+/**
+ * @brief Block until the mutex is acquired.
+ */
+void Mutex::lock(void) {
+    pthread_mutex_lock(&_mutex);
+}
+
+/**
+ * @brief Release the mutex.
+ */
+void Mutex::unlock(void) {
+    pthread_mutex_unlock(&_mutex);
+}
+
+/**
+ * @brief Construct a new ScopedLock:: Acquire the given mutex
+ *
+ * @param mutex Mutex to hold until the end of scope
+ */
+ScopedLock::ScopedLock(Mutex& mutex): _mutex(mutex) {
+    _mutex.lock();
+}
+
+/**
+ * @brief Destroy the ScopedLock:: Release the mutex
+ */
+ScopedLock::~ScopedLock() {
+    _mutex.unlock();
+}
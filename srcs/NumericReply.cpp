@@ -0,0 +1,80 @@
+#include "NumericReply.hpp"
+
+/**
+ * @brief Build a template from a reply code and its text literal.
+ *  Both parts are string literals, so every template is a constant.
+ */
+#define NUMERIC_REPLY(code, text) { ":" SERVER_HOSTNAME " " code " ", sizeof(":" SERVER_HOSTNAME " " code " ") - 1, \
+                                    text, sizeof(text) - 1 }
+
+// The user's "<nickname>!<username>@<host>" follows the text.
+const NumericReply NumericReply::welcome = NUMERIC_REPLY(RPL_WELCOME, " " RPL_WELCOME_MSG " ");
+const NumericReply NumericReply::yourHost = NUMERIC_REPLY(RPL_YOURHOST, " " RPL_YOURHOST_MSG);
+// The creation date follows the text.
+const NumericReply NumericReply::created = NUMERIC_REPLY(RPL_CREATED, " " RPL_CREATED_MSG);
+// The member list follows the text.
+const NumericReply NumericReply::namReply = NUMERIC_REPLY(RPL_NAMREPLY, " :");
+const NumericReply NumericReply::endOfNames = NUMERIC_REPLY(RPL_ENDOFNAMES, " " RPL_ENDOFNAMES_MSG);
+// "<command> <count>"
+const NumericReply NumericReply::statsCommands = NUMERIC_REPLY(RPL_STATSCOMMANDS, "");
+// "<counter> <value>" follows the text.
+const NumericReply NumericReply::statsDebug = NUMERIC_REPLY(RPL_STATSDEBUG, " :");
+const NumericReply NumericReply::endOfStats = NUMERIC_REPLY(RPL_ENDOFSTATS, " " RPL_ENDOFSTATS_MSG);
+const NumericReply NumericReply::noSuchNick = NUMERIC_REPLY(ERR_NOSUCHNICK, " " ERR_NOSUCHNICK_MSG);
+const NumericReply NumericReply::noSuchChannel = NUMERIC_REPLY(ERR_NOSUCHCHANNEL, " " ERR_NOSUCHCHANNEL_MSG);
+const NumericReply NumericReply::noOrigin = NUMERIC_REPLY(ERR_NOORIGIN, " " ERR_NOORIGIN_MSG);
+const NumericReply NumericReply::noRecipientPrivmsg = NUMERIC_REPLY(ERR_NORECIPIENT, " " ERR_NORECIPIENT_MSG " (PRIVMSG)");
+const NumericReply NumericReply::noRecipientNotice = NUMERIC_REPLY(ERR_NORECIPIENT, " " ERR_NORECIPIENT_MSG " (NOTICE)");
+const NumericReply NumericReply::noTextToSend = NUMERIC_REPLY(ERR_NOTEXTTOSEND, " " ERR_NOTEXTTOSEND_MSG);
+const NumericReply NumericReply::inputTooLong = NUMERIC_REPLY(ERR_INPUTTOOLONG, " " ERR_INPUTTOOLONG_MSG);
+const NumericReply NumericReply::unknownCommand = NUMERIC_REPLY(ERR_UNKNOWNCOMMAND, " " ERR_UNKNOWNCOMMAND_MSG);
+const NumericReply NumericReply::noNicknameGiven = NUMERIC_REPLY(ERR_NONICKNAMEGIVEN, " " ERR_NONICKNAMEGIVEN_MSG);
+const NumericReply NumericReply::erroneusNickname = NUMERIC_REPLY(ERR_ERRONEUSNICKNAME, " " ERR_ERRONEUSNICKNAME_MSG);
+const NumericReply NumericReply::nicknameInUse = NUMERIC_REPLY(ERR_NICKNAMEINUSE, " " ERR_NICKNAMEINUSE_MSG);
+const NumericReply NumericReply::unavailResource = NUMERIC_REPLY(ERR_UNAVAILRESOURCE, " " ERR_UNAVAILRESOURCE_MSG);
+const NumericReply NumericReply::userNotInChannel = NUMERIC_REPLY(ERR_USERNOTINCHANNEL, " " ERR_USERNOTINCHANNEL_MSG);
+const NumericReply NumericReply::notOnChannel = NUMERIC_REPLY(ERR_NOTONCHANNEL, " " ERR_NOTONCHANNEL_MSG);
+const NumericReply NumericReply::needMoreParams = NUMERIC_REPLY(ERR_NEEDMOREPARAMS, " " ERR_NEEDMOREPARAMS_MSG);
+const NumericReply NumericReply::alreadyRegistered = NUMERIC_REPLY(ERR_ALREADYREGISTERED, " " ERR_ALREADYREGISTERED_MSG);
+const NumericReply NumericReply::passwdMismatch = NUMERIC_REPLY(ERR_PASSWDMISMATCH, " " ERR_PASSWDMISMATCH_MSG);
+const NumericReply NumericReply::erroneusChannelname = NUMERIC_REPLY(ERR_ERRONEUSCHANNELNAME, " " ERR_ERRONEUSCHANNELNAME_MSG);
+const NumericReply NumericReply::chanOprivsNeeded = NUMERIC_REPLY(ERR_CHANOPRIVSNEEDED, " " ERR_CHANOPRIVSNEEDED_MSG);
+
+/**
+ * @brief Construct a new ReplyBurst:: No reply yet
+ */
+ReplyBurst::ReplyBurst(void): _replyNum(0) { }
+
+/**
+ * @brief Serialize one more reply at the end of the burst: <head><nickname><text><trailing>\r\n
+ *
+ * @param reply Template of the reply. Replies with params are not supported.
+ * @param trailing Bytes after the text of the template
+ */
+void ReplyBurst::add(const NumericReply& reply, const string& trailing) {
+    if (_replyNum == MAX_REPLY_NUM) return ;
+    _pieces[_replyNum].append(reply.head, reply.headLength);
+    ++_replyNum;
+    _pieces[_replyNum].append(reply.text, reply.textLength);
+    _pieces[_replyNum] += trailing;
+    _pieces[_replyNum] += "\r\n";
+}
+
+/**
+ * @brief Get the number of replies, which is also the number of nickname places.
+ *
+ * @return size_t : Number of replies
+ */
+size_t ReplyBurst::getReplyNum(void) const {
+    return _replyNum;
+}
+
+/**
+ * @brief Get constant bytes of the burst.
+ *
+ * @param index 0 ~ getReplyNum(). Piece index is followed by the nickname, except the last one.
+ * @return const string& : Serialized bytes
+ */
+const string& ReplyBurst::getPiece(size_t index) const {
+    return _pieces[index];
+}
@@ -0,0 +1,146 @@
+#include <sys/uio.h>
+#include "OutputQueue.hpp"
+#include "Stats.hpp"
+#include "CommonValue.hpp"
+
+/**
+ * @brief Construct a new OutputQueue:: Empty queue
+ */
+OutputQueue::OutputQueue(void): _offset(0), _size(0), _nextBlockSize(0) { }
+
+/**
+ * @brief Destroy the OutputQueue:: Release all segments
+ */
+OutputQueue::~OutputQueue() {
+    subtractSize(_size);
+}
+
+/**
+ * @brief Count memory added to this queue, also in the gauge of the reactor.
+ *  A queue is only filled and sent by the thread of its client's reactor.
+ * 
+ * @param bytes Capacity of the segment added
+ */
+void OutputQueue::addSize(size_t bytes) {
+    _size += bytes;
+    Stats::local().addSendQ(bytes, _size);
+}
+
+/**
+ * @brief Count memory released by this queue, also in the gauge of the reactor.
+ * 
+ * @param bytes Capacity of the segments removed
+ */
+void OutputQueue::subtractSize(size_t bytes) {
+    _size -= bytes;
+    Stats::local().subtractSendQ(bytes);
+}
+
+/**
+ * @brief Check that nothing is waiting to be sent.
+ * 
+ * @return true : Queue is empty / if not return
+ * @return false 
+ */
+bool OutputQueue::empty(void) const {
+    return _segments.empty();
+}
+
+/**
+ * @brief Get the memory the queue holds, which bounds the bytes waiting to be sent.
+ * 
+ * @return size_t : Capacity of the queued segments
+ */
+size_t OutputQueue::size(void) const {
+    return _size;
+}
+
+/**
+ * @brief Append a reply segment. Only the reference is copied.
+ *  The next block made by appendSpace() is sized to its first reply again.
+ * 
+ * @param segment Serialized reply
+ */
+void OutputQueue::push(const SharedBuffer& segment) {
+    if (segment.empty()) return ;
+    _segments.push_back(segment);
+    _nextBlockSize = 0;
+    addSize(segment.capacity());
+}
+
+/**
+ * @brief Make room for length bytes at the end of the queue, for the caller to fill.
+ *  The bytes go to the last segment if this queue is its only owner and it has
+ *  room left, otherwise to a new block: of length bytes after a shared segment,
+ *  then twice as big as the previous block each time, up to REPLY_BLOCK_SIZE.
+ * 
+ * @param length Number of bytes the caller writes
+ * @return char* : Where to write exactly length bytes
+ */
+char *OutputQueue::appendSpace(size_t length) {
+    char *space = _segments.empty() ? NULL : _segments.back().appendSpace(length);
+
+    if (space == NULL) {
+        const size_t blockSize = length > _nextBlockSize ? length : _nextBlockSize;
+
+        _segments.push_back(SharedBuffer(blockSize));
+        _nextBlockSize = blockSize * 2 < REPLY_BLOCK_SIZE ? blockSize * 2 : REPLY_BLOCK_SIZE;
+        addSize(_segments.back().capacity());
+        space = _segments.back().appendSpace(length);
+    }
+    return space;
+}
+
+/**
+ * @brief Drop everything waiting to be sent.
+ */
+void OutputQueue::clear(void) {
+    _segments.clear();
+    _offset = 0;
+    _nextBlockSize = 0;
+    subtractSize(_size);
+}
+
+/**
+ * @brief Remove sent bytes from the front of the queue.
+ *  The memory of a segment is released once it is sent whole.
+ * 
+ * @param bytes Number of bytes sent
+ */
+void OutputQueue::consume(size_t bytes) {
+    while (bytes > 0) {
+        const size_t remain = _segments.front().size() - _offset;
+
+        if (bytes < remain) {
+            _offset += bytes;
+            return ;
+        }
+        bytes -= remain;
+        _offset = 0;
+        subtractSize(_segments.front().capacity());
+        _segments.pop_front();
+    }
+}
+
+/**
+ * @brief Send as much of the queue as one writev() accepts.
+ * 
+ * @param fd Client socket fd
+ * @return ssize_t : Number of bytes sent. ERR_RETURN(-1) on failure with errno set.
+ */
+ssize_t OutputQueue::writeTo(int fd) {
+    struct iovec iov[IOV_MAX];
+    size_t offset = _offset;
+    int iovCount = 0;
+    ssize_t sendBytes;
+
+    for (deque<SharedBuffer>::const_iterator it = _segments.begin(); it != _segments.end() && iovCount < IOV_MAX; ++it) {
+        iov[iovCount].iov_base = const_cast<char *>(it->data()) + offset;
+        iov[iovCount].iov_len = it->size() - offset;
+        offset = 0;
+        ++iovCount;
+    }
+    sendBytes = writev(fd, iov, iovCount);
+    if (sendBytes > 0) consume(sendBytes);
+    return sendBytes;
+}
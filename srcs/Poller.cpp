@@ -0,0 +1,89 @@
+#include <cstring>
+#include "Poller.hpp"
+#include "EpollPoller.hpp"
+#include "KqueuePoller.hpp"
+
+/**
+ * @brief Add to a counter that only the owning thread writes.
+ *  A plain load and store is enough, the atomics only keep readers on
+ *  other threads from seeing a torn value.
+ */
+static void addToCounter(unsigned long& counter, unsigned long value) {
+    __atomic_store_n(&counter, __atomic_load_n(&counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Construct a new Poller:: Poller object
+ */
+Poller::Poller(void) {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+/**
+ * @brief Destroy the Poller:: Poller object
+ */
+Poller::~Poller() { }
+
+/**
+ * @brief Count one wait() call of the backend.
+ *
+ * @param numOfEvents Number of events the call returned
+ * @param maxEvents Capacity passed to the call. A full batch means more events may be ready.
+ */
+void Poller::countWait(int numOfEvents, int maxEvents) {
+    addToCounter(_stats.waitNum, 1);
+    if (numOfEvents <= 0) return ;
+    addToCounter(_stats.eventNum, numOfEvents);
+    if (numOfEvents == maxEvents) addToCounter(_stats.fullWaitNum, 1);
+}
+
+/**
+ * @brief Count one interest change requested by the caller.
+ */
+void Poller::countChange(void) {
+    addToCounter(_stats.changeNum, 1);
+}
+
+/**
+ * @brief Count interest changes handed to the kernel after coalescing.
+ *
+ * @param changeNum Number of changes submitted
+ * @param callNum Number of system calls spent only on them
+ */
+void Poller::countSubmit(unsigned long changeNum, unsigned long callNum) {
+    addToCounter(_stats.submittedChangeNum, changeNum);
+    addToCounter(_stats.changeCallNum, callNum);
+}
+
+/**
+ * @brief Get the counters. Callable from any thread.
+ *  Events per wait() call is eventNum / waitNum.
+ *
+ * @return Stats : Snapshot of the counters
+ */
+Poller::Stats Poller::getStats(void) const {
+    Stats stats;
+
+    stats.waitNum = __atomic_load_n(&_stats.waitNum, __ATOMIC_RELAXED);
+    stats.eventNum = __atomic_load_n(&_stats.eventNum, __ATOMIC_RELAXED);
+    stats.fullWaitNum = __atomic_load_n(&_stats.fullWaitNum, __ATOMIC_RELAXED);
+    stats.changeNum = __atomic_load_n(&_stats.changeNum, __ATOMIC_RELAXED);
+    stats.submittedChangeNum = __atomic_load_n(&_stats.submittedChangeNum, __ATOMIC_RELAXED);
+    stats.changeCallNum = __atomic_load_n(&_stats.changeCallNum, __ATOMIC_RELAXED);
+    return stats;
+}
+
+/**
+ * @brief Create the native poller backend of the running platform.
+ *  epoll on Linux, kqueue on BSD/macOS.
+ *
+ * @return Poller* : Newly allocated poller. Caller owns it.
+ * @throw Throw runtime_error if the backend creation fails.
+ */
+Poller* Poller::create(void) {
+#ifdef __linux__
+    return new EpollPoller();
+#else
+    return new KqueuePoller();
+#endif
+}
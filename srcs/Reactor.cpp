@@ -0,0 +1,793 @@
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "Reactor.hpp"
+#include "Server.hpp"
+#include "User.hpp"
+#include "Message.hpp"
+#include "NumericReply.hpp"
+#include "Clock.hpp"
+#include "Logger.hpp"
+#include "CommonValue.hpp"
+
+static SlabPool replyNodePool("ReplyNode", sizeof(ReplyNode), 256);
+
+/**
+ * @brief Allocate an inbox node from the node slab pool. Callable from any thread.
+ *
+ * @param size Size of the object
+ * @return void* : Memory for the node
+ * @throw bad_alloc if there is no memory.
+ */
+void *ReplyNode::operator new(size_t size) {
+    if (size != sizeof(ReplyNode)) return ::operator new(size);
+    return replyNodePool.allocate();
+}
+
+/**
+ * @brief Give the memory of an inbox node back to the node slab pool.
+ *
+ * @param ptr Memory got from ReplyNode::operator new
+ * @param size Size of the object
+ */
+void ReplyNode::operator delete(void *ptr, size_t size) {
+    if (size != sizeof(ReplyNode)) ::operator delete(ptr);
+    else replyNodePool.deallocate(ptr);
+}
+
+/**
+ * @brief Construct a new Reactor:: Create its own listening socket and poller.
+ *  Every reactor binds the same port with SO_REUSEPORT,
+ *  so the kernel spreads new connections among the reactors.
+ *
+ * @param server Server that owns the shared state (channels, nicknames)
+ * @param id Index of the reactor
+ * @param config Server settings. The port that the client will use to connect to the IRC server,
+ *  the largest number of events taken per poller wait, the flood limits, the send queue limit,
+ *  the keepalive timeouts and the stats interval are used.
+ * @throw Throw runtime_error if socket setup fails.
+ */
+Reactor::Reactor(Server& server, int id, const ServerConfig& config)
+    : _server(server), _reclaimer(server.getReclaimer()), _id(id), _fd(UNDEFINED_FD), _wakePending(0), _isStopping(0),
+      _poller(NULL), _waitingEvents(MIN_EVENT_BATCH), _batchSize(MIN_EVENT_BATCH),
+      _maxBatchSize(config.maxEvents), _floodRate(config.floodRate), _floodBurst(config.floodBurst),
+      _sendQ(config.sendQ), _pingIntervalMs(config.pingInterval * 1000L), _pingTimeoutMs(config.pingTimeout * 1000L),
+      _registerTimeoutMs(config.registerTimeout * 1000L), _statsIntervalMs(id == 0 ? config.statsInterval * 1000L : 0),
+      _nowMs(Clock::nowMs()), _timers(_nowMs), _postedNum(0), _drainedNum(0), _isThreadStarted(false) {
+    struct sockaddr_in serverAddr;
+    int optionValue = 1;
+
+    _nextStatsMs = _nowMs + _statsIntervalMs;
+    _wakeFd[0] = UNDEFINED_FD;
+    _wakeFd[1] = UNDEFINED_FD;
+    if ((_fd = socket(PF_INET, SOCK_STREAM, 0)) == ERR_RETURN)
+        throw(runtime_error("socket() error"));
+    setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &optionValue, sizeof(optionValue));
+    if (setsockopt(_fd, SOL_SOCKET, SO_REUSEPORT, &optionValue, sizeof(optionValue)) == ERR_RETURN)
+        throw(runtime_error("setsockopt() error"));
+
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+    serverAddr.sin_port = htons(config.port);
+    fcntl(_fd, F_SETFL, O_NONBLOCK);
+
+    if (::bind(_fd, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) == ERR_RETURN)
+        throw(runtime_error("bind() error"));
+
+    if (listen(_fd, SOMAXCONN) == ERR_RETURN)
+        throw(runtime_error("listen() error"));
+
+    if (pipe(_wakeFd) == ERR_RETURN)
+        throw(runtime_error("pipe() error"));
+    fcntl(_wakeFd[0], F_SETFL, O_NONBLOCK);
+    fcntl(_wakeFd[1], F_SETFL, O_NONBLOCK);
+
+    _poller = Poller::create();
+    _poller->addFd(_fd, NULL, false);
+    _poller->addFd(_wakeFd[0], NULL, false);
+}
+
+/**
+ * @brief Destroy the Reactor:: Close sockets, free undelivered replies and delete the users.
+ *  Every reactor must be stopped.
+ */
+Reactor::~Reactor() {
+    ReplyNode *node;
+
+    while ((node = _inbox.pop()) != NULL) delete node;
+    for (size_t i = 0; i < _closedBatches.size(); ++i) _closedUsers.insert(_closedUsers.end(), _closedBatches[i].users.begin(), _closedBatches[i].users.end());
+    for (size_t i = 0; i < _closedUsers.size(); ++i) delete _closedUsers[i];
+    for (size_t i = 0; i < _users.size(); ++i) delete _users[i];
+    delete _poller;
+    if (_fd != UNDEFINED_FD) close(_fd);
+    if (_wakeFd[0] != UNDEFINED_FD) close(_wakeFd[0]);
+    if (_wakeFd[1] != UNDEFINED_FD) close(_wakeFd[1]);
+}
+
+/**
+ * @brief Get index of the reactor
+ *
+ * @return int : Reactor index
+ */
+int Reactor::getId(void) const {
+    return _id;
+}
+
+/**
+ * @brief Get the error that stopped the loop.
+ *
+ * @return const string& : Error message. Empty if the loop did not fail.
+ */
+const string& Reactor::getError(void) const {
+    return _error;
+}
+
+/**
+ * @brief Check that the caller runs on the thread of this reactor.
+ *
+ * @return true : Caller is the reactor thread / if not return
+ * @return false
+ */
+bool Reactor::isCurrentThread(void) const {
+    return pthread_equal(pthread_self(), _thread);
+}
+
+/**
+ * @brief Get the number of events taken by the next poller wait.
+ *  Only meaningful on the reactor thread.
+ *
+ * @return int : Current event batch size
+ */
+int Reactor::getBatchSize(void) const {
+    return _batchSize;
+}
+
+/**
+ * @brief Get the counters of the poller. Callable from any thread.
+ *
+ * @return Poller::Stats : Waits, events and interest changes so far
+ */
+Poller::Stats Reactor::getPollerStats(void) const {
+    return _poller->getStats();
+}
+
+/**
+ * @brief Get the activity counters of this reactor. Callable from any thread.
+ *
+ * @return Stats::Snapshot : Commands, traffic, broadcasts and connections so far
+ */
+Stats::Snapshot Reactor::getStats(void) const {
+    return _stats.getSnapshot();
+}
+
+/**
+ * @brief Add the latency histograms of this reactor to a sum. Callable from any thread.
+ *
+ * @param latencies Sum to add to
+ */
+void Reactor::addLatenciesTo(Stats::Latencies& latencies) const {
+    _stats.addLatenciesTo(latencies);
+}
+
+/**
+ * @brief Get the most unsent reply bytes a user of this reactor may have.
+ *
+ * @param isRegistered Class of the user: registered or not
+ * @return size_t : Send queue limit in bytes
+ */
+size_t Reactor::getSendQLimit(bool isRegistered) const {
+    return isRegistered ? _sendQ : UNREGISTERED_SENDQ;
+}
+
+/**
+ * @brief Entry point of the reactor thread.
+ *
+ * @param arg Reactor to run
+ * @return void* : Always NULL
+ */
+void *Reactor::threadMain(void *arg) {
+    static_cast<Reactor *>(arg)->run();
+    return NULL;
+}
+
+/**
+ * @brief Run the event loop on a new thread.
+ * @throw Throw runtime_error if thread creation fails.
+ */
+void Reactor::start(void) {
+    if (pthread_create(&_handle, NULL, &Reactor::threadMain, this) != 0)
+        throw(runtime_error("pthread_create() error"));
+    _isThreadStarted = true;
+}
+
+/**
+ * @brief Wait for the thread started by start() to finish.
+ */
+void Reactor::join(void) {
+    if (!_isThreadStarted) return ;
+    pthread_join(_handle, NULL);
+    _isThreadStarted = false;
+}
+
+/**
+ * @brief Ask the event loop to return. Callable from any thread.
+ */
+void Reactor::stop(void) {
+    __atomic_store_n(&_isStopping, 1, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&_wakePending, 1, __ATOMIC_SEQ_CST);
+    if (write(_wakeFd[1], "", 1) == ERR_RETURN) errno = 0;
+}
+
+/**
+ * @brief Manage clients that connect to the reactor's socket.
+ *  Loops on the calling thread until stop() is called or an error happens.
+ *  On error the message is kept in getError() and every reactor is stopped.
+ *  The wait times out at the next keepalive timer, or when the first throttled user gets a token back.
+ *  Each event dispatch, and the whole iteration after the wait returns (the loop lag), is timed.
+ */
+void Reactor::run(void) {
+    int numOfEvents;
+
+    _thread = pthread_self();
+    Stats::bindToThread(&_stats);
+    _reclaimer.bindToThread(_id);
+    try {
+        while (!__atomic_load_n(&_isStopping, __ATOMIC_SEQ_CST)) {
+            // No pointer to a shared object is held across the wait.
+            _reclaimer.setOnline(_id, false);
+            numOfEvents = _poller->wait(&_waitingEvents[0], _batchSize, getWaitTimeoutMs());
+            _reclaimer.setOnline(_id, true);
+            if (numOfEvents == ERR_RETURN) {
+                if (errno == EINTR) continue;
+                throw(runtime_error("poller wait error"));
+            }
+            _nowMs = Clock::nowMs();
+
+            const long wokenNs = Clock::nowNs();
+            long eventStartNs = wokenNs;
+
+            for (int i = 0; i < numOfEvents; ++i) {
+                handleEvent(_waitingEvents[i]);
+
+                const long eventEndNs = Clock::nowNs();
+
+                _stats.recordEvent(eventEndNs - eventStartNs);
+                eventStartNs = eventEndNs;
+            }
+            expireTimers();
+            printStatsIfDue();
+            resumeThrottledUsers();
+            drainInbox();
+            flushPendingReplies();
+            deleteClosedUsers();
+            _reclaimer.collect(_id);
+            adaptBatchSize(numOfEvents);
+            _stats.recordLoopLag(Clock::nowNs() - wokenNs);
+        }
+    } catch (exception& e) {
+        _error = e.what();
+        _server.stopReactors();
+    }
+    _reclaimer.setOnline(_id, false);
+}
+
+/**
+ * @brief Hand a reply over to this reactor. Callable from any thread.
+ *
+ * @param user Recipient. Must belong to this reactor.
+ * @param reply Reply to append to the recipient's reply buffer
+ */
+void Reactor::post(User *user, const SharedBuffer& reply) {
+    post(&user, 1, reply);
+}
+
+/**
+ * @brief Hand a reply for many users over to this reactor, with one wake-up.
+ *  Callable from any thread, which must be a reactor at its loop iteration
+ *  (or the only thread running), so that the recipients are not deleted yet.
+ *  Each node is counted before it is pushed, so that a user is deleted only
+ *  after the nodes that may name it are drained (see deleteClosedUsers()).
+ *
+ * @param users Recipients. Must belong to this reactor.
+ * @param count Number of recipients
+ * @param reply Reply to append to the reply buffer of each recipient
+ */
+void Reactor::post(User *const *users, size_t count, const SharedBuffer& reply) {
+    for (size_t begin = 0; begin < count; begin += REPLY_NODE_USER_NUM) {
+        ReplyNode *node = new ReplyNode;
+
+        node->reply = reply;
+        node->userNum = min(count - begin, static_cast<size_t>(REPLY_NODE_USER_NUM));
+        copy(users + begin, users + begin + node->userNum, node->users);
+        __atomic_add_fetch(&_postedNum, 1, __ATOMIC_SEQ_CST);
+        _inbox.push(node);
+    }
+    if (__atomic_exchange_n(&_wakePending, 1, __ATOMIC_ACQ_REL) == 0) {
+        if (write(_wakeFd[1], "", 1) == ERR_RETURN) errno = 0;
+    }
+}
+
+/**
+ * @brief Schedule a client whose reply buffer just became non-empty
+ *  to be sent at the end of the current loop iteration.
+ *  Called on the reactor thread only.
+ *
+ * @param user User of this reactor
+ */
+void Reactor::requestFlush(User *user) {
+    _pendingFlush.push_back(user);
+}
+
+/**
+ * @brief Consume the wake-up bytes written by post() and stop().
+ *  The pending flag is cleared first, so a post() that follows re-arms the wake-up.
+ */
+void Reactor::drainWakeFd(void) {
+    char buf[64];
+
+    __atomic_store_n(&_wakePending, 0, __ATOMIC_SEQ_CST);
+    while (read(_wakeFd[0], buf, sizeof(buf)) > 0) ;
+    errno = 0;
+}
+
+/**
+ * @brief Move replies posted by other threads into the reply buffers of their recipients.
+ *  Replies to users disconnected since are dropped.
+ */
+void Reactor::drainInbox(void) {
+    ReplyNode *node;
+
+    while ((node = _inbox.pop()) != NULL) {
+        for (size_t i = 0; i < node->userNum; ++i) {
+            if (!node->users[i]->getIsClosed()) node->users[i]->addToReplyBuffer(node->reply);
+        }
+        delete node;
+        ++_drainedNum;
+    }
+}
+
+/**
+ * @brief If new clients connect, assign a new socket to each of them.
+ * 	Accept until the backlog is empty, because the listening socket is edge-triggered.
+ * 	If possible, create a user instance and connect it to the socket you created.
+ *
+ * @throw new or container.insert can throw exception.
+ */
+void Reactor::acceptNewClient(void) {
+    int clientSocket;
+    struct sockaddr_in clientAddr;
+    socklen_t addrLen;
+    char hostStr[INET_ADDRSTRLEN];
+    User *user;
+
+    while (1) {
+        addrLen = sizeof(clientAddr);
+        memset(&clientAddr, 0, sizeof(clientAddr));
+        memset(hostStr, 0, sizeof(hostStr));
+        if ((clientSocket = accept(_fd, (struct sockaddr *)&clientAddr, &addrLen)) == ERR_RETURN) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                Logger::log(Logger::ERROR, "accept failed errno=%d reactor=%d", errno, _id);
+            errno = 0;
+            return ;
+        }
+        fcntl(clientSocket, F_SETFL, O_NONBLOCK);
+        inet_ntop(AF_INET, &clientAddr.sin_addr, hostStr, INET_ADDRSTRLEN);
+        if (!_server.reserveClient()) {
+            Logger::log(Logger::WARN, "client rejected reason=max_users host=%s reactor=%d", hostStr, _id);
+            close(clientSocket);
+            _stats.add(Stats::REJECTED, 1);
+            continue ;
+        }
+        user = new User(clientSocket, hostStr, this);
+        if (_users.size() <= static_cast<size_t>(clientSocket)) _users.resize(clientSocket + 1, NULL);
+        _users[clientSocket] = user;
+        _stats.add(Stats::ACCEPTED, 1);
+        Logger::log(Logger::INFO, "client accepted fd=%d host=%s reactor=%d", clientSocket, hostStr, _id);
+
+        _poller->addFd(clientSocket, user, false);
+        _timers.arm(&user->getTimer(), _nowMs + _registerTimeoutMs);
+    }
+}
+
+/**
+ * @brief Read from the client socket until it would block, directly into the cmd buffer for that user.
+ * 	The cmd buffer is checked after every recv(), so it never holds more than
+ * 	one chunk plus an incomplete line.
+ * 	A throttled user is not read until its buffered lines are handled; the socket
+ * 	is drained again by resumeThrottledUsers().
+ * 	This function will be called when a read event occurs on that client.
+ *
+ * @param targetUser User whose socket became readable.
+ */
+void Reactor::recvDataFromClient(User *targetUser) {
+    ssize_t recvBytes;
+    size_t writableBytes;
+    char *writePos;
+
+    while (1) {
+        if (targetUser->getIsThrottled()) return ;
+        writePos = targetUser->getCmdBuffer().prepareWrite(writableBytes);
+        recvBytes = recv(targetUser->getFd(), writePos, writableBytes, 0);
+        if (recvBytes > 0) {
+            _stats.add(Stats::BYTES_IN, recvBytes);
+            targetUser->setLastActiveMs(_nowMs);
+            targetUser->getCmdBuffer().commitWrite(recvBytes);
+            handleMessageFromBuffer(targetUser);
+            // The command may have disconnected the client already.
+            if (targetUser->getIsClosed() || targetUser->getIsQuiting()) return ;
+            continue;
+        }
+        if (recvBytes == ERR_RETURN && errno == EINTR) continue;
+        if (recvBytes == ERR_RETURN && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            errno = 0;
+            return ;
+        }
+        break;
+    }
+    if (recvBytes == 0) Logger::log(Logger::INFO, "client closed fd=%d", targetUser->getFd());
+    else Logger::log(Logger::WARN, "client recv_failed fd=%d errno=%d", targetUser->getFd(), errno);
+    closeWithQuit(targetUser, "Client closed connection");
+}
+
+/**
+ * @brief Pass the send buffer contents that the user has to the client until it would block.
+ * 	This function will be called for clients that got replies during a loop iteration,
+ * 	and when a write event occurs on a client whose socket was full.
+ * 	Write readiness is watched only while unsent replies remain after a send.
+ *
+ * @param targetUser User to send to.
+ */
+void Reactor::sendDataToClient(User *targetUser) {
+    ssize_t sendBytes;
+
+    while (!targetUser->getReplyBuffer().empty()) {
+        sendBytes = targetUser->sendReplyBuffer();
+        if (sendBytes == ERR_RETURN) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                errno = 0;
+                if (!targetUser->getIsWriteArmed()) {
+                    _poller->setWriteInterest(targetUser->getFd(), targetUser, true);
+                    targetUser->setIsWriteArmed(true);
+                }
+                return ;
+            }
+            Logger::log(Logger::WARN, "client send_failed fd=%d errno=%d", targetUser->getFd(), errno);
+            closeWithQuit(targetUser, "Client closed connection");
+            return ;
+        }
+        _stats.add(Stats::BYTES_OUT, sendBytes);
+    }
+    if (targetUser->getIsWriteArmed()) {
+        _poller->setWriteInterest(targetUser->getFd(), targetUser, false);
+        targetUser->setIsWriteArmed(false);
+    }
+    if (targetUser->getIsQuiting()) disconnectClient(targetUser);
+}
+
+/**
+ * @brief Send reply buffers that became non-empty during this loop iteration.
+ * 	Most replies fit in the socket buffer, so they are sent right away without
+ * 	waiting for a write event. Sockets that are full get write interest armed.
+ * 	Sending may queue more clients (QUIT notices of failed clients), which are handled too.
+ * 	Clients that went over their send queue limit are disconnected instead.
+ */
+void Reactor::flushPendingReplies(void) {
+    for (size_t i = 0; i < _pendingFlush.size(); ++i) {
+        User *user = _pendingFlush[i];
+
+        if (user->getIsClosed()) continue;
+        if (user->getIsSendQExceeded()) {
+            Logger::log(Logger::WARN, "client sendq_exceeded fd=%d total_queued=%lu", user->getFd(),
+                        _server.collectStats().sendQBytes);
+            closeWithQuit(user, "SendQ exceeded");
+            continue;
+        }
+        if (user->getIsWriteArmed()) continue;
+        sendDataToClient(user);
+    }
+    _pendingFlush.clear();
+}
+
+/**
+ * @brief Delete the users disconnected in earlier loop iterations that no other
+ *  thread can point to anymore, closing their already shut down sockets.
+ *  The fd number stays taken until then, so it cannot be reused by a new
+ *  client while a reply may still name the old user.
+ *  The users disconnected during this iteration are stamped first: once the
+ *  grace period of the stamp is over, the number of nodes posted to the inbox
+ *  is read, and the users are deleted when that many nodes were drained.
+ * 	Called after the event batch and the pending replies are handled.
+ */
+void Reactor::deleteClosedUsers(void) {
+    if (!_closedUsers.empty()) {
+        _closedBatches.push_back(ClosedBatch());
+        _closedBatches.back().stamp = _reclaimer.getStamp();
+        _closedBatches.back().isGraceOver = false;
+        _closedBatches.back().postedLimit = 0;
+        _closedBatches.back().users.swap(_closedUsers);
+    }
+    while (!_closedBatches.empty()) {
+        ClosedBatch& batch = _closedBatches.front();
+
+        if (!batch.isGraceOver) {
+            if (!_reclaimer.isGraceOver(batch.stamp, _id)) return ;
+            batch.isGraceOver = true;
+            batch.postedLimit = __atomic_load_n(&_postedNum, __ATOMIC_SEQ_CST);
+        }
+        if (_drainedNum < batch.postedLimit) return ;
+        for (size_t i = 0; i < batch.users.size(); ++i) delete batch.users[i];
+        _closedBatches.pop_front();
+    }
+}
+
+/**
+ * @brief Size the next event batch from how full this one was.
+ *  A full batch means more events are probably ready: double, up to the maximum.
+ *  A batch less than a quarter full: halve, down to MIN_EVENT_BATCH.
+ *
+ * @param numOfEvents Number of events the last wait returned
+ */
+void Reactor::adaptBatchSize(int numOfEvents) {
+    if (numOfEvents == _batchSize && _batchSize < _maxBatchSize) {
+        _batchSize = min(_batchSize * 2, _maxBatchSize);
+        if (_waitingEvents.size() < static_cast<size_t>(_batchSize)) _waitingEvents.resize(_batchSize);
+    } else if (numOfEvents * 4 < _batchSize && _batchSize > MIN_EVENT_BATCH) {
+        _batchSize = max(_batchSize / 2, MIN_EVENT_BATCH);
+    }
+}
+
+/**
+ * @brief Manage events from fd managed by the poller.
+ *	Socket error handling, new client connections, wake-ups from other reactors
+ *	and read/write processing from existing clients.
+ *	Events of clients disconnected earlier in the same batch are ignored.
+ *
+ * @param event Event information delivered by the poller.
+ */
+void Reactor::handleEvent(const PollEvent& event) {
+    User *user = static_cast<User *>(event.udata);
+
+    if (event.fd == _wakeFd[0]) {
+        drainWakeFd();
+        drainInbox();
+        return ;
+    }
+    if (event.fd == _fd) {
+        if (event.error) throw(runtime_error("server socket error"));
+        acceptNewClient();
+        return ;
+    }
+    if (user == NULL || user->getIsClosed()) return ;
+    if (event.error) {
+        Logger::log(Logger::WARN, "client socket_error fd=%d", user->getFd());
+        closeWithQuit(user, "Client closed connection");
+        return ;
+    }
+    if (event.readable) recvDataFromClient(user);
+    if (event.writable && !user->getIsClosed()) sendDataToClient(user);
+}
+
+/**
+ * @brief Passes messages truncated to CR/LF characters to the command processing function.
+ * Lines are consumed from the user's cmd buffer as they are passed.
+ * A line over MAX_MESSAGE_LEN is dropped and answered with ERR_INPUTTOOLONG.
+ * Every complete line spends a flood token; a partial line spends nothing.
+ * Once the user runs out, the line is put back, the remaining lines stay
+ * in the buffer and the user is throttled. A line over MAX_MESSAGE_LEN is
+ * already dropped, so it is answered with or without a token.
+ *
+ * @param user User to check buffer
+ */
+void Reactor::handleMessageFromBuffer(User* user) {
+    InputBuffer& cmdBuffer = user->getCmdBuffer();
+    InputBuffer::Status status;
+    const char *line;
+    size_t length;
+
+    while ((status = cmdBuffer.nextLine(line, length)) != InputBuffer::NO_LINE) {
+        const bool hasToken = takeFloodToken(user);
+
+        if (hasToken) user->getFloodBucket().take();
+        if (status == InputBuffer::LINE_TOO_LONG) {
+            user->addNumericReply(NumericReply::inputTooLong);
+            continue;
+        }
+        if (!hasToken) {
+            cmdBuffer.ungetLine(line, length);
+            break;
+        }
+        Message msg(line, length);
+        if (!_server.executeCommand(user, msg)) break;
+    }
+}
+
+/**
+ * @brief Check that the user may run one more command, with the limits of its class.
+ *  If not, the user is throttled until resumeThrottledUsers() finds a token for it.
+ *
+ * @param user User with a complete command line
+ * @return true : A token is there. take() it for the line / if not return
+ * @return false : User is throttled
+ */
+bool Reactor::takeFloodToken(User *user) {
+    const bool isRegistered = user->getAuth();
+    const int rate = isRegistered ? _floodRate : UNREGISTERED_FLOOD_RATE;
+    const int burst = isRegistered ? _floodBurst : UNREGISTERED_FLOOD_BURST;
+
+    if (user->getFloodBucket().refill(_nowMs, rate, burst)) return true;
+    if (!user->getIsThrottled()) {
+        user->setIsThrottled(true);
+        _throttledUsers.push_back(user);
+    }
+    return false;
+}
+
+/**
+ * @brief Get how long the poller may wait before a throttled user gets a token back.
+ *
+ * @return int : Milliseconds. -1 (no timeout) if no user is throttled.
+ */
+int Reactor::getThrottleWaitMs(void) const {
+    long waitMs = -1;
+
+    for (size_t i = 0; i < _throttledUsers.size(); ++i) {
+        User *user = _throttledUsers[i];
+        const long userWaitMs = user->getFloodBucket().getWaitMs(user->getAuth() ? _floodRate : UNREGISTERED_FLOOD_RATE);
+
+        if (waitMs == -1 || userWaitMs < waitMs) waitMs = userWaitMs;
+    }
+    if (waitMs == -1) return -1;
+    // The tokens were last counted at _nowMs, which is already in the past.
+    waitMs -= Clock::nowMs() - _nowMs;
+    return waitMs > 0 ? static_cast<int>(waitMs) : 0;
+}
+
+/**
+ * @brief Run the deferred lines of throttled users that got tokens back.
+ *  A user whose buffered lines are all handled is read again, because
+ *  the socket may have become readable while it was throttled.
+ *  Users that run out again are throttled again for the next iteration.
+ */
+void Reactor::resumeThrottledUsers(void) {
+    vector<User *> throttledUsers;
+
+    throttledUsers.swap(_throttledUsers);
+    for (size_t i = 0; i < throttledUsers.size(); ++i) {
+        User *user = throttledUsers[i];
+
+        user->setIsThrottled(false);
+        if (user->getIsClosed() || user->getIsQuiting()) continue;
+        handleMessageFromBuffer(user);
+        if (user->getIsClosed() || user->getIsQuiting()) continue;
+        recvDataFromClient(user);
+    }
+}
+
+/**
+ * @brief Get how long the poller may wait: until the next keepalive timer,
+ *  the next stats dump, or until a throttled user gets a token back, whichever comes first.
+ *
+ * @return int : Milliseconds. -1 (no timeout) if there is nothing to wait for.
+ */
+int Reactor::getWaitTimeoutMs(void) const {
+    const long nowMs = Clock::nowMs();
+    const int throttleWaitMs = getThrottleWaitMs();
+    int timerWaitMs = _timers.getTimeoutMs(nowMs);
+
+    if (!_closedBatches.empty() || _reclaimer.hasRetired(_id)) {
+        if (timerWaitMs == -1 || RECLAIM_WAIT_MS < timerWaitMs) timerWaitMs = RECLAIM_WAIT_MS;
+    }
+
+    if (_statsIntervalMs != 0) {
+        const int statsWaitMs = static_cast<int>(max(_nextStatsMs - nowMs, 0L));
+
+        if (timerWaitMs == -1 || statsWaitMs < timerWaitMs) timerWaitMs = statsWaitMs;
+    }
+    if (throttleWaitMs == -1) return timerWaitMs;
+    if (timerWaitMs == -1) return throttleWaitMs;
+    return min(throttleWaitMs, timerWaitMs);
+}
+
+/**
+ * @brief Handle the keepalive timers that expired by now.
+ */
+void Reactor::expireTimers(void) {
+    _timers.expire(_nowMs, _expiredTimers);
+    for (size_t i = 0; i < _expiredTimers.size(); ++i) {
+        User *user = static_cast<User *>(_expiredTimers[i]->data);
+
+        if (!user->getIsClosed() && !user->getIsQuiting()) handleTimer(user);
+    }
+    _expiredTimers.clear();
+}
+
+/**
+ * @brief Print the counters of the server when the stats interval has passed.
+ *  Only the first reactor has an interval.
+ */
+void Reactor::printStatsIfDue(void) {
+    if (_statsIntervalMs == 0 || _nowMs < _nextStatsMs) return ;
+    _server.printStats();
+    _nextStatsMs = _nowMs + _statsIntervalMs;
+}
+
+/**
+ * @brief Keepalive of a user whose timer expired.
+ *  Unregistered at the deadline: disconnect ("Registration timeout").
+ *  Silent since the PING: disconnect ("Ping timeout").
+ *  Silent for the ping interval: send a PING and wait for the ping timeout.
+ *  Otherwise wait until the ping interval after the last received bytes.
+ *
+ * @param user User whose timer expired. The timer is not armed anymore.
+ */
+void Reactor::handleTimer(User *user) {
+    if (!user->getAuth()) {
+        closeWithQuit(user, "Registration timeout");
+        return ;
+    }
+    if (user->getPingSentMs() != 0) {
+        if (user->getLastActiveMs() < user->getPingSentMs()) {
+            closeWithQuit(user, "Ping timeout");
+            return ;
+        }
+        user->setPingSentMs(0);
+    }
+
+    const long idleDeadlineMs = user->getLastActiveMs() + _pingIntervalMs;
+
+    if (idleDeadlineMs > _nowMs) {
+        _timers.arm(&user->getTimer(), idleDeadlineMs);
+        return ;
+    }
+    user->addToReplyBuffer(Message() << "PING" << ":" << SERVER_HOSTNAME);
+    user->setPingSentMs(_nowMs);
+    _timers.arm(&user->getTimer(), _nowMs + _pingTimeoutMs);
+}
+
+/**
+ * @brief Notify the channels of the user that the connection closed, and disconnect it.
+ *
+ * @param user User whose socket failed, was closed by the peer or fell too far behind
+ * @param reason Reason given in the QUIT message
+ */
+void Reactor::closeWithQuit(User *user, const char *reason) {
+    user->broadcastToMyChannels(Message() << user->getPrefix() << "QUIT" << ":" << reason, user->getFd());
+    disconnectClient(user);
+}
+
+/**
+ * @brief Disconnects a client of this reactor. The socket leaves the poller and
+ *  is shut down at once, so the peer sees the end of the stream now; the user
+ *  is deleted (and the fd closed) by deleteClosedUsers(), once no other thread
+ *  can point to it.
+ *  Must be called on the reactor thread.
+ *  Replies posted to the user from now on are discarded by drainInbox().
+ *
+ * @param user User to disconnect
+ */
+void Reactor::disconnectClient(User *user) {
+    const int clientFd = user->getFd();
+
+    if (user->getIsClosed()) return ;
+    _server.removeClient(user);
+    _poller->removeFd(clientFd);
+    shutdown(clientFd, SHUT_RDWR);
+    _users[clientFd] = NULL;
+    _timers.cancel(&user->getTimer());
+    if (user->getIsThrottled()) {
+        _throttledUsers.erase(find(_throttledUsers.begin(), _throttledUsers.end(), user));
+        user->setIsThrottled(false);
+    }
+    user->setIsClosed();
+    _closedUsers.push_back(user);
+    Logger::log(Logger::INFO, "client disconnected fd=%d", clientFd);
+}
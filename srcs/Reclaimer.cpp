@@ -0,0 +1,139 @@
+#include "Reclaimer.hpp"
+
+__thread Reclaimer *Reclaimer::_current = NULL;
+__thread size_t Reclaimer::_currentId = 0;
+
+/**
+ * @brief Construct a new Reclaimer:: Every thread starts offline, so a
+ *  reactor that never runs does not hold grace periods back.
+ *
+ * @param threadNum Number of reactors
+ */
+Reclaimer::Reclaimer(size_t threadNum) {
+    for (size_t i = 0; i < threadNum; ++i) _slots.push_back(new Slot());
+}
+
+/**
+ * @brief Destroy the Reclaimer:: Free what is still retired.
+ *  The reactors must be stopped.
+ */
+Reclaimer::~Reclaimer() {
+    for (size_t i = 0; i < _slots.size(); ++i) {
+        Slot *slot = _slots[i];
+
+        for (size_t j = 0; j < slot->retired.size(); ++j)
+            slot->retired[j].destroy(slot->retired[j].object);
+        for (size_t j = 0; j < slot->batches.size(); ++j) {
+            const vector<Retired>& objects = slot->batches[j].objects;
+
+            for (size_t k = 0; k < objects.size(); ++k) objects[k].destroy(objects[k].object);
+        }
+        delete slot;
+    }
+}
+
+/**
+ * @brief Make retire() on the calling thread use the retire list of a reactor.
+ *
+ * @param id Index of the reactor running on the calling thread
+ */
+void Reclaimer::bindToThread(size_t id) {
+    _current = this;
+    _currentId = id;
+}
+
+/**
+ * @brief Mark a quiescent point of a reactor: it holds no pointer to shared objects.
+ *  Called before the poller wait (offline) and after it (online).
+ *
+ * @param id Index of the reactor
+ * @param isOnline true when the reactor starts handling events again
+ */
+void Reclaimer::setOnline(size_t id, bool isOnline) {
+    unsigned long& state = _slots[id]->state;
+
+    // Odd while offline. A full barrier, so that the pointers read
+    // afterwards are read after the other threads can see the new state.
+    if (((state & 1) == 0) != isOnline) __atomic_add_fetch(&state, 1, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Take the states of all reactors, to start a grace period.
+ *
+ * @return Stamp : State of each reactor
+ */
+Reclaimer::Stamp Reclaimer::getStamp(void) const {
+    Stamp stamp(_slots.size());
+
+    for (size_t i = 0; i < _slots.size(); ++i) stamp[i] = __atomic_load_n(&_slots[i]->state, __ATOMIC_SEQ_CST);
+    return stamp;
+}
+
+/**
+ * @brief Check that every other reactor went through a quiescent point since the stamp.
+ *
+ * @param stamp Taken after the objects were unlinked
+ * @param id Index of the calling reactor, which is at a quiescent point itself
+ * @return true : Nothing unlinked before the stamp can be pointed to anymore / if not return
+ * @return false
+ */
+bool Reclaimer::isGraceOver(const Stamp& stamp, size_t id) const {
+    for (size_t i = 0; i < _slots.size(); ++i) {
+        if (i == id || (stamp[i] & 1) != 0) continue;
+        if (__atomic_load_n(&_slots[i]->state, __ATOMIC_SEQ_CST) == stamp[i]) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Check that a reactor has objects waiting to be freed.
+ *
+ * @param id Index of the reactor
+ * @return true : collect() has work left / if not return
+ * @return false
+ */
+bool Reclaimer::hasRetired(size_t id) const {
+    return !_slots[id]->retired.empty() || !_slots[id]->batches.empty();
+}
+
+/**
+ * @brief Queue an object of the calling reactor for freeing, or free it now
+ *  if the calling thread runs no reactor.
+ *
+ * @param destroy Function freeing the object
+ * @param object Object to free
+ */
+void Reclaimer::retire(void (*destroy)(void *), void *object) {
+    Retired retired;
+
+    if (_current == NULL) {
+        destroy(object);
+        return ;
+    }
+    retired.destroy = destroy;
+    retired.object = object;
+    _current->_slots[_currentId]->retired.push_back(retired);
+}
+
+/**
+ * @brief Stamp the objects a reactor retired during this loop iteration,
+ *  and free those whose grace period is over.
+ *  Called by the reactor at the end of each loop iteration.
+ *
+ * @param id Index of the calling reactor
+ */
+void Reclaimer::collect(size_t id) {
+    Slot& slot = *_slots[id];
+
+    if (!slot.retired.empty()) {
+        slot.batches.push_back(Batch());
+        slot.batches.back().stamp = getStamp();
+        slot.batches.back().objects.swap(slot.retired);
+    }
+    while (!slot.batches.empty() && isGraceOver(slot.batches.front().stamp, id)) {
+        const vector<Retired>& objects = slot.batches.front().objects;
+
+        for (size_t i = 0; i < objects.size(); ++i) objects[i].destroy(objects[i].object);
+        slot.batches.pop_front();
+    }
+}
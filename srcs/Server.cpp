@@ -1,40 +1,66 @@
 #include <iostream>
+#include <cstdio>
+#include <ctime>
+#include <sys/resource.h>
 #include "Server.hpp"
 #include "User.hpp"
 #include "Channel.hpp"
 #include "Message.hpp"
 #include "Command.hpp"
+#include "Reactor.hpp"
 #include "Reply.hpp"
 #include "CommonValue.hpp"
+#include "Logger.hpp"
 
 /**
- * @brief Construct a new Server:: Create a socket and wait for the client to connect.
+ * @brief Raise the soft limit of open files, so that max_users clients fit.
+ * 	If the hard limit is lower, raise it as far as allowed and warn.
  * 
- * @param port The port number that the client will use to connect to 
- * 	the IRC server from which it was created.
- * 	It will be get by argv[1].
- * @param password Password to check when connecting to the server.
- * 	Compare to the value delivered by the client using the PASS command.
- * 	It will be get by argv[2].
+ * @param wanted Number of fds the server needs
  */
-Server::Server(int port, string password): _fd(UNDEFINED_FD), _kq(UNDEFINED_FD), _port(port), _password(password), _command(*this) {
-	struct sockaddr_in serverAddr;
+static void raiseOpenFileLimit(rlim_t wanted) {
+	struct rlimit limit;
+
+	if (getrlimit(RLIMIT_NOFILE, &limit) == ERR_RETURN || limit.rlim_cur >= wanted) return;
+	limit.rlim_cur = (limit.rlim_max != RLIM_INFINITY && limit.rlim_max < wanted) ? limit.rlim_max : wanted;
+	if (setrlimit(RLIMIT_NOFILE, &limit) == ERR_RETURN) getrlimit(RLIMIT_NOFILE, &limit);
+	if (limit.rlim_cur < wanted)
+		Logger::log(Logger::WARN, "open_file_limit too_low limit=%lu needed=%lu",
+					static_cast<unsigned long>(limit.rlim_cur), static_cast<unsigned long>(wanted));
+}
 
-	if ((_fd = socket(PF_INET, SOCK_STREAM, 0)) == ERR_RETURN)
-		shutDown("socket() error");
-	
-	memset(&serverAddr, 0, sizeof(serverAddr));
-    serverAddr.sin_family = AF_INET;
-    serverAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-    serverAddr.sin_port = htons(_port);
-	fcntl(_fd, F_SETFL, O_NONBLOCK);
-	updateEvents(_fd, EVFILT_READ, EV_ADD | EV_ENABLE, 0, 0, NULL);
-
-	if (::bind(_fd, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) == ERR_RETURN)
-        shutDown("bind() error");
-
-	if (listen(_fd, 5) == ERR_RETURN)
-        shutDown("listen() error");
+/**
+ * @brief Construct a new Server:: Create the reactors, each with its own listening socket.
+ * 
+ * @param config Server settings.
+ * 	config.port is the port number that the client will use to connect to 
+ * 	the IRC server from which it was created. It will be get by argv[1].
+ * 	config.password is the password to check when connecting to the server.
+ * 	Compare to the value delivered by the client using the PASS command. It will be get by argv[2].
+ * 	config.reactorNum is the number of event loop threads.
+ * 	config.maxUsers and config.maxChannels limit the number of clients and channels.
+ * 	config.maxEvents is the largest event batch of a reactor.
+ * 	config.floodRate and config.floodBurst limit the commands of registered clients.
+ * 	config.sendQ limits the unsent replies of registered clients.
+ * 	config.pingInterval, config.pingTimeout and config.registerTimeout drive the keepalive timers.
+ */
+Server::Server(const ServerConfig& config)
+	: _port(config.port), _password(config.password), _maxUsers(config.maxUsers),
+	  _maxChannels(config.maxChannels), _userNum(0), _channelNum(0), _reclaimer(config.reactorNum), _command(*this) {
+	const time_t now = time(NULL);
+	char created[64];
+
+	strftime(created, sizeof(created), "%a %b %d %Y at %H:%M:%S UTC", gmtime(&now));
+	_welcomeBurst.add(NumericReply::yourHost);
+	_welcomeBurst.add(NumericReply::created, created);
+	// Each reactor has a listening socket, a poller and a wake-up pipe.
+	raiseOpenFileLimit(_maxUsers + config.reactorNum * 4 + 16);
+	try {
+		for (int i = 0; i < config.reactorNum; ++i)
+			_reactors.push_back(new Reactor(*this, i, config));
+	} catch (exception& e) {
+		shutDown(e.what());
+	}
 }
 
 /**
@@ -43,342 +69,338 @@ Server::Server(int port, string password): _fd(UNDEFINED_FD), _kq(UNDEFINED_FD),
 Server::~Server() { }
 
 /**
- * @brief Create kququq.
- * @throw Throw runtime_error if kqueue creation fails.
+ * @brief Gets the reclaimer that frees users, channels and member lists
+ * 	once no reactor can still point to them.
+ * 
+ * @return Reclaimer& : Reclaimer of the reactors
  */
-void Server::initKqueue(void) {
-    if ((_kq = kqueue()) == ERR_RETURN)
-        throw(runtime_error("kqueue() error"));
+Reclaimer& Server::getReclaimer(void) {
+	return _reclaimer;
 }
 
 /**
- * @brief Processes the registration of sockets and events to be managed by kqueue.
+ * @brief Gets the replies every client receives after RPL_WELCOME.
+ * 	They only depend on the server, so they are serialized once, at start-up.
  * 
- * @param socket Client socket fd
- * @param filter Event filter. EVFILT_REAT, EVFILT_WRITE
- * @param flags Handle event. EV_ADD, EV_ENABLE
- * @param fflags Flag depend on filter. Not used.
- * @param data Data value depend on filter. Not used.
- * @param udata User-data that can be used at the event return. Not used.
+ * @return const ReplyBurst& : RPL_YOURHOST and RPL_CREATED
  */
-void Server::updateEvents(int socket, int16_t filter, uint16_t flags, uint32_t fflags, intptr_t data, void *udata) {
-	struct kevent event;
-
-	EV_SET(&event, socket, filter, flags, fflags, data, udata);
-	_eventCheckList.push_back(event);
+const ReplyBurst& Server::getWelcomeBurst(void) const {
+	return _welcomeBurst;
 }
 
 /**
- * @brief If a new client connects, assign a new socket to connect.
- * 	If possible, create a user instance and connect it to the socket you created.
+ * @brief Search by user's nickname. Nicknames are case insensitive (RFC 1459 case mapping).
  * 
- * @throw new or container.insert can throw exception.
+ * @param nickname Nickname for find
+ * @return User* : Returns the pointer to the user instance of the user found.
+ * 	Returns NULL if not found.
  */
-void Server::acceptNewClient(void) {
-	int clientSocket;
-	struct sockaddr_in clientAddr;
-	socklen_t addrLen = sizeof(clientAddr);
-	char hostStr[INET_ADDRSTRLEN];
-	User *user;
-
-	memset(&clientAddr, 0, sizeof(clientAddr));
-	memset(hostStr, 0, sizeof(hostStr));
-	if ((clientSocket = accept(_fd, (struct sockaddr *)&clientAddr, &addrLen)) == ERR_RETURN) {
-		cerr << "aceept() failed! Check errno : " << errno << endl;
-		errno = 0;
-		return ;
-	}
-	if (_allUser.size() >= MAX_USER_NUM) {
-		cout << "Server reached max number of user" << endl;
-		close(clientSocket);
-		return ;
-	}
-	fcntl(clientSocket, F_SETFL, O_NONBLOCK);
-	inet_ntop(AF_INET, &clientAddr.sin_addr, hostStr, INET_ADDRSTRLEN);
-	cout << "accept new client: " << clientSocket << " / Host : " << hostStr << endl;
-	fcntl(clientSocket, F_SETFL, O_NONBLOCK);
-
-	updateEvents(clientSocket, EVFILT_READ, EV_ADD | EV_ENABLE, 0, 0, NULL);
-	updateEvents(clientSocket, EVFILT_WRITE, EV_ADD | EV_ENABLE, 0, 0, NULL);
-
-	user = new User(clientSocket, hostStr);
-	_allUser.insert(make_pair(clientSocket, user));
+User* Server::findClientByNickname(const StringView& nickname) const {
+	return _userByNickname.find(nickname);
 }
 
 /**
- * @brief Read from the client socket and save it to the cmd buffer for that user.
- * 	It then calls a function that checks the cmd buffer for that user.
- * 	This function will be called when a read event occurs on that client.
+ * @brief Search by user's nickname, and copy the nickname as the user set it.
+ * 	The user may belong to another reactor, which may rename it at any time:
+ * 	replies naming it must use the copy, not the user's own nickname.
  * 
- * @param event Event information delivered by kqueue.
+ * @param nickname Nickname for find
+ * @param storedNickname Set to the nickname of the user found
+ * @return User* : Returns the pointer to the user instance of the user found.
+ * 	Returns NULL if not found.
  */
-void Server::recvDataFromClient(const struct kevent& event) {
-	char buf[513];
-	map<int, User *>::iterator it = _allUser.find(event.ident);
-	User* targetUser = it->second;
-	int recvBytes;
-
-	if (it == _allUser.end()) return ;
-
-	recvBytes = recv(event.ident, buf, 512, 0);
-	if (recvBytes <= 0) {
-		if (recvBytes == ERR_RETURN && errno == EAGAIN) {
-			errno = 0;
-			return;
-		}
-		cerr << "client recv error!" << endl;
-		targetUser->broadcastToMyChannels(Message() << ":" << targetUser->getSource() << "QUIT" << ":" << "Client closed connection", event.ident);
-		disconnectClient(event.ident);
-	} else {
-		buf[recvBytes] = '\0';
-		targetUser->addToCmdBuffer(buf);
-		handleMessageFromBuffer(targetUser);
-	}
+User* Server::findClientByNickname(const StringView& nickname, string& storedNickname) const {
+	return _userByNickname.find(nickname, storedNickname);
 }
 
 /**
- * @brief Pass the send buffer contents that the user has to the client.
- * 	This function will be called when a write event occurs on that client.
+ * @brief Search by channel name. Channel names are case insensitive (RFC 1459 case mapping).
  * 
- * @param event Event information delivered by kqueue.
+ * @param name Channel name for find
+ * @return Channel* : Returns the pointer to the channel instance of the channel found.
+ * 	Returns NULL if not found.
  */
-void Server::sendDataToClient(const struct kevent& event) {
-	map<int, User *>::iterator it = _allUser.find(event.ident);
-	User* targetUser = it->second;
-	int sendBytes;
-
-	if (it == _allUser.end()) return ;
-	if (targetUser->getReplyBuffer().empty()) return;
-
-	sendBytes = send(event.ident, targetUser->getReplyBuffer().c_str(), targetUser->getReplyBuffer().length(), 0);
-	if (sendBytes == ERR_RETURN) {
-		if (errno == EAGAIN || errno == EWOULDBLOCK) {
-			errno = 0;
-			return ;
-		}
-		cerr << "client send error!" << endl;
-		targetUser->broadcastToMyChannels(Message() << ":" << targetUser->getSource() << "QUIT" << ":" << "Client closed connection", event.ident);
-		disconnectClient(event.ident);  
-	} else {
+Channel* Server::findChannelByName(const StringView& name) const {
+	if (name[0] != '#') return NULL;
 
-		targetUser->setReplyBuffer(targetUser->getReplyBuffer().substr(sendBytes));
-		if (targetUser->getIsQuiting() && targetUser->getReplyBuffer().empty()) disconnectClient(event.ident);
-	}
+	return _channelByName.find(name);
 }
 
 /**
- * @brief Manage events from fd managed by kqueue.
- *	Socket error handling, new client connections, and read/write processing from existing clients.
+ * @brief Verify that it matches the server password.
  * 
- * @param event Event information delivered by kqueue.
+ * @param password Password passed by user with PASS command
+ * @return true : Password match / if not return
+ * @return false 
  */
-void Server::handleEvent(const struct kevent& event) {
-	if (event.flags & EV_ERROR) {
-		if (event.ident == (const uintptr_t)_fd)
-			throw(runtime_error("server socket error"));
-		else {
-			User *targetUser = _allUser[event.ident];
-
-			cerr << "client socket error" << endl;
-			targetUser->broadcastToMyChannels(Message() << ":" << targetUser->getSource() << "QUIT" << ":" << "Client closed connection", event.ident);
-			disconnectClient(event.ident);
-		}
-	} else if (event.filter == EVFILT_READ) {
-		if (event.ident == (const uintptr_t)_fd)
-			acceptNewClient();
-		else
-			recvDataFromClient(event);
-	} else if (event.filter == EVFILT_WRITE)
-		sendDataToClient(event);
+bool Server::checkPassword(const string& password) const {
+	if (_password == password) return true;
+
+	return false;
 }
 
 /**
- * @brief Passes messages truncated to CR/LF characters to the command processing function.
- * Remove the passed string from the user's cmd buffer.
+ * @brief Add a new channel to the server.
+ * 	If another reactor added the same name first, that channel is returned instead.
  * 
- * @param user User to check buffer
+ * @param name Channel name to add
+ * @return Channel* : Returns the pointer of the channel instance with that name.
+ * 	Returns NULL if there is none and max_channels is reached.
+ * @throw container.insert can throw exception
  */
-void Server::handleMessageFromBuffer(User* user) {
-	size_t crlfPos;
+Channel* Server::addChannel(const string& name) {
+	if (__atomic_add_fetch(&_channelNum, 1, __ATOMIC_RELAXED) > _maxChannels) {
+		__atomic_sub_fetch(&_channelNum, 1, __ATOMIC_RELAXED);
+		return _channelByName.find(name);
+	}
 
-	while ((crlfPos = checkCmdBuffer(user)) != string::npos) {
-		if (crlfPos == 0) {
-			user->setCmdBuffer(user->getCmdBuffer().substr(1));
-			continue;
-		}
-		Message msg(user->getCmdBuffer().substr(0, crlfPos));
-		user->setCmdBuffer(user->getCmdBuffer().substr(crlfPos + 1));
-		if (!_command.run(user, msg)) break;
+	Channel *ch = new Channel(name);
+	Channel *owner = _channelByName.insert(name, ch);
+
+	if (owner != NULL) {
+		__atomic_sub_fetch(&_channelNum, 1, __ATOMIC_RELAXED);
+		delete ch;
+		return owner;
 	}
+	Logger::log(Logger::INFO, "channel added name=%s", name.c_str());
+	return ch;
 }
 
 /**
- * @brief Verify that the user's cmd buffer has characters (CR or LF).
- * If any, returns the position of the first CR/LF characters.
+ * @brief Deletes a channel that exists on the server: drop it from the name index,
+ * 	and its reference from the index. Only a closed channel (no member left) is deleted.
+ * 	Deleting it again, from any reactor, does nothing.
  * 
- * @param user User to check buffer
- * @return size_t : Position of CR/LF character. If it does not exist, return string::npos.
+ * @param ch Channel to delete
  */
-size_t Server::checkCmdBuffer(const User *user) const {
-	const size_t	crPos = user->getCmdBuffer().find(CR, 0);
-	const size_t	lfPos = user->getCmdBuffer().find(LF, 0);
-
-	if (crPos == string::npos && lfPos == string::npos) return string::npos;
-	if (lfPos == string::npos) return crPos;
-	if (crPos == string::npos) return lfPos;
-	return min(crPos, lfPos);
+void Server::deleteChannel(Channel *ch) {
+	if (!_channelByName.erase(ch->getName(), ch)) return ;
+	
+	__atomic_sub_fetch(&_channelNum, 1, __ATOMIC_RELAXED);
+	Logger::log(Logger::INFO, "channel deleted name=%s", ch->getName().c_str());
+	ch->release();
 }
 
 /**
- * @brief Gets the entire channel managed by the server.
+ * @brief Count one more user, if the server can accept it.
+ * 	Callable from any reactor; the user is handed back with removeClient().
  * 
- * @return const map<string, Channel *>& : Returns a map whose key is the channel name and 
- * 	value is the channel instance pointer.
+ * @return true : Counted / if the server reached max_users return
+ * @return false 
  */
-const map<string, Channel *>& Server::getAllChannel(void) const {
-	return _allChannel;
+bool Server::reserveClient(void) {
+	if (__atomic_add_fetch(&_userNum, 1, __ATOMIC_RELAXED) <= _maxUsers) return true;
+	__atomic_sub_fetch(&_userNum, 1, __ATOMIC_RELAXED);
+	return false;
 }
 
 /**
- * @brief Search by user's nickname.
+ * @brief Remove a user from the server.
+ * Withdraw from the channel to which the user belonged (delete channel if necessary).
+ * The user instance itself is deleted by its reactor, once no other reactor can point to it.
  * 
- * @param nickname Nickname for find
- * @return User* : Returns the pointer to the user instance of the user found.
- * 	Returns NULL if not found.
+ * @param user User to remove
  */
-User* Server::findClientByNickname(const string& nickname) const {
-	map<int, User*>::const_iterator it;
-	for (it = _allUser.cbegin(); it != _allUser.end(); ++it) {
-		if (it->second->getNickname() == nickname) return it->second;
+void Server::removeClient(User *user) {
+	const vector<Channel *> userChannelList = user->getMyAllChannel();
+
+	__atomic_sub_fetch(&_userNum, 1, __ATOMIC_RELAXED);
+	_userByNickname.erase(user->getNickname(), user);
+	for (vector<Channel *>::const_iterator it = userChannelList.begin(); it != userChannelList.end(); ++it) {
+		const int remainUsers = (*it)->deleteUser(user->getFd());
+		if (remainUsers == 0) deleteChannel(*it);
 	}
-	return NULL;
+	user->clearMyChannelList();
 }
 
 /**
- * @brief Search by channel name.
+ * @brief Set the nickname of a user and keep the nickname index of the server
+ * and of every channel of the user up to date.
+ * Checking that the nickname is free and taking it is one step under the lock of its index shard.
+ * A user can change the case of its own nickname.
  * 
- * @param name Channel name for find
- * @return Channel* : Returns the pointer to the channel instance of the channel found.
- * 	Returns NULL if not found.
+ * @param user User to rename
+ * @param nickname New nickname (already validated)
+ * @return true : Renamed / if the nickname is used by another user return
+ * @return false 
  */
-Channel* Server::findChannelByName(const string& name) const {
-	if (name[0] != '#') return NULL;
-	
-	map<string, Channel *>::const_iterator it;
-	for (it = _allChannel.cbegin(); it != _allChannel.end(); ++it) {
-		if (it->second->getName() == name) return it->second;
+bool Server::renameClient(User *user, const string& nickname) {
+	User *owner = _userByNickname.insert(nickname, user);
+
+	if (owner != NULL && owner != user) return false;
+
+	const string oldNickname = user->getNickname();
+	const vector<Channel *>& userChannelList = user->getMyAllChannel();
+
+	if (owner == NULL) _userByNickname.erase(oldNickname, user);
+	user->setNickname(nickname);
+	for (vector<Channel *>::const_iterator it = userChannelList.begin(); it != userChannelList.end(); ++it) {
+		(*it)->renameUser(user, oldNickname);
 	}
-	return NULL;
+	return true;
 }
 
 /**
- * @brief Verify that it matches the server password.
+ * @brief Run one command of a user, on the thread of its reactor.
+ * 	Commands take no server-wide lock: the indexes lock one shard, channels their own lock.
  * 
- * @param password Password passed by user with PASS command
- * @return true : Password match / if not return
- * @return false 
+ * @param user Message sender
+ * @param msg Parsed message
+ * @return true : Keep going //
+ * @return false : Notify the reactor that buffer checks are no longer needed
  */
-bool Server::checkPassword(const string& password) const {
-	if (_password == password) return true;
+bool Server::executeCommand(User *user, const Message& msg) {
+	return _command.run(user, msg);
+}
 
-	return false;
+/**
+ * @brief Disconnects a specific client from a server.
+ * Must be called from the reactor of that client, which is the case for every command.
+ * 
+ * @param user User to disconnect
+ */
+void Server::disconnectClient(User *user) {
+	user->getReactor()->disconnectClient(user);
 }
 
 /**
- * @brief Add a new channel to the server.
+ * @brief Sum the activity counters of every reactor. Callable from any thread, without the lock.
  * 
- * @param name Channel name to add
- * @return Channel* : Returns the pointer of the added channel instance.
- * 	Returns NULL if it fails.
- * @throw container.insert can throw exception
+ * @return Stats::Snapshot : Counters of the whole server
  */
-Channel* Server::addChannel(const string& name) {
-	if (_allChannel.size() >= MAX_CHANNEL_NUM) return NULL;
-	
-	Channel *ch;
+Stats::Snapshot Server::collectStats(void) const {
+	Stats::Snapshot stats;
 
-	ch = new Channel(name);
-	_allChannel.insert(make_pair(name, ch));
-	cout << "channel added: " << name << '\n';
-	return ch;
+	for (vector<Reactor *>::const_iterator it = _reactors.begin(); it != _reactors.end(); ++it)
+		stats += (*it)->getStats();
+	return stats;
 }
 
 /**
- * @brief Deletes a channel that exists on the server.
+ * @brief Sum the latency histograms of every reactor, since the last resetLatencies().
+ * 	Callable from any reactor.
  * 
- * @param name Channel name to delete
+ * @param latencies Filled with the histograms of the whole server. Must be empty.
  */
-void Server::deleteChannel(const string& name) {
-	map<string, Channel *>::iterator it = _allChannel.find(name);
-	Channel *ch = it->second;
+void Server::collectLatencies(Stats::Latencies& latencies) const {
+	ScopedLock lock(_latencyLock);
 
-	if (it == _allChannel.end()) return ;
-	
-	cout << "Delete channel from server: " << name << '\n';
-	_allChannel.erase(name);
-	delete ch;
+	for (vector<Reactor *>::const_iterator it = _reactors.begin(); it != _reactors.end(); ++it)
+		(*it)->addLatenciesTo(latencies);
+	latencies -= _latencyBaseline;
 }
 
 /**
- * @brief Disconnects a specific client from a server.
- * Delete user, withdraw from the channel to which 
- * 	the user belonged (delete channel if necessary)
- * 
- * @param clientFd Socket fd of client to disconnect
+ * @brief Restart the latency histograms from empty, as seen by collectLatencies().
+ * 	The reactors keep counting: their current counts become the baseline
+ * 	to subtract, so that no reactor has to be stopped or synchronized.
+ * 	Callable from any reactor.
  */
-void Server::disconnectClient(int clientFd) {
-	map<int, User *>::iterator it = _allUser.find(clientFd);
-	User* targetUser = it->second;
+void Server::resetLatencies(void) {
+	ScopedLock lock(_latencyLock);
 
-	if (it == _allUser.end()) return ;
+	_latencyBaseline = Stats::Latencies();
+	for (vector<Reactor *>::const_iterator it = _reactors.begin(); it != _reactors.end(); ++it)
+		(*it)->addLatenciesTo(_latencyBaseline);
+}
 
-    _allUser.erase(clientFd);
-	const vector<Channel *> userChannelList = targetUser->getMyAllChannel();
-	for (vector<Channel *>::const_iterator it = userChannelList.begin(); it != userChannelList.end(); ++it) {
-		const int remainUsers = (*it)->deleteUser(targetUser->getFd());
-		if (remainUsers == 0) deleteChannel((*it)->getName());
+/**
+ * @brief Log the counters reported by STATS: a "stats counters" record, and a
+ * 	"stats commands" one where commands that were never run are left out.
+ */
+void Server::printStats(void) const {
+	const Stats::Snapshot stats = collectStats();
+	char line[LOG_RECORD_SIZE];
+	size_t length = 0;
+
+	for (size_t i = 0; i < Stats::COUNTER_NUM && length < sizeof(line); ++i)
+		length += snprintf(line + length, sizeof(line) - length, " %s=%lu",
+						   Stats::getName(static_cast<Stats::Counter>(i)), stats.counters[i]);
+	Logger::log(Logger::INFO, "stats counters%s sendq_bytes=%lu sendq_peak_bytes=%lu log_dropped=%lu", line,
+				stats.sendQBytes, stats.sendQPeakBytes, Logger::getDroppedNum());
+	line[0] = '\0';
+	length = 0;
+	for (size_t i = 0; i <= COMMAND_TABLE_SIZE && length < sizeof(line); ++i) {
+		if (stats.commands[i] != 0)
+			length += snprintf(line + length, sizeof(line) - length, " %s=%lu", Command::getName(i), stats.commands[i]);
 	}
-	targetUser->clearMyChannelList();
-	delete targetUser;
-	cout << "client disconnected: " << clientFd << '\n';
+	Logger::log(Logger::INFO, "stats commands%s", line);
 }
 
 /**
- * @brief Manage clients that connect to the server's sockets.
- * 	This function turns an infinite loop.
+ * @brief Run the reactors until one of them fails.
+ * 	With a single reactor the loop runs on the calling thread,
+ * 	otherwise each reactor gets its own thread.
+ * 
+ * @throw Throw runtime_error with the error of the failed reactor.
  */
 void Server::run() {
-	int numOfEvents;
-	
-	initKqueue();
-	cout << "listening..." << endl;
-	while (1) {
-        numOfEvents = kevent(_kq, &_eventCheckList[0], _eventCheckList.size(), _waitingEvents, 8, NULL);
-        if (numOfEvents == ERR_RETURN)
-            shutDown("kevent() error");
-	
-        _eventCheckList.clear();
-        for (int i = 0; i < numOfEvents; ++i)
-            handleEvent(_waitingEvents[i]);
-    }
+	Logger::log(Logger::INFO, "server listening port=%d reactors=%lu", _port,
+				static_cast<unsigned long>(_reactors.size()));
+	if (_reactors.size() == 1)
+		_reactors[0]->run();
+	else {
+		for (vector<Reactor *>::iterator it = _reactors.begin(); it != _reactors.end(); ++it) {
+			try {
+				(*it)->start();
+			} catch (exception& e) {
+				stopReactors();
+				for (vector<Reactor *>::iterator started = _reactors.begin(); started != it; ++started)
+					(*started)->join();
+				throw;
+			}
+		}
+		for (vector<Reactor *>::iterator it = _reactors.begin(); it != _reactors.end(); ++it)
+			(*it)->join();
+	}
+	for (vector<Reactor *>::iterator it = _reactors.begin(); it != _reactors.end(); ++it) {
+		if (!(*it)->getError().empty()) throw(runtime_error((*it)->getError()));
+	}
+}
+
+/**
+ * @brief Ask every reactor to stop its loop. Callable from any thread.
+ */
+void Server::stopReactors(void) {
+	for (vector<Reactor *>::iterator it = _reactors.begin(); it != _reactors.end(); ++it)
+		(*it)->stop();
+}
+
+/**
+ * @brief Log the poller counters of a reactor, for tuning max_events.
+ *
+ * @param reactor Stopped reactor
+ */
+static void printPollerStats(const Reactor& reactor) {
+	const Poller::Stats stats = reactor.getPollerStats();
+
+	Logger::log(Logger::INFO, "poller reactor=%d events=%lu waits=%lu per_wait=%.2f full_waits=%lu "
+				"changes=%lu submitted_changes=%lu change_calls=%lu", reactor.getId(),
+				stats.eventNum, stats.waitNum, stats.waitNum ? static_cast<double>(stats.eventNum) / stats.waitNum : 0,
+				stats.fullWaitNum, stats.changeNum, stats.submittedChangeNum, stats.changeCallNum);
 }
 
 /**
  * @brief Called when the server shuts down abnormally.
+ * 	The logger is stopped, so that its pending records are written out.
  * 
- * @param msg Error message to output to console
+ * @param msg Error message to log, and to output to console
  */
 void Server::shutDown(const string& msg) {
-	if (_fd != UNDEFINED_FD)
-		close(_fd);
-	if (_kq != UNDEFINED_FD)
-		close(_kq);
-	for (map<int, User *>::iterator it = _allUser.begin(); it != _allUser.end(); it++) {
-		delete it->second;
+	stopReactors();
+	for (vector<Reactor *>::iterator it = _reactors.begin(); it != _reactors.end(); it++) {
+		(*it)->join();
+		printPollerStats(**it);
+		delete *it;
 	}
-	for (map<string, Channel *>::iterator it = _allChannel.begin(); it != _allChannel.end(); it++) {
-		delete it->second;
+	vector<Channel *> channels;
+
+	_channelByName.getValues(channels);
+	for (vector<Channel *>::iterator it = channels.begin(); it != channels.end(); it++) {
+		delete *it;
 	}
+	Logger::log(Logger::ERROR, "server shutdown reason=%s", msg.c_str());
+	Logger::stop();
 	cerr << msg << endl;
 	exit(EXIT_FAILURE);
 }
@@ -0,0 +1,81 @@
+#include <cstdlib>
+#include <cerrno>
+#include "ServerConfig.hpp"
+#include "CommonValue.hpp"
+
+/**
+ * @brief Parse a positive integer option value.
+ *
+ * @param str Value string
+ * @param maxValue Largest accepted value
+ * @param result Parsed value is stored here on success
+ * @return true : str is a number in [1, maxValue] / if not return
+ * @return false
+ */
+static bool parsePositive(const string& str, long maxValue, int& result) {
+    char *pEnd;
+    long value;
+
+    errno = 0;
+    value = strtol(str.c_str(), &pEnd, 10);
+    if (errno == ERANGE || str.empty() || *pEnd != '\0' || value <= 0 || value > maxValue) return false;
+    result = static_cast<int>(value);
+    return true;
+}
+
+/**
+ * @brief Construct a new ServerConfig:: Fill with default settings
+ */
+ServerConfig::ServerConfig(void)
+    : port(0), reactorNum(DEFAULT_REACTOR_NUM), maxUsers(MAX_USER_NUM), maxChannels(MAX_CHANNEL_NUM),
+      maxEvents(DEFAULT_MAX_EVENTS), floodRate(DEFAULT_FLOOD_RATE), floodBurst(DEFAULT_FLOOD_BURST),
+      sendQ(DEFAULT_SENDQ), pingInterval(DEFAULT_PING_INTERVAL), pingTimeout(DEFAULT_PING_TIMEOUT),
+      registerTimeout(DEFAULT_REGISTER_TIMEOUT), statsInterval(DEFAULT_STATS_INTERVAL),
+      logLevel(Logger::INFO) { }
+
+/**
+ * @brief Apply one "<key>=<value>" option.
+ *  threads=<n> : Number of event loop threads (1 ~ MAX_REACTOR_NUM)
+ *  max_users=<n> : Number of clients connected at once (1 ~ MAX_USER_LIMIT)
+ *  max_channels=<n> : Number of channels (1 ~ MAX_CHANNEL_LIMIT)
+ *  max_events=<n> : Most ready events a reactor takes per wait (MIN_EVENT_BATCH ~ MAX_EVENTS_LIMIT)
+ *  flood_rate=<n> : Commands per second of a registered client (1 ~ MAX_FLOOD_LIMIT)
+ *  flood_burst=<n> : Commands a registered client may send at once (1 ~ MAX_FLOOD_LIMIT)
+ *  sendq=<n> : Bytes of memory the unsent replies of a registered client may hold (1 ~ MAX_SENDQ_LIMIT)
+ *  ping_interval=<n> : Seconds of silence before a client is sent a PING (1 ~ MAX_TIMEOUT_LIMIT)
+ *  ping_timeout=<n> : Seconds a client has to answer a PING (1 ~ MAX_TIMEOUT_LIMIT)
+ *  register_timeout=<n> : Seconds a client has to register (1 ~ MAX_TIMEOUT_LIMIT)
+ *  stats_interval=<n> : Seconds between two dumps of the STATS counters (1 ~ MAX_TIMEOUT_LIMIT)
+ *  log_file=<path> : File to log to, instead of the standard output
+ *  log_level=<level> : Least level logged (debug, info, warn or error)
+ *
+ * @param option Option string passed by command line
+ * @return true : Option applied / if not return
+ * @return false : Unknown key or invalid value
+ */
+bool ServerConfig::parseOption(const string& option) {
+    const size_t equalPos = option.find('=');
+
+    if (equalPos == string::npos) return false;
+
+    const string key = option.substr(0, equalPos);
+    const string value = option.substr(equalPos + 1);
+
+    if (key == "threads") return parsePositive(value, MAX_REACTOR_NUM, reactorNum);
+    if (key == "max_users") return parsePositive(value, MAX_USER_LIMIT, maxUsers);
+    if (key == "max_channels") return parsePositive(value, MAX_CHANNEL_LIMIT, maxChannels);
+    if (key == "max_events") return parsePositive(value, MAX_EVENTS_LIMIT, maxEvents) && maxEvents >= MIN_EVENT_BATCH;
+    if (key == "flood_rate") return parsePositive(value, MAX_FLOOD_LIMIT, floodRate);
+    if (key == "flood_burst") return parsePositive(value, MAX_FLOOD_LIMIT, floodBurst);
+    if (key == "sendq") return parsePositive(value, MAX_SENDQ_LIMIT, sendQ);
+    if (key == "ping_interval") return parsePositive(value, MAX_TIMEOUT_LIMIT, pingInterval);
+    if (key == "ping_timeout") return parsePositive(value, MAX_TIMEOUT_LIMIT, pingTimeout);
+    if (key == "register_timeout") return parsePositive(value, MAX_TIMEOUT_LIMIT, registerTimeout);
+    if (key == "stats_interval") return parsePositive(value, MAX_TIMEOUT_LIMIT, statsInterval);
+    if (key == "log_file") {
+        logFile = value;
+        return !value.empty();
+    }
+    if (key == "log_level") return Logger::parseLevel(value, logLevel);
+    return false;
+}
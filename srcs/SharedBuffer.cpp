@@ -0,0 +1,148 @@
+#include "SharedBuffer.hpp"
+
+/**
+ * @brief Construct a new SharedBuffer::Block:: Owned by one reference
+ *
+ * @param src Bytes to keep
+ */
+SharedBuffer::Block::Block(const string& src): refCount(1), data(src) { }
+
+/**
+ * @brief Construct a new SharedBuffer::Block:: Owned by one reference, with no bytes yet
+ *
+ * @param capacity Bytes that can be appended without reallocating
+ */
+SharedBuffer::Block::Block(size_t capacity): refCount(1) {
+    data.reserve(capacity);
+}
+
+/**
+ * @brief Construct a new SharedBuffer:: Empty buffer. Allocates nothing.
+ */
+SharedBuffer::SharedBuffer(void): _block(NULL) { }
+
+/**
+ * @brief Construct a new SharedBuffer:: Copy the bytes once into a new shared block.
+ *
+ * @param data Bytes to share
+ */
+SharedBuffer::SharedBuffer(const string& data): _block(NULL) {
+    if (!data.empty()) _block = new Block(data);
+}
+
+/**
+ * @brief Construct a new SharedBuffer:: Empty buffer to be filled with appendSpace()
+ *
+ * @param capacity Bytes that can be appended without reallocating
+ */
+SharedBuffer::SharedBuffer(size_t capacity): _block(new Block(capacity)) { }
+
+/**
+ * @brief Construct a new SharedBuffer:: Share the block of src
+ *
+ * @param src
+ */
+SharedBuffer::SharedBuffer(const SharedBuffer& src): _block(src._block) {
+    if (_block != NULL) __atomic_fetch_add(&_block->refCount, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Share the block of src instead of the current one.
+ *
+ * @param src
+ * @return SharedBuffer&
+ */
+SharedBuffer& SharedBuffer::operator=(const SharedBuffer& src) {
+    if (_block == src._block) return *this;
+    if (src._block != NULL) __atomic_fetch_add(&src._block->refCount, 1, __ATOMIC_RELAXED);
+    release();
+    _block = src._block;
+    return *this;
+}
+
+/**
+ * @brief Destroy the SharedBuffer:: Free the block with the last reference
+ */
+SharedBuffer::~SharedBuffer() {
+    release();
+}
+
+/**
+ * @brief Drop the reference to the current block.
+ */
+void SharedBuffer::release(void) {
+    if (_block != NULL && __atomic_sub_fetch(&_block->refCount, 1, __ATOMIC_ACQ_REL) == 0) delete _block;
+    _block = NULL;
+}
+
+/**
+ * @brief Get the shared bytes as string
+ *
+ * @return const string& : Shared bytes. Empty string if nothing is shared.
+ */
+const string& SharedBuffer::str(void) const {
+    static const string emptyString;
+
+    if (_block == NULL) return emptyString;
+    return _block->data;
+}
+
+/**
+ * @brief Get pointer to the first byte
+ *
+ * @return const char* : First byte. NULL if empty.
+ */
+const char *SharedBuffer::data(void) const {
+    if (_block == NULL) return NULL;
+    return _block->data.data();
+}
+
+/**
+ * @brief Get number of bytes
+ *
+ * @return size_t : Number of bytes
+ */
+size_t SharedBuffer::size(void) const {
+    if (_block == NULL) return 0;
+    return _block->data.size();
+}
+
+/**
+ * @brief Get the memory of the bytes: what was reserved, used or not.
+ *  It never changes once the buffer is created, since appending stays within it.
+ *
+ * @return size_t : Capacity in bytes
+ */
+size_t SharedBuffer::capacity(void) const {
+    if (_block == NULL) return 0;
+    return _block->data.capacity();
+}
+
+/**
+ * @brief Check that there are no bytes
+ *
+ * @return true : No bytes / if not return
+ * @return false
+ */
+bool SharedBuffer::empty(void) const {
+    return _block == NULL || _block->data.empty();
+}
+
+/**
+ * @brief Grow the buffer by length bytes in place, for the caller to fill.
+ *  Only possible while this is the only reference to the block and the
+ *  reserved capacity is large enough; the existing bytes stay where they are.
+ *
+ * @param length Number of bytes to add
+ * @return char* : Where to write the new bytes. NULL if the buffer cannot grow in place.
+ */
+char *SharedBuffer::appendSpace(size_t length) {
+    if (_block == NULL || __atomic_load_n(&_block->refCount, __ATOMIC_ACQUIRE) != 1) return NULL;
+
+    string& data = _block->data;
+    const size_t oldSize = data.size();
+
+    if (data.capacity() - oldSize < length) return NULL;
+    data.resize(oldSize + length);
+    return &data[oldSize];
+}
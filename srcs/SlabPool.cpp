@@ -0,0 +1,148 @@
+#include <cstdlib>
+#include "SlabPool.hpp"
+
+SlabPool *SlabPool::_allPools = NULL;
+
+/**
+ * @brief Guards the list of all pools. Pools are created during static
+ *  initialization or on first use of a container type, maybe on any thread.
+ */
+static SpinLock registryLock;
+
+/**
+ * @brief Round a size up to a multiple of the strictest fundamental alignment.
+ */
+static size_t alignSize(size_t size) {
+    const size_t alignment = sizeof(void *) * 2;
+
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief Construct a new SlabPool:: Empty pool. No chunk is taken before the first allocate().
+ *
+ * @param name Name shown in the stats
+ * @param blockSize Size of one block. Rounded up so that every block is aligned.
+ * @param blocksPerChunk Number of blocks carved out of one chunk
+ */
+SlabPool::SlabPool(const char *name, size_t blockSize, size_t blocksPerChunk)
+    : _name(name), _blockSize(alignSize(blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize)),
+      _blocksPerChunk(blocksPerChunk), _isBypassed(getenv("IRCSERV_NO_POOL") != NULL),
+      _freeList(NULL), _chunks(NULL), _chunkNum(0), _inUse(0), _peakInUse(0) {
+    ScopedSpinLock lock(registryLock);
+
+    _nextPool = _allPools;
+    _allPools = this;
+}
+
+/**
+ * @brief Destroy the SlabPool:: Give every chunk back. Blocks still in use become invalid.
+ */
+SlabPool::~SlabPool() {
+    {
+        ScopedSpinLock lock(registryLock);
+        SlabPool **link = &_allPools;
+
+        while (*link != NULL && *link != this) link = &(*link)->_nextPool;
+        if (*link != NULL) *link = _nextPool;
+    }
+    while (_chunks != NULL) {
+        Chunk *next = _chunks->next;
+
+        ::operator delete(_chunks);
+        _chunks = next;
+    }
+}
+
+/**
+ * @brief Take a new chunk and put all its blocks on the free list.
+ *  Called with the pool lock held.
+ *
+ * @throw Throw bad_alloc if there is no memory.
+ */
+void SlabPool::addChunk(void) {
+    const size_t headerSize = alignSize(sizeof(Chunk));
+    char *memory = static_cast<char *>(::operator new(headerSize + _blockSize * _blocksPerChunk));
+    Chunk *chunk = reinterpret_cast<Chunk *>(memory);
+
+    chunk->next = _chunks;
+    _chunks = chunk;
+    ++_chunkNum;
+    for (size_t i = _blocksPerChunk; i > 0; --i) {
+        FreeBlock *block = reinterpret_cast<FreeBlock *>(memory + headerSize + _blockSize * (i - 1));
+
+        block->next = _freeList;
+        _freeList = block;
+    }
+}
+
+/**
+ * @brief Get a block. The last freed block is reused first, it is likely still in cache.
+ *
+ * @return void* : Block of at least blockSize bytes
+ * @throw Throw bad_alloc if there is no memory.
+ */
+void *SlabPool::allocate(void) {
+    void *block = _isBypassed ? ::operator new(_blockSize) : NULL;
+    ScopedSpinLock lock(_lock);
+
+    if (block == NULL) {
+        if (_freeList == NULL) addChunk();
+        block = _freeList;
+        _freeList = _freeList->next;
+    }
+    if (++_inUse > _peakInUse) _peakInUse = _inUse;
+    return block;
+}
+
+/**
+ * @brief Give a block back to the pool.
+ *
+ * @param block Block got from allocate() of this pool. NULL is ignored.
+ */
+void SlabPool::deallocate(void *block) {
+    if (block == NULL) return ;
+    if (_isBypassed) ::operator delete(block);
+
+    ScopedSpinLock lock(_lock);
+
+    if (!_isBypassed) {
+        FreeBlock *freeBlock = static_cast<FreeBlock *>(block);
+
+        freeBlock->next = _freeList;
+        _freeList = freeBlock;
+    }
+    --_inUse;
+}
+
+/**
+ * @brief Get occupancy of the pool.
+ *
+ * @return Stats : Chunks taken, blocks carved, blocks in use now and at most.
+ */
+SlabPool::Stats SlabPool::getStats(void) {
+    ScopedSpinLock lock(_lock);
+    Stats stats;
+
+    stats.name = _name;
+    stats.blockSize = _blockSize;
+    stats.chunkNum = _chunkNum;
+    stats.blockNum = _chunkNum * _blocksPerChunk;
+    stats.inUse = _inUse;
+    stats.peakInUse = _peakInUse;
+    return stats;
+}
+
+/**
+ * @brief Get occupancy of every pool of the process.
+ *
+ * @return vector<Stats> : One entry per pool
+ */
+vector<SlabPool::Stats> SlabPool::getAllStats(void) {
+    ScopedSpinLock lock(registryLock);
+    vector<Stats> allStats;
+
+    for (SlabPool *pool = _allPools; pool != NULL; pool = pool->_nextPool)
+        allStats.push_back(pool->getStats());
+    return allStats;
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cstring>
+#include "Stats.hpp"
+
+__thread Stats *Stats::_local = NULL;
+// Counts of threads without a reactor (e.g. benchmarks). Not reported.
+Stats Stats::_unbound;
+
+/**
+ * @brief Construct a new Stats::Snapshot:: All zero
+ */
+Stats::Snapshot::Snapshot(void): sendQBytes(0), sendQPeakBytes(0) {
+    memset(counters, 0, sizeof(counters));
+    memset(commands, 0, sizeof(commands));
+}
+
+/**
+ * @brief Add the values of another snapshot, to sum the reactors.
+ *  The peak send queue is the largest of the two, being one client's.
+ *
+ * @param rhs Snapshot to add
+ * @return Stats::Snapshot& : This snapshot
+ */
+Stats::Snapshot& Stats::Snapshot::operator+=(const Snapshot& rhs) {
+    for (size_t i = 0; i < COUNTER_NUM; ++i) counters[i] += rhs.counters[i];
+    for (size_t i = 0; i <= COMMAND_TABLE_SIZE; ++i) commands[i] += rhs.commands[i];
+    sendQBytes += rhs.sendQBytes;
+    sendQPeakBytes = max(sendQPeakBytes, rhs.sendQPeakBytes);
+    return *this;
+}
+
+/**
+ * @brief Add the histograms of another reactor.
+ *
+ * @param rhs Histograms to add
+ * @return Stats::Latencies& : These histograms
+ */
+Stats::Latencies& Stats::Latencies::operator+=(const Latencies& rhs) {
+    for (size_t i = 0; i < COMMAND_TABLE_SIZE; ++i) commands[i] += rhs.commands[i];
+    event += rhs.event;
+    loopLag += rhs.loopLag;
+    return *this;
+}
+
+/**
+ * @brief Remove the counts of earlier histograms, e.g. those taken at the last reset.
+ *
+ * @param rhs Earlier histograms
+ * @return Stats::Latencies& : These histograms
+ */
+Stats::Latencies& Stats::Latencies::operator-=(const Latencies& rhs) {
+    for (size_t i = 0; i < COMMAND_TABLE_SIZE; ++i) commands[i] -= rhs.commands[i];
+    event -= rhs.event;
+    loopLag -= rhs.loopLag;
+    return *this;
+}
+
+/**
+ * @brief Construct a new Stats:: All zero
+ */
+Stats::Stats(void): _sendQBytes(0), _sendQPeakBytes(0) {
+    memset(_counters, 0, sizeof(_counters));
+    memset(_commands, 0, sizeof(_commands));
+}
+
+/**
+ * @brief Destroy the Stats:: Stats object
+ */
+Stats::~Stats() { }
+
+/**
+ * @brief Read the counters. Callable from any thread.
+ *  Each value is read atomically, but not all at the same instant.
+ *
+ * @return Stats::Snapshot : Values so far
+ */
+Stats::Snapshot Stats::getSnapshot(void) const {
+    Snapshot snapshot;
+
+    for (size_t i = 0; i < COUNTER_NUM; ++i) snapshot.counters[i] = __atomic_load_n(&_counters[i], __ATOMIC_RELAXED);
+    for (size_t i = 0; i <= COMMAND_TABLE_SIZE; ++i) snapshot.commands[i] = __atomic_load_n(&_commands[i], __ATOMIC_RELAXED);
+    snapshot.sendQBytes = __atomic_load_n(&_sendQBytes, __ATOMIC_RELAXED);
+    snapshot.sendQPeakBytes = __atomic_load_n(&_sendQPeakBytes, __ATOMIC_RELAXED);
+    return snapshot;
+}
+
+/**
+ * @brief Add the latency histograms to a sum. Callable from any thread.
+ *
+ * @param latencies Sum to add to
+ */
+void Stats::addLatenciesTo(Latencies& latencies) const {
+    for (size_t i = 0; i < COMMAND_TABLE_SIZE; ++i) _commandLatency[i].addTo(latencies.commands[i]);
+    _eventLatency.addTo(latencies.event);
+    _loopLag.addTo(latencies.loopLag);
+}
+
+/**
+ * @brief Make local() return these counters on the calling thread.
+ *  Called by a reactor when its thread starts.
+ *
+ * @param stats Counters owned by the thread's reactor
+ */
+void Stats::bindToThread(Stats *stats) {
+    _local = stats;
+}
+
+/**
+ * @brief Get the name of a counter, as reported by STATS and the periodic dump.
+ *
+ * @param counter Counter
+ * @return const char* : Name in snake case
+ */
+const char *Stats::getName(Counter counter) {
+    static const char *names[COUNTER_NUM] = {
+        "bytes_in", "bytes_out", "broadcasts", "deliveries", "accepted", "rejected"
+    };
+
+    return names[counter];
+}
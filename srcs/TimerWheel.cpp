@@ -0,0 +1,192 @@
+#include "TimerWheel.hpp"
+#include "CommonValue.hpp"
+
+/**
+ * @brief Construct a new TimerWheel::Timer:: Timer that is not armed
+ */
+TimerWheel::Timer::Timer(void): prev(NULL), next(NULL), expireTick(0), data(NULL) { }
+
+/**
+ * @brief Check that the timer waits in a wheel.
+ *
+ * @return true : Timer is armed / if not return
+ * @return false
+ */
+bool TimerWheel::Timer::isArmed(void) const {
+    return prev != NULL;
+}
+
+/**
+ * @brief Construct a new TimerWheel:: Empty wheel. Tick 0 starts now.
+ *
+ * @param nowMs Current time (Clock::nowMs())
+ */
+TimerWheel::TimerWheel(long nowMs): _startMs(nowMs), _currentTick(0), _size(0) {
+    for (int level = 0; level < LEVEL_NUM; ++level) {
+        for (int slot = 0; slot < SLOT_NUM; ++slot) {
+            _slots[level][slot].prev = &_slots[level][slot];
+            _slots[level][slot].next = &_slots[level][slot];
+        }
+    }
+}
+
+/**
+ * @brief Destroy the TimerWheel:: Timers still armed are left unarmed.
+ */
+TimerWheel::~TimerWheel() {
+    for (int level = 0; level < LEVEL_NUM; ++level) {
+        for (int slot = 0; slot < SLOT_NUM; ++slot) {
+            Timer *head = &_slots[level][slot];
+
+            while (head->next != head) unlink(head->next);
+        }
+    }
+}
+
+/**
+ * @brief Get number of armed timers.
+ *
+ * @return size_t : Armed timers
+ */
+size_t TimerWheel::size(void) const {
+    return _size;
+}
+
+/**
+ * @brief Put a timer in the slot that covers its expiry tick.
+ *  A timer already due goes to the next tick.
+ *
+ * @param timer Unarmed timer with expireTick set
+ */
+void TimerWheel::link(Timer *timer) {
+    long delta = timer->expireTick - _currentTick;
+    int level = 0;
+
+    if (delta <= 0) {
+        timer->expireTick = _currentTick + 1;
+        delta = 1;
+    }
+    while (level < LEVEL_NUM - 1 && delta >= (1L << (SLOT_BITS * (level + 1)))) ++level;
+    // Past the last level: wait in its farthest slot and be placed again on the way.
+    if (delta >= (1L << (SLOT_BITS * LEVEL_NUM)))
+        timer->expireTick = _currentTick + (1L << (SLOT_BITS * LEVEL_NUM)) - 1;
+
+    Timer *head = &_slots[level][(timer->expireTick >> (SLOT_BITS * level)) & (SLOT_NUM - 1)];
+
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+/**
+ * @brief Take a timer out of its slot.
+ *
+ * @param timer Armed timer
+ */
+void TimerWheel::unlink(Timer *timer) {
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->prev = NULL;
+    timer->next = NULL;
+}
+
+/**
+ * @brief Place the timers of the current slot of a level again, now that the
+ *  level below wrapped around. They land on lower levels.
+ *
+ * @param level Level 1 or above
+ */
+void TimerWheel::cascade(int level) {
+    Timer *head = &_slots[level][(_currentTick >> (SLOT_BITS * level)) & (SLOT_NUM - 1)];
+
+    while (head->next != head) {
+        Timer *timer = head->next;
+
+        unlink(timer);
+        link(timer);
+    }
+}
+
+/**
+ * @brief Arm a timer, or move it if it is already armed. O(1).
+ *
+ * @param timer Timer to arm. Must stay alive, or be cancelled, until it expires.
+ * @param expireMs Time to expire at (Clock::nowMs() based)
+ */
+void TimerWheel::arm(Timer *timer, long expireMs) {
+    if (timer->isArmed()) unlink(timer);
+    else ++_size;
+    // Round up, so that the timer never expires early.
+    timer->expireTick = (expireMs - _startMs + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+    link(timer);
+}
+
+/**
+ * @brief Disarm a timer. Does nothing if it is not armed. O(1).
+ *
+ * @param timer Timer to cancel
+ */
+void TimerWheel::cancel(Timer *timer) {
+    if (!timer->isArmed()) return ;
+    unlink(timer);
+    --_size;
+}
+
+/**
+ * @brief Advance the wheel to the current time and take out the timers that expired.
+ *  Expired timers are unarmed, so the handler may arm them again.
+ *
+ * @param nowMs Current time (Clock::nowMs())
+ * @param expired Expired timers are appended to it
+ */
+void TimerWheel::expire(long nowMs, vector<Timer *>& expired) {
+    const long nowTick = (nowMs - _startMs) / TIMER_TICK_MS;
+
+    if (_size == 0) {
+        if (nowTick > _currentTick) _currentTick = nowTick;
+        return ;
+    }
+    while (_currentTick < nowTick) {
+        ++_currentTick;
+        for (int level = 1; level < LEVEL_NUM; ++level) {
+            // The levels below did not all wrap around.
+            if ((_currentTick & ((1L << (SLOT_BITS * level)) - 1)) != 0) break;
+            cascade(level);
+        }
+
+        Timer *head = &_slots[0][_currentTick & (SLOT_NUM - 1)];
+
+        while (head->next != head) {
+            Timer *timer = head->next;
+
+            unlink(timer);
+            --_size;
+            expired.push_back(timer);
+        }
+    }
+}
+
+/**
+ * @brief Get how long the poller may wait before expire() has work to do.
+ *  Looks for the next busy slot of level 0, else waits until level 0 wraps
+ *  around and the level above cascades into it.
+ *
+ * @param nowMs Current time (Clock::nowMs())
+ * @return int : Milliseconds. -1 (no timeout) if no timer is armed.
+ */
+int TimerWheel::getTimeoutMs(long nowMs) const {
+    long tick = _currentTick + 1;
+
+    if (_size == 0) return -1;
+    while ((tick & (SLOT_NUM - 1)) != 0) {
+        const Timer *head = &_slots[0][tick & (SLOT_NUM - 1)];
+
+        if (head->next != head) break;
+        ++tick;
+    }
+
+    const long waitMs = _startMs + tick * TIMER_TICK_MS - nowMs;
+
+    return waitMs > 0 ? static_cast<int>(waitMs) : 0;
+}
@@ -0,0 +1,48 @@
+#include "TokenBucket.hpp"
+
+/**
+ * @brief Construct a new TokenBucket:: Full bucket
+ *
+ * @param burst Number of tokens
+ * @param nowMs Current time (Clock::nowMs())
+ */
+TokenBucket::TokenBucket(int burst, long nowMs): _milliTokens(burst * 1000L), _lastRefillMs(nowMs) { }
+
+/**
+ * @brief Add the tokens earned since the last refill.
+ *
+ * @param nowMs Current time (Clock::nowMs())
+ * @param rate Tokens earned per second
+ * @param burst Most tokens the bucket holds
+ * @return true : A token can be taken / if not return
+ * @return false
+ */
+bool TokenBucket::refill(long nowMs, int rate, int burst) {
+    const long maxMilliTokens = burst * 1000L;
+
+    if (nowMs > _lastRefillMs) {
+        // rate tokens per second is rate thousandths per millisecond
+        _milliTokens += (nowMs - _lastRefillMs) * rate;
+        _lastRefillMs = nowMs;
+    }
+    if (_milliTokens > maxMilliTokens) _milliTokens = maxMilliTokens;
+    return _milliTokens >= 1000;
+}
+
+/**
+ * @brief Spend one token. Check refill() first.
+ */
+void TokenBucket::take(void) {
+    _milliTokens -= 1000;
+}
+
+/**
+ * @brief Get how long until a token can be taken, counted from the last refill.
+ *
+ * @param rate Tokens earned per second
+ * @return long : Milliseconds to wait. 0 if a token is there.
+ */
+long TokenBucket::getWaitMs(int rate) const {
+    if (_milliTokens >= 1000) return 0;
+    return (1000 - _milliTokens + rate - 1) / rate;
+}
@@ -1,15 +1,29 @@
 #include <unistd.h>
+#include <cstring>
+#include <algorithm>
 #include "User.hpp"
 #include "Channel.hpp"
 #include "Message.hpp"
+#include "Reactor.hpp"
+#include "Clock.hpp"
+
+static SlabPool userPool("User", sizeof(User), 256);
+static const string unknownNickname("*");
 
 /**
  * @brief Construct a new User:: User object
  * 
  * @param fd Client socket fd
  * @param host Client host address(ipv4)
+ * @param reactor Reactor that owns the client socket
  */
-User::User(int fd, const string& host) : _fd(fd), _host(host), _auth(false), _isQuiting(false) { }
+User::User(int fd, const string& host, Reactor *reactor)
+    : _fd(fd), _reactor(reactor), _host(host), _auth(false), _floodBucket(UNREGISTERED_FLOOD_BURST, Clock::nowMs()),
+      _lastActiveMs(Clock::nowMs()), _pingSentMs(0), _isQuiting(false), _isClosed(false), _isWriteArmed(false), _isThrottled(false),
+      _isSendQExceeded(false) {
+    _timer.data = this;
+    updatePrefix();
+}
 
 /**
  * @brief Destroy the User:: Close client socket fd
@@ -18,6 +32,30 @@ User::~User() {
     close(_fd);
 }
 
+/**
+ * @brief Allocate a user from the user slab pool, so reconnect storms reuse
+ *  the memory of disconnected users instead of fragmenting the heap.
+ * 
+ * @param size Size of the object. A derived class bigger than User goes to the heap.
+ * @return void* : Memory for the user
+ * @throw bad_alloc if there is no memory.
+ */
+void *User::operator new(size_t size) {
+    if (size != sizeof(User)) return ::operator new(size);
+    return userPool.allocate();
+}
+
+/**
+ * @brief Give the memory of a user back to the user slab pool.
+ * 
+ * @param ptr Memory got from User::operator new
+ * @param size Size of the object
+ */
+void User::operator delete(void *ptr, size_t size) {
+    if (size != sizeof(User)) ::operator delete(ptr);
+    else userPool.deallocate(ptr);
+}
+
 /**
  * @brief Get client socket fd
  * 
@@ -27,6 +65,15 @@ int User::getFd(void) const {
     return _fd;
 }
 
+/**
+ * @brief Get the reactor that owns the client socket and buffers.
+ * 
+ * @return Reactor* : Owning reactor
+ */
+Reactor* User::getReactor(void) const {
+    return _reactor;
+}
+
 /**
  * @brief Get client host address.
  * 
@@ -49,26 +96,41 @@ const string& User::getPassword(void) const {
 /**
  * @brief Get user nickname.
  * 
- * @return const string : Nickname of user.
+ * @return const string& : Nickname of user.
  *  Returns "*" if it is before the client set on a nickname. This can only happen before authentication.
  */
-const string User::getNickname(void) const {
-    if (_nickname.empty()) return "*";
+const string& User::getNickname(void) const {
+    if (_nickname.empty()) return unknownNickname;
     
     return _nickname;
 }
 
 /**
- * @brief Get user source.
+ * @brief Get the prefix of messages sent by this user. Built once per NICK/USER change,
+ *  so that every relayed message can reference it instead of building it.
  * 
- * @return const string : "<nickname>@<host_addr>"
+ * @return const string& : ":<nickname>!<username>@<host_addr>". "!<username>" is left out before USER.
  */
-const string User::getSource(void) const {
-    string source = getNickname();
-    if (source.empty()) source = "*";
-    source = source + "@" + _host;
+const string& User::getPrefix(void) const {
+    return _prefix;
+}
 
-    return source;
+/**
+ * @brief Rebuild the cached prefix from nickname, username and host.
+ */
+void User::updatePrefix(void) {
+    const string& nickname = getNickname();
+
+    _prefix.clear();
+    _prefix.reserve(nickname.length() + _username.length() + _host.length() + 3);
+    _prefix += ':';
+    _prefix += nickname;
+    if (!_username.empty()) {
+        _prefix += '!';
+        _prefix += _username;
+    }
+    _prefix += '@';
+    _prefix += _host;
 }
 
 /**
@@ -93,20 +155,58 @@ bool User::getAuth(void) const {
 /**
  * @brief Gets the cmd buffer for that user.
  *  The cmd buffer is a message sent by that user to the server.
+ *  The reactor receives into it and cuts lines out of it.
  * 
- * @return const string& : Contents of cmd buffer
+ * @return InputBuffer& : cmd buffer
  */
-const string& User::getCmdBuffer(void) const {
+InputBuffer& User::getCmdBuffer(void) {
     return _cmdBuffer;
 }
 
+/**
+ * @brief Gets the flood control bucket of that user. One token is spent per command line.
+ * 
+ * @return TokenBucket& : Flood control bucket
+ */
+TokenBucket& User::getFloodBucket(void) {
+    return _floodBucket;
+}
+
+/**
+ * @brief Gets the keepalive timer of that user, armed in the timer wheel of its reactor.
+ * 
+ * @return TimerWheel::Timer& : Keepalive timer. Its data is the user.
+ */
+TimerWheel::Timer& User::getTimer(void) {
+    return _timer;
+}
+
+/**
+ * @brief Get when the client last sent anything.
+ * 
+ * @return long : Time of the last received bytes (Clock::nowMs())
+ */
+long User::getLastActiveMs(void) const {
+    return _lastActiveMs;
+}
+
+/**
+ * @brief Get when the server sent the PING that waits for an answer.
+ * 
+ * @return long : Time the PING was sent (Clock::nowMs()). 0 if no PING is waiting.
+ */
+long User::getPingSentMs(void) const {
+    return _pingSentMs;
+}
+
 /**
  * @brief Gets the reply buffer for that user.
  *  The reply buffer is a message that the server will send to the user.
+ *  Each segment is one serialized reply, possibly shared with other users.
  * 
- * @return const string& : Contents of reply buffer
+ * @return const OutputQueue& : Contents of reply buffer
  */
-const string& User::getReplyBuffer(void) const {
+const OutputQueue& User::getReplyBuffer(void) const {
     return _replyBuffer;
 }
 
@@ -129,6 +229,49 @@ bool User::getIsQuiting(void) const {
     return _isQuiting;
 }
 
+/**
+ * @brief Verify that the user was disconnected and waits for deletion by its reactor.
+ *  Events for it still in the current event batch must be ignored.
+ * 
+ * @return true User is disconnected / if not return
+ * @return false 
+ */
+bool User::getIsClosed(void) const {
+    return _isClosed;
+}
+
+/**
+ * @brief Verify that the reactor waits for the client socket to become writable.
+ * 
+ * @return true Write readiness of the socket is watched / if not return
+ * @return false 
+ */
+bool User::getIsWriteArmed(void) const {
+    return _isWriteArmed;
+}
+
+/**
+ * @brief Verify that the user ran out of flood tokens. Its remaining lines wait
+ *  in the cmd buffer, and its socket is not read until they are handled.
+ * 
+ * @return true Commands of the user are deferred / if not return
+ * @return false 
+ */
+bool User::getIsThrottled(void) const {
+    return _isThrottled;
+}
+
+/**
+ * @brief Verify that the unsent replies of the user went over its send queue limit.
+ *  Its reply buffer was dropped, and its reactor disconnects it.
+ * 
+ * @return true User is a slow consumer waiting for eviction / if not return
+ * @return false 
+ */
+bool User::getIsSendQExceeded(void) const {
+    return _isSendQExceeded;
+}
+
 /**
  * @brief Record the password that the user passed by the PASS command.
  * The actual verification process takes place after NICK, USER commands are processed.
@@ -146,6 +289,7 @@ void User::setPassword(const string& pwd) {
  */
 void User::setNickname(const string& nickname) {
     _nickname = nickname;
+    updatePrefix();
 }
 
 /**
@@ -155,6 +299,7 @@ void User::setNickname(const string& nickname) {
  */
 void User::setUsername(const string& username) {
     _username = username;
+    updatePrefix();
 }
 
 /**
@@ -164,15 +309,6 @@ void User::setAuth(void) {
     _auth = true;
 }
 
-/**
- * @brief Replace the cmd buffer with the given string value.
- * 
- * @param str 
- */
-void User::setCmdBuffer(const string& str) {
-    _cmdBuffer = str;
-}
-
 /**
  * @brief Empty the cmd buffer of the user
  */
@@ -186,7 +322,8 @@ void User::clearCmdBuffer(void) {
  * @param str 
  */
 void User::setReplyBuffer(const string& str) {
-    _replyBuffer = str;
+    _replyBuffer.clear();
+    addToReplyBuffer(str);
 }
 
 /**
@@ -195,7 +332,7 @@ void User::setReplyBuffer(const string& str) {
  * @param msg 
  */
 void User::setReplyBuffer(const Message& msg) {
-    _replyBuffer = msg.createReplyForm();
+    setReplyBuffer(msg.createReplyForm());
 }
 
 /**
@@ -206,21 +343,23 @@ void User::clearReplyBuffer(void) {
 }
 
 /**
- * @brief Adds the given string after the existing cmd buffer.
+ * @brief Send the reply buffer to the client socket with a single writev().
+ *  Sent bytes are removed from the reply buffer.
  * 
- * @param str 
+ * @return ssize_t : Number of bytes sent. ERR_RETURN(-1) on failure with errno set.
  */
-void User::addToCmdBuffer(const string& str) {
-    _cmdBuffer.append(str);
+ssize_t User::sendReplyBuffer(void) {
+    return _replyBuffer.writeTo(_fd);
 }
 
 /**
  * @brief Adds the given string after the existing reply buffer.
+ *  Called from another reactor thread, the string is handed over to the owning reactor instead.
  * 
  * @param str 
  */
 void User::addToReplyBuffer(const string& str) {
-    _replyBuffer.append(str);
+    addToReplyBuffer(SharedBuffer(str));
 }
 
 /**
@@ -230,20 +369,143 @@ void User::addToReplyBuffer(const string& str) {
  * @param msg 
  */
 void User::addToReplyBuffer(const Message& msg) {
-    _replyBuffer.append(msg.createReplyForm());
+    addToReplyBuffer(SharedBuffer(msg.createReplyForm()));
+}
+
+/**
+ * @brief Adds an already serialized reply after the existing reply buffer without copying it.
+ *  Called from another reactor thread, the reply is handed over to the owning reactor instead.
+ * 
+ * @param reply 
+ */
+void User::addToReplyBuffer(const SharedBuffer& reply) {
+    if (reply.empty()) return ;
+    if (_reactor != NULL && !_reactor->isCurrentThread()) {
+        _reactor->post(this, reply);
+        return ;
+    }
+
+    if (_isSendQExceeded) return ;
+
+    const bool wasEmpty = _replyBuffer.empty();
+
+    _replyBuffer.push(reply);
+    if (wasEmpty && _reactor != NULL) _reactor->requestFlush(this);
+    checkSendQ();
+}
+
+/**
+ * @brief Adds a reply given in pieces, serialized straight into the reply buffer
+ *  with no intermediate string. Called from another reactor thread, the pieces
+ *  are joined into a SharedBuffer and handed over to the owning reactor instead.
+ * 
+ * @param pieces Parts of the reply, in order. The last one must end with CR/LF.
+ * @param count Number of pieces
+ */
+void User::addToReplyBuffer(const StringView *pieces, size_t count) {
+    size_t length = 0;
+
+    for (size_t i = 0; i < count; ++i) length += pieces[i].length();
+    if (length == 0) return ;
+    if (_reactor != NULL && !_reactor->isCurrentThread()) {
+        string reply;
+
+        reply.reserve(length);
+        for (size_t i = 0; i < count; ++i) reply.append(pieces[i].data(), pieces[i].length());
+        _reactor->post(this, SharedBuffer(reply));
+        return ;
+    }
+
+    if (_isSendQExceeded) return ;
+
+    const bool wasEmpty = _replyBuffer.empty();
+    char *writePos = _replyBuffer.appendSpace(length);
+
+    for (size_t i = 0; i < count; ++i) {
+        memcpy(writePos, pieces[i].data(), pieces[i].length());
+        writePos += pieces[i].length();
+    }
+    if (wasEmpty && _reactor != NULL) _reactor->requestFlush(this);
+    checkSendQ();
+}
+
+/**
+ * @brief Adds a numeric reply to this user: <head><nickname>[ param1][ param2]<text>[trailing]\r\n
+ *  Empty params are left out.
+ * 
+ * @param reply Template of the reply
+ * @param param1 First param after the nickname
+ * @param param2 Second param after the nickname
+ * @param trailing Bytes after the text of the template
+ */
+void User::addNumericReply(const NumericReply& reply, const StringView& param1, const StringView& param2, const StringView& trailing) {
+    const StringView space(" ", 1);
+    StringView pieces[9];
+    size_t count = 0;
+
+    pieces[count++] = StringView(reply.head, reply.headLength);
+    pieces[count++] = getNickname();
+    if (!param1.empty()) {
+        pieces[count++] = space;
+        pieces[count++] = param1;
+    }
+    if (!param2.empty()) {
+        pieces[count++] = space;
+        pieces[count++] = param2;
+    }
+    pieces[count++] = StringView(reply.text, reply.textLength);
+    pieces[count++] = trailing;
+    pieces[count++] = StringView("\r\n", 2);
+    addToReplyBuffer(pieces, count);
+}
+
+/**
+ * @brief Add the pre-serialized replies of a burst, with the nickname filled in,
+ *  in one reservation of the reply buffer.
+ *
+ * @param burst Replies serialized once for all users (see Server::getWelcomeBurst())
+ */
+void User::addReplyBurst(const ReplyBurst& burst) {
+    StringView pieces[ReplyBurst::MAX_REPLY_NUM * 2 + 1];
+    size_t count = 0;
+
+    for (size_t i = 0; i < burst.getReplyNum(); ++i) {
+        pieces[count++] = burst.getPiece(i);
+        pieces[count++] = getNickname();
+    }
+    pieces[count++] = burst.getPiece(burst.getReplyNum());
+    addToReplyBuffer(pieces, count);
+}
+
+/**
+ * @brief Drop the reply buffer if the memory it holds (see OutputQueue::size()) went over
+ *  the send queue limit of the user's class,
+ *  and have the reactor disconnect the user ("SendQ exceeded") at the end of the loop iteration.
+ *  Replies added afterwards are ignored.
+ */
+void User::checkSendQ(void) {
+    if (_reactor == NULL || _replyBuffer.size() <= _reactor->getSendQLimit(_auth)) return ;
+    _replyBuffer.clear();
+    _isSendQExceeded = true;
+    _reactor->requestFlush(this);
 }
 
 /**
  * @brief When user enter a new channel, add it to the user's channel list.
+ *  The list holds a reference to the channel (see Channel::release()).
  * 
  * @param channel : Pointer of the participating channel instance
  */
 void User::addToMyChannelList(Channel *channel) {
+    if (find(_myChannelList.begin(), _myChannelList.end(), channel) != _myChannelList.end()) return ;
+
     _myChannelList.push_back(channel);
+    channel->retain();
 }
 
 /**
  * @brief When user leave a channel, delete it from the channel list for that user.
+ *  The channel must not be used after this call.
  * 
  * @param channel : Pointer of the channel instance that left
  */
@@ -253,27 +515,43 @@ void User::deleteFromMyChannelList(Channel *channel) {
     if (it == _myChannelList.end()) return ;
 
     _myChannelList.erase(it);
+    channel->release();
 }
 
 /**
  * @brief Empty the list of channels to which the user belongs.
  */
 void User::clearMyChannelList(void) {
-    _myChannelList.clear();
+    vector<Channel *> channels;
+
+    channels.swap(_myChannelList);
+    for (vector<Channel *>::iterator it = channels.begin(); it != channels.end(); ++it) (*it)->release();
 }
 
 /**
  * @brief Send messages to the channels to which the user belongs.
+ *  Channels the user was kicked from since are dropped from the list first.
  * 
  * @param msg Message to send
  * @param ignoreFd Client socket fd not to be sent. Own fd are set as the default parameter.
+ * @return true : The user is still on a channel / if not return
+ * @return false 
  */
-void User::broadcastToMyChannels(const Message& msg, const int ignoreFd) const {
-    const vector<Channel *>& chs = getMyAllChannel();
-
-	for (vector<Channel *>::const_iterator it = chs.begin(); it != chs.end(); ++it) {
-		(*it)->broadcast(msg, ignoreFd);
+bool User::broadcastToMyChannels(const Message& msg, const int ignoreFd) {
+    for (size_t i = _myChannelList.size(); i > 0; --i) {
+        Channel *channel = _myChannelList[i - 1];
+
+        if (channel->findUser(_fd) == this) continue;
+        _myChannelList.erase(_myChannelList.begin() + (i - 1));
+        channel->release();
+    }
+    if (_myChannelList.empty()) return false;
+
+    const SharedBuffer reply(msg.createReplyForm());
+	for (vector<Channel *>::const_iterator it = _myChannelList.begin(); it != _myChannelList.end(); ++it) {
+		(*it)->broadcast(reply, ignoreFd);
 	}
+    return true;
 }
 
 /**
@@ -283,3 +561,46 @@ void User::broadcastToMyChannels(const Message& msg, const int ignoreFd) const {
 void User::setIsQuiting(void) {
     _isQuiting = true;
 }
+
+/**
+ * @brief Indicates that the user was disconnected. Set by its reactor.
+ */
+void User::setIsClosed(void) {
+    _isClosed = true;
+}
+
+/**
+ * @brief Record whether the reactor watches write readiness of the client socket.
+ * 
+ * @param isWriteArmed 
+ */
+void User::setIsWriteArmed(bool isWriteArmed) {
+    _isWriteArmed = isWriteArmed;
+}
+
+/**
+ * @brief Record whether commands of the user are deferred by flood control.
+ * 
+ * @param isThrottled true when the user ran out of flood tokens
+ */
+void User::setIsThrottled(bool isThrottled) {
+    _isThrottled = isThrottled;
+}
+
+/**
+ * @brief Record that the client sent something, so it is alive.
+ * 
+ * @param nowMs Current time (Clock::nowMs())
+ */
+void User::setLastActiveMs(long nowMs) {
+    _lastActiveMs = nowMs;
+}
+
+/**
+ * @brief Record that a keepalive PING was sent to the client.
+ * 
+ * @param nowMs Current time (Clock::nowMs()). 0 when no PING waits for an answer anymore.
+ */
+void User::setPingSentMs(long nowMs) {
+    _pingSentMs = nowMs;
+}
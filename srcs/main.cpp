@@ -1,5 +1,7 @@
 #include <iostream>
+#include <csignal>
 #include "Server.hpp"
+#include "Logger.hpp"
 
 using namespace std;
 
@@ -15,21 +17,35 @@ int validatePort(char *portString) {
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        cerr << "Usage: ./server <port> <password>\n";
+    if (argc < 3) {
+        cerr << "Usage: ./server <port> <password> [threads=<n>] [max_users=<n>] [max_channels=<n>] [max_events=<n>] [flood_rate=<n>] [flood_burst=<n>] [sendq=<n>] [ping_interval=<n>] [ping_timeout=<n>] [register_timeout=<n>] [stats_interval=<n>] [log_file=<path>] [log_level=<level>]\n";
         exit(EXIT_FAILURE);
     }
 
-    int port = validatePort(argv[1]);
-    Server ircServer(port, argv[2]);
+    ServerConfig config;
+    config.port = validatePort(argv[1]);
+    config.password = argv[2];
+    for (int i = 3; i < argc; ++i) {
+        if (!config.parseOption(argv[i])) {
+            cerr << "Invalid option: " << argv[i] << "\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (!Logger::start(config.logFile, config.logLevel)) {
+        cerr << "Cannot open log file: " << config.logFile << "\n";
+        exit(EXIT_FAILURE);
+    }
+    // A peer closing its socket must not kill the server on the next send().
+    signal(SIGPIPE, SIG_IGN);
+    Server ircServer(config);
 
-    cout << "Server created" << endl;
+    Logger::log(Logger::INFO, "server created port=%d", config.port);
     try {
         ircServer.run();    
     } catch(exception &e) {
         e.what();
         ircServer.shutDown("Error while running server");
     }
-
+    Logger::stop();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,188 @@
+#pragma once
+
+#ifndef TESTUTIL_HPP
+# define TESTUTIL_HPP
+
+# include <iostream>
+# include <string>
+# include <cstdlib>
+# include <cstring>
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <arpa/inet.h>
+# include <poll.h>
+# include <unistd.h>
+# include <fcntl.h>
+
+# include "Server.hpp"
+# include "User.hpp"
+# include "Message.hpp"
+# include "Clock.hpp"
+
+using namespace std;
+
+/**
+ * @brief Helpers of the tests. A test is one program, run by "make test",
+ *  that exits with 1 if a CHECK failed.
+ */
+
+static int failedCheckNum = 0;
+
+# define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << endl; \
+            ++failedCheckNum; \
+        } \
+    } while (0)
+
+/**
+ * @brief Registered user with no reactor, whose socket is one end of a socketpair.
+ *  Its replies are read from the other end.
+ */
+struct TestUser {
+    User *user;
+    int peerFd;
+};
+
+/**
+ * @brief Create a registered user known to the server.
+ */
+inline TestUser addTestUser(Server& server, const string& nickname) {
+    TestUser testUser;
+    int fds[2];
+
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    testUser.user = new User(fds[0], "test.host", NULL);
+    testUser.peerFd = fds[1];
+    server.reserveClient();
+    server.renameClient(testUser.user, nickname);
+    testUser.user->setUsername(nickname);
+    testUser.user->setAuth();
+    return testUser;
+}
+
+/**
+ * @brief Send the queued replies of a user and read them back.
+ *
+ * @return string : Every reply queued since the last call
+ */
+inline string takeReplies(const TestUser& testUser) {
+    string replies;
+    char buffer[4096];
+    ssize_t length;
+
+    while (!testUser.user->getReplyBuffer().empty() && testUser.user->sendReplyBuffer() > 0) ;
+    while ((length = read(testUser.peerFd, buffer, sizeof(buffer))) > 0) replies.append(buffer, length);
+    return replies;
+}
+
+/**
+ * @brief Parse a line as a client message and run it as the user.
+ */
+inline void runCommand(Server& server, const TestUser& testUser, const string& line) {
+    const Message msg(line);
+
+    server.executeCommand(testUser.user, msg);
+}
+
+/**
+ * @brief Count the lines of replies.
+ */
+inline size_t countLines(const string& replies) {
+    size_t count = 0;
+
+    for (size_t i = 0; i < replies.size(); ++i) count += replies[i] == '\n';
+    return count;
+}
+
+/**
+ * @brief Ask the kernel for a free port.
+ *
+ * @return int : Port number that was free a moment ago
+ */
+inline int findFreePort(void) {
+    struct sockaddr_in addr;
+    socklen_t addrLength = sizeof(addr);
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    getsockname(fd, (struct sockaddr*)&addr, &addrLength);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+/**
+ * @brief Thread body running the loop of a test server.
+ *
+ * @param arg Server to run
+ */
+inline void *serverMain(void *arg) {
+    static_cast<Server *>(arg)->run();
+    return NULL;
+}
+
+/**
+ * @brief Connect a client socket to the test server.
+ *
+ * @param port Port of the server
+ * @param receiveBufferSize SO_RCVBUF of the client, 0 for the default
+ * @return int : Client socket
+ */
+inline int connectClient(int port, int receiveBufferSize) {
+    struct sockaddr_in addr;
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (receiveBufferSize > 0)
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        cerr << "cannot connect to the test server" << endl;
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+/**
+ * @brief Send one line with its CRLF from a client socket.
+ */
+inline void sendLine(int fd, const string& line) {
+    const string data = line + "\r\n";
+
+    send(fd, data.data(), data.length(), MSG_NOSIGNAL);
+}
+
+/**
+ * @brief Read the socket until the received bytes contain a marker.
+ *
+ * @param fd Client socket
+ * @param marker Bytes to wait for
+ * @param received Bytes read so far, appended to
+ * @param waitMs Longest wait
+ * @return true : The marker came
+ * @return false : Timeout, or the connection was closed first
+ */
+inline bool readUntil(int fd, const string& marker, string& received, long waitMs) {
+    const long deadlineMs = Clock::nowMs() + waitMs;
+    char buffer[65536];
+
+    while (received.find(marker) == string::npos) {
+        const long leftMs = deadlineMs - Clock::nowMs();
+        struct pollfd pollFd = { fd, POLLIN, 0 };
+
+        if (leftMs <= 0 || poll(&pollFd, 1, leftMs) <= 0) return false;
+        const ssize_t length = recv(fd, buffer, sizeof(buffer), 0);
+        if (length <= 0) return false;
+        received.append(buffer, length);
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,168 @@
+#include <cstring>
+#include <cctype>
+#include "TestUtil.hpp"
+#include "Channel.hpp"
+#include "Command.hpp"
+#include "CaseMappedMap.hpp"
+
+/**
+ * @brief Commands run without sockets, as users with no reactor.
+ *  usage : ./tests/command_test
+ */
+
+/**
+ * @brief KICK with fewer than 2 params only gets ERR_NEEDMOREPARAMS,
+ *  and kicks nobody.
+ */
+static void testKickWithoutParams(Server& server, const TestUser& alice, const TestUser& bob) {
+    Channel *general = server.findChannelByName(string("#general"));
+
+    runCommand(server, alice, "KICK");
+
+    string replies = takeReplies(alice);
+
+    CHECK(countLines(replies) == 1);
+    CHECK(replies.find(" 461 alice KICK :") != string::npos);
+
+    runCommand(server, alice, "KICK #general");
+    replies = takeReplies(alice);
+    CHECK(countLines(replies) == 1);
+    CHECK(replies.find(" 461 alice KICK :") != string::npos);
+    CHECK(general->findUser(bob.user->getFd()) != NULL);
+    CHECK(takeReplies(bob).empty());
+}
+
+/**
+ * @brief KICK with both params removes the member and tells the channel.
+ */
+static void testKick(Server& server, const TestUser& alice, const TestUser& bob) {
+    Channel *general = server.findChannelByName(string("#general"));
+
+    runCommand(server, alice, "KICK #general bob");
+    CHECK(general->findUser(bob.user->getFd()) == NULL);
+    CHECK(takeReplies(bob).find(" KICK #general bob") != string::npos);
+}
+
+/**
+ * @brief Every command of the dispatch table is found at its own slot,
+ *  in any case, and shorter or unknown commands at none.
+ */
+static void testDispatchTable(void) {
+    for (size_t slot = 0; slot < COMMAND_TABLE_SIZE; ++slot) {
+        const char *name = Command::getName(slot);
+
+        if (name == NULL) continue;
+
+        string lowerName(name);
+
+        for (size_t i = 0; i < lowerName.length(); ++i) lowerName[i] = tolower(lowerName[i]);
+        CHECK(Command::getSlot(StringView(name, strlen(name))) == slot);
+        CHECK(Command::getSlot(StringView(lowerName.data(), lowerName.length())) == slot);
+    }
+    CHECK(Command::getSlot(StringView("PIN", 3)) == COMMAND_TABLE_SIZE);
+    CHECK(Command::getSlot(StringView("PINGS", 5)) == COMMAND_TABLE_SIZE);
+    CHECK(Command::getSlot(StringView("KILL", 4)) == COMMAND_TABLE_SIZE);
+}
+
+/**
+ * @brief Commands sent in lower or mixed case are run like upper case ones.
+ */
+static void testMixedCaseCommands(Server& server, const TestUser& alice, const TestUser& bob) {
+    runCommand(server, bob, "Join #mixed");
+    CHECK(takeReplies(bob).find(" JOIN :#mixed") != string::npos);
+    runCommand(server, alice, "privmsg bob :hello");
+    CHECK(takeReplies(bob).find(":alice!alice@test.host PRIVMSG bob :hello") != string::npos);
+    CHECK(takeReplies(alice).empty());
+    runCommand(server, alice, "PrivMsg #mixed :hi");
+    CHECK(takeReplies(bob).find(" PRIVMSG #mixed :hi") != string::npos);
+}
+
+/**
+ * @brief Names are keys under the RFC 1459 case mapping: letters and
+ *  "[]\~" fold to "{}|^", and a name is kept in the case it was added with.
+ */
+static void testCaseMappedMap(void) {
+    CaseMappedMap<int> map;
+    string storedName;
+
+    CHECK(map.insert(StringView("Nick[a]\\~"), 1));
+    CHECK(!map.insert(StringView("nick{A}|^"), 2));
+    CHECK(map.size() == 1);
+    CHECK(map.find(StringView("NICK{a}|^"), storedName) == 1);
+    CHECK(storedName == "Nick[a]\\~");
+    CHECK(map.find(StringView("nick[a]\\~")) == 1);
+    CHECK(map.find(StringView("nick(a)\\~")) == 0);
+    CHECK(map.insert(StringView("other"), 3));
+    CHECK(map.erase(StringView("NICK{A}|^")));
+    CHECK(map.find(StringView("Nick[a]\\~")) == 0);
+    CHECK(map.find(StringView("OTHER")) == 3);
+}
+
+/**
+ * @brief A nickname taken in another case, or with "[]\" for "{}|",
+ *  gets ERR_NICKNAMEINUSE, and is found in any case as its owner wrote it.
+ */
+static void testNicknameInUseIgnoresCase(Server& server, const TestUser& alice, const TestUser& bob) {
+    string storedNickname;
+
+    runCommand(server, alice, "NICK foo");
+    takeReplies(alice);
+    runCommand(server, bob, "NICK FOO");
+    CHECK(takeReplies(bob).find(" 433 bob FOO :") != string::npos);
+    CHECK(server.findClientByNickname(StringView("bob")) == bob.user);
+
+    runCommand(server, alice, "NICK a[b]|c");
+    takeReplies(alice);
+    runCommand(server, bob, "NICK A{B}\\C");
+    CHECK(takeReplies(bob).find(" 433 bob A{B}\\C :") != string::npos);
+    CHECK(server.findClientByNickname(StringView("a{b}\\c"), storedNickname) == alice.user);
+    CHECK(storedNickname == "a[b]|c");
+    CHECK(server.findClientByNickname(StringView("foo")) == NULL);
+
+    runCommand(server, alice, "NICK alice");
+    takeReplies(alice);
+    takeReplies(bob);
+    CHECK(server.findClientByNickname(StringView("ALICE")) == alice.user);
+}
+
+/**
+ * @brief Channel names fold like nicknames: joining "#Chan{1}\X" joins "#chan[1]|x".
+ */
+static void testChannelNameIgnoresCase(Server& server, const TestUser& alice, const TestUser& bob) {
+    runCommand(server, alice, "JOIN #chan[1]|x");
+    takeReplies(alice);
+
+    Channel *channel = server.findChannelByName(StringView("#chan[1]|x"));
+
+    CHECK(channel != NULL);
+    CHECK(server.findChannelByName(StringView("#CHAN{1}\\X")) == channel);
+    runCommand(server, bob, "JOIN #Chan{1}\\X");
+    CHECK(takeReplies(alice).find(":bob!bob@test.host JOIN :#chan[1]|x") != string::npos);
+    CHECK(channel->findUser(bob.user->getFd()) != NULL);
+    takeReplies(bob);
+}
+
+int main(void) {
+    ServerConfig config;
+
+    config.port = 0;
+    config.password = "test";
+
+    Server server(config);
+    const TestUser alice = addTestUser(server, "alice");
+    const TestUser bob = addTestUser(server, "bob");
+
+    runCommand(server, alice, "JOIN #general");
+    runCommand(server, bob, "JOIN #general");
+    takeReplies(alice);
+    takeReplies(bob);
+
+    testDispatchTable();
+    testMixedCaseCommands(server, alice, bob);
+    testCaseMappedMap();
+    testNicknameInUseIgnoresCase(server, alice, bob);
+    testChannelNameIgnoresCase(server, alice, bob);
+    testKickWithoutParams(server, alice, bob);
+    testKick(server, alice, bob);
+    return failedCheckNum == 0 ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#include <cstdio>
+#include <csignal>
+#include <pthread.h>
+#include "TestUtil.hpp"
+#include "ServerConfig.hpp"
+#include "Clock.hpp"
+
+/**
+ * @brief A server loop on a loopback port, with a client sending faster
+ *  than its flood limit.
+ *  usage : ./tests/flood_test
+ */
+
+static const int TEST_FLOOD_RATE = 500;
+static const int TEST_FLOOD_BURST = 10;
+// More bytes than one read of the input buffer takes, so some lines wait in the socket.
+static const int TEST_PING_NUM = 1000;
+static const long TEST_TIMEOUT_MS = 10000;
+
+/**
+ * @brief Token of the n-th PING, echoed back by its PONG.
+ */
+static string makeToken(int sequence) {
+    char token[32];
+
+    snprintf(token, sizeof(token), "seq%06d", sequence);
+    return token;
+}
+
+/**
+ * @brief A burst of PINGs far over flood_burst is throttled, not dropped:
+ *  the lines left in the buffer are put back and run when tokens come back,
+ *  and the socket is read again after them. Every PING is answered exactly
+ *  once and in order, no faster than flood_rate allows.
+ */
+static void testBurstAnsweredInOrder(int port) {
+    const int fd = connectClient(port, 0);
+    const string pong = " PONG " SERVER_HOSTNAME " ";
+    string burst;
+    string received;
+
+    sendLine(fd, "PASS test");
+    sendLine(fd, "NICK flooder");
+    sendLine(fd, "USER flooder 0 * :flooder");
+    CHECK(readUntil(fd, " 001 flooder", received, TEST_TIMEOUT_MS));
+
+    for (int i = 0; i < TEST_PING_NUM; ++i) burst += "PING " + makeToken(i) + "\r\n";
+    CHECK(burst.length() > INPUT_BUFFER_SIZE);
+
+    const long startMs = Clock::nowMs();
+
+    received.clear();
+    send(fd, burst.data(), burst.length(), MSG_NOSIGNAL);
+    CHECK(readUntil(fd, pong + makeToken(TEST_PING_NUM - 1) + "\r\n", received, TEST_TIMEOUT_MS));
+
+    const long elapsedMs = Clock::nowMs() - startMs;
+
+    // Tokens come back at flood_rate once the burst is spent.
+    CHECK(elapsedMs >= (TEST_PING_NUM - TEST_FLOOD_BURST) * 1000L / TEST_FLOOD_RATE * 9 / 10);
+
+    size_t pos = 0;
+    int pongNum = 0;
+
+    while ((pos = received.find(pong, pos)) != string::npos) {
+        pos += pong.length();
+        CHECK(received.compare(pos, 9, makeToken(pongNum)) == 0);
+        ++pongNum;
+    }
+    CHECK(pongNum == TEST_PING_NUM);
+
+    // Nothing more is answered afterwards.
+    received.clear();
+    sendLine(fd, "PING last");
+    CHECK(readUntil(fd, pong + "last\r\n", received, TEST_TIMEOUT_MS));
+    CHECK(received == ":" SERVER_HOSTNAME + pong + "last\r\n");
+    close(fd);
+}
+
+int main(void) {
+    ServerConfig config;
+    pthread_t serverThread;
+
+    signal(SIGPIPE, SIG_IGN);
+    config.port = findFreePort();
+    config.password = "test";
+    config.reactorNum = 1;
+    config.floodRate = TEST_FLOOD_RATE;
+    config.floodBurst = TEST_FLOOD_BURST;
+
+    Server server(config);
+    pthread_create(&serverThread, NULL, serverMain, &server);
+
+    testBurstAnsweredInOrder(config.port);
+
+    server.stopReactors();
+    pthread_join(serverThread, NULL);
+    return failedCheckNum == 0 ? 0 : 1;
+}
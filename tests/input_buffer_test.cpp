@@ -0,0 +1,133 @@
+#include <cstring>
+#include "TestUtil.hpp"
+#include "InputBuffer.hpp"
+
+/**
+ * @brief Lines framed out of received bytes, without sockets.
+ *  usage : ./tests/input_buffer_test
+ */
+
+/**
+ * @brief Append bytes as if recv() had written them.
+ */
+static void receive(InputBuffer& buffer, const string& bytes) {
+    size_t writableBytes;
+    char *space = buffer.prepareWrite(writableBytes);
+
+    CHECK(writableBytes >= bytes.length());
+    memcpy(space, bytes.data(), bytes.length());
+    buffer.commitWrite(bytes.length());
+}
+
+/**
+ * @brief Cut the next line.
+ *
+ * @return string : The line, or "" if nextLine() returned another status than expected
+ */
+static string takeLine(InputBuffer& buffer, InputBuffer::Status expected) {
+    const char *line = NULL;
+    size_t length = 0;
+    const InputBuffer::Status status = buffer.nextLine(line, length);
+
+    CHECK(status == expected);
+    if (status != expected || status != InputBuffer::LINE) return "";
+    return string(line, length);
+}
+
+/**
+ * @brief A line cut over two reads is handed out once, whole.
+ */
+static void testLineSplitAcrossReads(void) {
+    InputBuffer buffer;
+
+    receive(buffer, "PRIVMSG #a :hel");
+    takeLine(buffer, InputBuffer::NO_LINE);
+    receive(buffer, "lo\r");
+    CHECK(takeLine(buffer, InputBuffer::LINE) == "PRIVMSG #a :hello");
+    receive(buffer, "\nPING x\r\n");
+    CHECK(takeLine(buffer, InputBuffer::LINE) == "PING x");
+    takeLine(buffer, InputBuffer::NO_LINE);
+    CHECK(buffer.empty());
+}
+
+/**
+ * @brief A bare CR or a bare LF ends a line as CRLF does, and empty lines are skipped.
+ */
+static void testBareTerminators(void) {
+    InputBuffer buffer;
+
+    receive(buffer, "NICK a\rUSER a 0 * :a\nJOIN #a\r\n\r\n\n\rPART #a\n");
+    CHECK(takeLine(buffer, InputBuffer::LINE) == "NICK a");
+    CHECK(takeLine(buffer, InputBuffer::LINE) == "USER a 0 * :a");
+    CHECK(takeLine(buffer, InputBuffer::LINE) == "JOIN #a");
+    CHECK(takeLine(buffer, InputBuffer::LINE) == "PART #a");
+    takeLine(buffer, InputBuffer::NO_LINE);
+}
+
+/**
+ * @brief A line of exactly MAX_MESSAGE_LEN bytes with its CRLF is cut,
+ *  one byte more is dropped, and the next line is cut again.
+ */
+static void testMaxLengthLine(void) {
+    InputBuffer buffer;
+    const string longest = "PRIVMSG #a :" + string(MAX_MESSAGE_LEN - 2 - 12, 'x');
+
+    CHECK(longest.length() + 2 == MAX_MESSAGE_LEN);
+    receive(buffer, longest);
+    takeLine(buffer, InputBuffer::NO_LINE);
+    receive(buffer, "\r\n");
+    CHECK(takeLine(buffer, InputBuffer::LINE) == longest);
+
+    receive(buffer, longest + "y\r\nPING x\r\n");
+    takeLine(buffer, InputBuffer::LINE_TOO_LONG);
+    CHECK(takeLine(buffer, InputBuffer::LINE) == "PING x");
+}
+
+/**
+ * @brief A line going over the limit before its terminator came is reported
+ *  once, the rest of it is dropped over the next reads, and the line after
+ *  its terminator is cut.
+ */
+static void testOverLongLineDiscarded(void) {
+    InputBuffer buffer;
+
+    receive(buffer, string(MAX_MESSAGE_LEN, 'x'));
+    takeLine(buffer, InputBuffer::LINE_TOO_LONG);
+    CHECK(buffer.empty());
+    receive(buffer, string(MAX_MESSAGE_LEN, 'x'));
+    takeLine(buffer, InputBuffer::NO_LINE);
+    CHECK(buffer.empty());
+    receive(buffer, "xx\r\nPING x\r\n");
+    CHECK(takeLine(buffer, InputBuffer::LINE) == "PING x");
+    takeLine(buffer, InputBuffer::NO_LINE);
+}
+
+/**
+ * @brief A line put back when the flood token ran out is cut again first,
+ *  even after more bytes were read in between, and only once.
+ */
+static void testUngetLineAfterThrottle(void) {
+    InputBuffer buffer;
+    const char *line = NULL;
+    size_t length = 0;
+
+    receive(buffer, "PING 1\r\nPING 2\r\nPING 3");
+    CHECK(takeLine(buffer, InputBuffer::LINE) == "PING 1");
+    CHECK(buffer.nextLine(line, length) == InputBuffer::LINE);
+    CHECK(string(line, length) == "PING 2");
+    buffer.ungetLine(line, length);
+    receive(buffer, "\r\nPING 4\r\n");
+    CHECK(takeLine(buffer, InputBuffer::LINE) == "PING 2");
+    CHECK(takeLine(buffer, InputBuffer::LINE) == "PING 3");
+    CHECK(takeLine(buffer, InputBuffer::LINE) == "PING 4");
+    takeLine(buffer, InputBuffer::NO_LINE);
+}
+
+int main(void) {
+    testLineSplitAcrossReads();
+    testBareTerminators();
+    testMaxLengthLine();
+    testOverLongLineDiscarded();
+    testUngetLineAfterThrottle();
+    return failedCheckNum == 0 ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+#include "TestUtil.hpp"
+
+/**
+ * @brief Messages parsed from lines and serialized back, without sockets.
+ *  usage : ./tests/message_test
+ */
+
+/**
+ * @brief Serialize a parsed message back into a line the way replies are
+ *  built: the prefix, the command, the middle params, and the last param
+ *  after a single ":".
+ */
+static string serialize(const Message& msg) {
+    Message reply;
+
+    if (!msg.getPrefix().empty()) reply << ":" << msg.getPrefix();
+    reply << msg.getCommand();
+    for (size_t i = 0; i < msg.paramSize(); ++i) {
+        if (i + 1 == msg.paramSize()) reply << ":";
+        reply << msg.getParams()[i];
+    }
+    return reply.createReplyForm();
+}
+
+/**
+ * @brief Check that two parsed messages have the same prefix, command and params.
+ */
+static bool isSameMessage(const Message& lhs, const Message& rhs) {
+    if (lhs.getPrefix() != rhs.getPrefix() || lhs.getCommand() != rhs.getCommand()) return false;
+    if (lhs.paramSize() != rhs.paramSize()) return false;
+    for (size_t i = 0; i < lhs.paramSize(); ++i) {
+        if (lhs.getParams()[i] != rhs.getParams()[i]) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse a line, serialize it, and check the result is the expected
+ *  line, parses to the same message, and serializes to itself again.
+ */
+static void checkRoundTrip(const string& line, const string& expected) {
+    const Message msg(line);
+    const string serialized = serialize(msg);
+    const Message reparsed(serialized.substr(0, serialized.length() - 2));
+
+    CHECK(serialized == expected + "\r\n");
+    CHECK(isSameMessage(msg, reparsed));
+    CHECK(serialize(reparsed) == serialized);
+}
+
+/**
+ * @brief A line with only a prefix has no command and no params.
+ */
+static void testPrefixOnly(void) {
+    const Message msg(string(":alice!alice@host"));
+
+    CHECK(msg.getPrefix() == "alice!alice@host");
+    CHECK(msg.getCommand().empty());
+    CHECK(msg.paramSize() == 0);
+    checkRoundTrip(":alice!alice@host", ":alice!alice@host");
+    checkRoundTrip(":alice   ", ":alice");
+}
+
+/**
+ * @brief The 15th param takes the rest of the line, spaces included, even without ':'.
+ */
+static void testMoreThanMaxParams(void) {
+    const string line = "CMD 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16  17 :18";
+    const Message msg(line);
+
+    CHECK(msg.paramSize() == MAX_MESSAGE_PARAMS);
+    CHECK(msg.getParams()[13] == "14");
+    CHECK(msg.getParams()[MAX_MESSAGE_PARAMS - 1] == "15 16  17 :18");
+    checkRoundTrip(line, "CMD 1 2 3 4 5 6 7 8 9 10 11 12 13 14 :15 16  17 :18");
+}
+
+/**
+ * @brief A trailing ':' gives an empty last param, and one followed by spaces
+ *  gives a last param of those spaces. Both are kept, not dropped.
+ */
+static void testEmptyTrailing(void) {
+    const Message empty(string("PRIVMSG #a :"));
+    const Message spaces(string("PRIVMSG #a :   "));
+
+    CHECK(empty.paramSize() == 2);
+    CHECK(empty.getParams()[1].empty());
+    CHECK(spaces.paramSize() == 2);
+    CHECK(spaces.getParams()[1] == "   ");
+    checkRoundTrip("PRIVMSG #a :", "PRIVMSG #a :");
+    checkRoundTrip("PRIVMSG #a :   ", "PRIVMSG #a :   ");
+    checkRoundTrip("TOPIC :", "TOPIC :");
+}
+
+/**
+ * @brief Runs of spaces separate params like one space, except in the trailing param.
+ */
+static void testMultipleSpaces(void) {
+    const Message msg(string("  PRIVMSG   #a,#b    :hi   there  "));
+
+    CHECK(msg.getCommand() == "PRIVMSG");
+    CHECK(msg.paramSize() == 2);
+    CHECK(msg.getParams()[0] == "#a,#b");
+    CHECK(msg.getParams()[1] == "hi   there  ");
+    checkRoundTrip("  PRIVMSG   #a,#b    :hi   there  ", "PRIVMSG #a,#b :hi   there  ");
+    checkRoundTrip("MODE  #a   +o    bob  ", "MODE #a +o :bob");
+}
+
+/**
+ * @brief An empty param is dropped from a built reply only where it would
+ *  not be the trailing one: the params after it are still separated.
+ */
+static void testEmptyParamsInReply(void) {
+    CHECK((Message() << "NOTICE" << "" << "bob" << ":" << "hi").createReplyForm() == "NOTICE bob :hi\r\n");
+    CHECK((Message() << "NOTICE" << "bob" << ":" << "").createReplyForm() == "NOTICE bob :\r\n");
+}
+
+int main(void) {
+    testPrefixOnly();
+    testMoreThanMaxParams();
+    testEmptyTrailing();
+    testMultipleSpaces();
+    testEmptyParamsInReply();
+    return failedCheckNum == 0 ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#include <cstdlib>
+#include <csignal>
+#include <pthread.h>
+#include "TestUtil.hpp"
+#include "ServerConfig.hpp"
+#include "Clock.hpp"
+
+/**
+ * @brief A server loop on a loopback port, with real clients.
+ *  usage : ./tests/sendq_test
+ */
+
+static const int TEST_SENDQ = 65536;
+static const long TEST_TIMEOUT_MS = 10000;
+
+/**
+ * @brief Register a client and join #t.
+ *
+ * @return int : Client socket, past the end of the NAMES list
+ */
+static int joinClient(int port, const string& nickname, int receiveBufferSize) {
+    const int fd = connectClient(port, receiveBufferSize);
+    string received;
+
+    sendLine(fd, "PASS test");
+    sendLine(fd, "NICK " + nickname);
+    sendLine(fd, "USER " + nickname + " 0 * :" + nickname);
+    sendLine(fd, "JOIN #t");
+    CHECK(readUntil(fd, " 366 " + nickname, received, TEST_TIMEOUT_MS));
+    return fd;
+}
+
+/**
+ * @brief Read the value of a STATS t line.
+ */
+static size_t getStatsValue(const string& report, const string& name) {
+    const size_t pos = report.find(":" + name + " ");
+
+    if (pos == string::npos) return 0;
+    return strtoul(report.c_str() + pos + name.length() + 2, NULL, 10);
+}
+
+/**
+ * @brief Ask STATS t until sendq_bytes is below a limit.
+ *
+ * @return true : It went below the limit before the timeout
+ */
+static bool waitForSendQBelow(int fd, const string& nickname, size_t limit) {
+    const long deadlineMs = Clock::nowMs() + TEST_TIMEOUT_MS;
+
+    while (Clock::nowMs() < deadlineMs) {
+        string received;
+
+        sendLine(fd, "STATS t");
+        if (!readUntil(fd, " 219 " + nickname, received, TEST_TIMEOUT_MS)) return false;
+        if (getStatsValue(received, "sendq_bytes") < limit) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief A member that stops reading while the channel keeps talking is
+ *  disconnected ("SendQ exceeded") as soon as its unsent replies hold more
+ *  than the sendq option, and its queue never grows past one more reply.
+ *  The queued bytes summed over the reactors drop once it is gone.
+ */
+static void testSlowReaderEvicted(int port) {
+    const int slowFd = joinClient(port, "slow", 4096);
+    const int talkerFd = joinClient(port, "talker", 0);
+    const string text(400, 'x');
+    const long deadlineMs = Clock::nowMs() + TEST_TIMEOUT_MS;
+    string received;
+    bool isEvicted = false;
+
+    // Enough lines to fill the kernel buffers of the slow member many times.
+    while (!isEvicted && Clock::nowMs() < deadlineMs) {
+        for (int i = 0; i < 100; ++i)
+            sendLine(talkerFd, "PRIVMSG #t :" + text);
+        isEvicted = readUntil(talkerFd, "SendQ exceeded", received, 1);
+    }
+    CHECK(isEvicted);
+    CHECK(received.find(":slow!slow@127.0.0.1 QUIT :SendQ exceeded") != string::npos);
+
+    // The slow member gets what the kernel held, then the end of the connection.
+    char buffer[65536];
+    ssize_t length;
+    while ((length = recv(slowFd, buffer, sizeof(buffer), 0)) > 0) { }
+    CHECK(length == 0);
+
+    received.clear();
+    sendLine(talkerFd, "STATS t");
+    CHECK(readUntil(talkerFd, " 219 talker", received, TEST_TIMEOUT_MS));
+    const size_t peak = getStatsValue(received, "sendq_peak_bytes");
+    CHECK(peak > static_cast<size_t>(TEST_SENDQ));
+    CHECK(peak <= static_cast<size_t>(TEST_SENDQ) + MAX_MESSAGE_LEN);
+    CHECK(waitForSendQBelow(talkerFd, "talker", TEST_SENDQ));
+    close(slowFd);
+    close(talkerFd);
+}
+
+int main(void) {
+    ServerConfig config;
+    pthread_t serverThread;
+
+    signal(SIGPIPE, SIG_IGN);
+    config.port = findFreePort();
+    config.password = "test";
+    config.reactorNum = 2;
+    config.floodRate = MAX_FLOOD_LIMIT;
+    config.floodBurst = MAX_FLOOD_LIMIT;
+    config.sendQ = TEST_SENDQ;
+
+    Server server(config);
+    pthread_create(&serverThread, NULL, serverMain, &server);
+
+    testSlowReaderEvicted(config.port);
+
+    server.stopReactors();
+    pthread_join(serverThread, NULL);
+    return failedCheckNum == 0 ? 0 : 1;
+}